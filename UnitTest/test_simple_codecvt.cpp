@@ -10,8 +10,12 @@
 #include <scodecvt/simple_codecvt.h>
 
 #include <chrono>
+#include <clocale>
+#include <memory_resource>
+#include <sstream>
 
 using namespace std::string_literals;
+using namespace std::string_view_literals;
 
 const std::string multistr2 = "你a好bc";
 const std::wstring widestr1 = L"你a好b😀c";
@@ -23,6 +27,22 @@ const std::u16string u16str2 = u"你a好bc";
 const std::u32string u32str1 = U"你a好b😀c";
 const std::u32string u32str2 = U"你a好bc";
 
+template <typename CharType>
+static std::basic_string<CharType> repeat(std::basic_string_view<CharType> text, std::size_t count)
+{
+	std::basic_string<CharType> str;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		str += text;
+	}
+	return str;
+}
+
+// Long enough, and mixed enough, to run through the vectorized paths.
+const std::u8string u8str3 = repeat<char8_t>(u8"你a好b😀cabcdefghijklmnopqrstuvwxyzéèêëàâôûабвгдежз你好世界你好世界", 64);
+const std::u16string u16str3 = repeat<char16_t>(u"你a好b😀cabcdefghijklmnopqrstuvwxyzéèêëàâôûабвгдежз你好世界你好世界", 64);
+const std::u32string u32str3 = repeat<char32_t>(U"你a好b😀cabcdefghijklmnopqrstuvwxyzéèêëàâôûабвгдежз你好世界你好世界", 64);
+
 BOOST_AUTO_TEST_CASE(to_utf8_from_string)
 {
 	auto str = simple_codecvt::to_utf8(multistr2);
@@ -67,6 +87,20 @@ BOOST_AUTO_TEST_CASE(to_utf8_from_u16string)
 	BOOST_TEST((str == u8str1));
 }
 
+BOOST_AUTO_TEST_CASE(to_utf8_from_u16string_endian)
+{
+	auto swapped = simple_codecvt::change_endian_copy(u16str3);
+	BOOST_TEST((simple_codecvt::to_utf8(u16str3) == u8str3));
+	BOOST_TEST((simple_codecvt::to_utf8(swapped, !simple_codecvt::is_big_endian()) == u8str3));
+}
+
+BOOST_AUTO_TEST_CASE(to_utf8_from_u16string_invalid)
+{
+	BOOST_CHECK_THROW(simple_codecvt::to_utf8(u"abc\xD800"s), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf8(u"abc\xDC00" u"def"s), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf8(u"\xD83D\x0041"s), std::invalid_argument);
+}
+
 #if defined _MSC_VER &&  !defined _DEBUG
 BOOST_AUTO_TEST_CASE(to_utf8_from_u16string_speed)
 {
@@ -95,6 +129,15 @@ BOOST_AUTO_TEST_CASE(to_utf8_from_u32string)
 	BOOST_TEST((str == u8str1));
 }
 
+BOOST_AUTO_TEST_CASE(to_utf8_from_u32string_endian)
+{
+	auto swapped = simple_codecvt::change_endian_copy(u32str3);
+	BOOST_TEST((simple_codecvt::to_utf8(u32str3) == u8str3));
+	BOOST_TEST((simple_codecvt::to_utf8(swapped, !simple_codecvt::is_big_endian()) == u8str3));
+	BOOST_CHECK_THROW(simple_codecvt::to_utf8(U"abc\xD800"s), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf8(U"abc\x110000"s), std::invalid_argument);
+}
+
 #if defined _MSC_VER &&  !defined _DEBUG
 BOOST_AUTO_TEST_CASE(to_utf8_from_u32string_speed)
 {
@@ -176,6 +219,33 @@ BOOST_AUTO_TEST_CASE(to_utf16_from_u8string)
 	BOOST_TEST((str == u16str1));
 }
 
+BOOST_AUTO_TEST_CASE(to_utf16_from_u8string_endian)
+{
+	BOOST_TEST((simple_codecvt::to_utf16(u8str3) == u16str3));
+	BOOST_TEST((simple_codecvt::to_utf16(u8str3, !simple_codecvt::is_big_endian()) == simple_codecvt::change_endian_copy(u16str3)));
+}
+
+BOOST_AUTO_TEST_CASE(to_utf16_from_u8string_invalid)
+{
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(u8"abc\xC0\xAF"sv), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(u8"abc\xED\xA0\x80"sv), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(u8"abc\xE4\xBD"sv), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(u8"\xF4\x90\x80\x80"sv), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(u8"\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80"sv), std::invalid_argument);
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(u8"abc\xF0\x9F\x98"sv), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(exact_output_length)
+{
+	BOOST_TEST((simple_codecvt::to_utf16(u8str3).size() == u16str3.size()));
+	BOOST_TEST((simple_codecvt::to_utf32(u8str3).size() == u32str3.size()));
+	BOOST_TEST((simple_codecvt::to_utf8(u16str3).size() == u8str3.size()));
+	BOOST_TEST((simple_codecvt::to_utf32(u16str3).size() == u32str3.size()));
+	BOOST_TEST((simple_codecvt::to_utf8(u32str3).size() == u8str3.size()));
+	BOOST_TEST((simple_codecvt::to_utf16(u32str3).size() == u16str3.size()));
+	BOOST_TEST((simple_codecvt::to_utf8(std::u16string_view()).empty()));
+}
+
 #if defined _MSC_VER &&  !defined _DEBUG
 BOOST_AUTO_TEST_CASE(to_utf16_from_u8string_speed)
 {
@@ -203,6 +273,17 @@ BOOST_AUTO_TEST_CASE(to_utf16_from_u32string)
 	BOOST_TEST((str == u16str1));
 }
 
+BOOST_AUTO_TEST_CASE(to_utf16_from_u32string_endian)
+{
+	const auto be = simple_codecvt::is_big_endian();
+	auto u32swapped = simple_codecvt::change_endian_copy(u32str3);
+	auto u16swapped = simple_codecvt::change_endian_copy(u16str3);
+	BOOST_TEST((simple_codecvt::to_utf16(u32str3, be, !be) == u16swapped));
+	BOOST_TEST((simple_codecvt::to_utf16(u32swapped, !be, be) == u16str3));
+	BOOST_TEST((simple_codecvt::to_utf16(u32swapped, !be, !be) == u16swapped));
+	BOOST_CHECK_THROW(simple_codecvt::to_utf16(U"abc\xDFFF"s), std::invalid_argument);
+}
+
 #if defined _MSC_VER &&  !defined _DEBUG
 BOOST_AUTO_TEST_CASE(to_utf16_from_u32string_speed)
 {
@@ -296,6 +377,13 @@ BOOST_AUTO_TEST_CASE(to_utf32_from_u8string)
 	BOOST_TEST((str == u32str1));
 }
 
+BOOST_AUTO_TEST_CASE(to_utf32_from_u8string_endian)
+{
+	BOOST_TEST((simple_codecvt::to_utf32(u8str3) == u32str3));
+	BOOST_TEST((simple_codecvt::to_utf32(u8str3, !simple_codecvt::is_big_endian()) == simple_codecvt::change_endian_copy(u32str3)));
+	BOOST_CHECK_THROW(simple_codecvt::to_utf32(u8"abc\xE0\x80\x80"sv), std::invalid_argument);
+}
+
 #if defined _MSC_VER &&  !defined _DEBUG
 BOOST_AUTO_TEST_CASE(to_utf32_from_u8string_speed)
 {
@@ -323,6 +411,17 @@ BOOST_AUTO_TEST_CASE(to_utf32_from_u16string)
 	BOOST_TEST((str == u32str1));
 }
 
+BOOST_AUTO_TEST_CASE(to_utf32_from_u16string_endian)
+{
+	const auto be = simple_codecvt::is_big_endian();
+	auto u32swapped = simple_codecvt::change_endian_copy(u32str3);
+	auto u16swapped = simple_codecvt::change_endian_copy(u16str3);
+	BOOST_TEST((simple_codecvt::to_utf32(u16str3, be, !be) == u32swapped));
+	BOOST_TEST((simple_codecvt::to_utf32(u16swapped, !be, be) == u32str3));
+	BOOST_TEST((simple_codecvt::to_utf32(u16swapped, !be, !be) == u32swapped));
+	BOOST_CHECK_THROW(simple_codecvt::to_utf32(u"abc\xD800"s), std::invalid_argument);
+}
+
 #if defined _MSC_VER &&  !defined _DEBUG
 BOOST_AUTO_TEST_CASE(to_utf32_from_u16string_speed)
 {
@@ -357,6 +456,12 @@ BOOST_AUTO_TEST_CASE(to_utf32_from_u16string_speed)
 }
 #endif
 
+BOOST_AUTO_TEST_CASE(to_string_from_wstring_long)
+{
+	const auto widestr3 = repeat<wchar_t>(widestr2, 1000);
+	BOOST_TEST((simple_codecvt::to_wstring(simple_codecvt::to_string(widestr3)) == widestr3));
+}
+
 BOOST_AUTO_TEST_CASE(to_string_from_wstring)
 {
 	auto str = simple_codecvt::to_string(widestr2);
@@ -542,3 +647,640 @@ BOOST_AUTO_TEST_CASE(to_wstring_from_u32string_speed)
 	}
 }
 #endif
+
+BOOST_AUTO_TEST_CASE(byte_order)
+{
+	static_assert(simple_codecvt::is_big_endian() == (std::endian::native == std::endian::big));
+	const auto be16 = simple_codecvt::to_big_endian_copy(u"A"sv);
+	const auto le16 = simple_codecvt::to_little_endian(u"A"sv);
+	BOOST_TEST((reinterpret_cast<const unsigned char *>(be16.data())[1] == 'A'));
+	BOOST_TEST((reinterpret_cast<const unsigned char *>(le16.data())[0] == 'A'));
+	const auto be32 = simple_codecvt::to_big_endian_copy(U"A"sv);
+	BOOST_TEST((reinterpret_cast<const unsigned char *>(be32.data())[3] == 'A'));
+	BOOST_TEST((simple_codecvt::to_utf8(be16, true) == u8"A"));
+	BOOST_TEST((simple_codecvt::to_utf8(le16, false) == u8"A"));
+}
+
+BOOST_AUTO_TEST_CASE(change_endian_lengths)
+{
+	for (std::size_t n = 0; n < 80; ++n)
+	{
+		const auto u16 = u16str3.substr(n, n);
+		const auto u32 = u32str3.substr(n, n);
+		std::u16string u16ref;
+		std::u32string u32ref;
+		for (auto ch : u16)
+		{
+			u16ref.push_back(static_cast<char16_t>((ch << 8) | (ch >> 8)));
+		}
+		for (auto ch : u32)
+		{
+			u32ref.push_back(((ch & 0xFF) << 24) | ((ch & 0xFF00) << 8) | ((ch >> 8) & 0xFF00) | (ch >> 24));
+		}
+		BOOST_TEST((simple_codecvt::change_endian_copy(u16) == u16ref));
+		BOOST_TEST((simple_codecvt::change_endian_copy(u32) == u32ref));
+		auto u16str = u16;
+		auto u32str = u32;
+		simple_codecvt::change_endian(u16str.data());
+		simple_codecvt::change_endian(u32str.data());
+		BOOST_TEST((u16str == u16ref));
+		BOOST_TEST((u32str == u32ref));
+		simple_codecvt::change_endian(u16str);
+		simple_codecvt::change_endian(u32str);
+		BOOST_TEST((u16str == u16));
+		BOOST_TEST((u32str == u32));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(append_and_assign)
+{
+	std::u8string u8buf = u8"前缀";
+	simple_codecvt::append_utf8(u8buf, u16str1);
+	BOOST_TEST((u8buf == u8"前缀" + u8str1));
+	simple_codecvt::append_utf8(u8buf, u32str2);
+	BOOST_TEST((u8buf == u8"前缀" + u8str1 + u8str2));
+	BOOST_CHECK_THROW(simple_codecvt::append_utf8(u8buf, u"abc\xD800"sv), std::invalid_argument);
+	BOOST_TEST((u8buf == u8"前缀" + u8str1 + u8str2));
+
+	std::u16string u16buf;
+	simple_codecvt::assign_utf16(u16buf, u8str3);
+	BOOST_TEST((u16buf == u16str3));
+	const auto capacity = u16buf.capacity();
+	const auto data = u16buf.data();
+	simple_codecvt::assign_utf16(u16buf, u8str1);
+	BOOST_TEST((u16buf == u16str1));
+	BOOST_TEST((u16buf.capacity() == capacity));
+	BOOST_TEST((u16buf.data() == data));
+
+	std::u32string u32buf = U"x";
+	simple_codecvt::append_utf32(u32buf, u16str3, simple_codecvt::is_big_endian(), !simple_codecvt::is_big_endian());
+	BOOST_TEST((u32buf.substr(1) == simple_codecvt::change_endian_copy(u32str3)));
+
+	std::wstring widebuf = L"x";
+	simple_codecvt::assign_wstring(widebuf, u8str1);
+	BOOST_TEST((widebuf == widestr1));
+}
+
+BOOST_AUTO_TEST_CASE(append_and_assign_string)
+{
+	std::string multibuf;
+	simple_codecvt::append_string(multibuf, widestr2);
+	simple_codecvt::append_string(multibuf, u8str2);
+	BOOST_TEST((multibuf == multistr2 + multistr2));
+	simple_codecvt::assign_string(multibuf, u16str2);
+	BOOST_TEST((multibuf == multistr2));
+
+	std::wstring widebuf;
+	simple_codecvt::assign_wstring(widebuf, multistr2);
+	BOOST_TEST((widebuf == widestr2));
+}
+
+BOOST_AUTO_TEST_CASE(convert_into_buffer)
+{
+	std::u16string u16buf(simple_codecvt::required_size<char16_t>(u8str3), 0);
+	auto rst = simple_codecvt::convert_into(u8str3, std::span(u16buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((rst.read == u8str3.size()));
+	BOOST_TEST((rst.written == u16str3.size()));
+	BOOST_TEST((u16buf == u16str3));
+
+	auto u32swapped = simple_codecvt::change_endian_copy(u32str3);
+	std::u8string u8buf(simple_codecvt::required_size<char8_t>(u32swapped, !simple_codecvt::is_big_endian()), 0);
+	rst = simple_codecvt::convert_into(u32swapped, std::span(u8buf), !simple_codecvt::is_big_endian());
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((u8buf == u8str3));
+
+	std::u32string u32buf(simple_codecvt::required_size<char32_t>(u16str3), 0);
+	rst = simple_codecvt::convert_into(u16str3, std::span(u32buf), simple_codecvt::is_big_endian(), !simple_codecvt::is_big_endian());
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((u32buf == simple_codecvt::change_endian_copy(u32str3)));
+
+	std::wstring widebuf(simple_codecvt::required_size<wchar_t>(u8str1), 0);
+	rst = simple_codecvt::convert_into(u8str1, std::span(widebuf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((widebuf == widestr1));
+}
+
+BOOST_AUTO_TEST_CASE(convert_into_output_full)
+{
+	char16_t buf[4];
+	auto rst = simple_codecvt::convert_into(u8str1, std::span(buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::output_full));
+	BOOST_TEST((rst.read == 8));
+	BOOST_TEST((rst.written == 4));
+	BOOST_TEST((std::u16string_view(buf, 4) == u16str1.substr(0, 4)));
+
+	rst = simple_codecvt::convert_into(u8str1.substr(rst.read), std::span(buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((std::u16string_view(buf, rst.written) == u16str1.substr(4)));
+
+	char8_t u8buf[4];
+	rst = simple_codecvt::convert_into(U"a😀"sv, std::span(u8buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::output_full));
+	BOOST_TEST((rst.read == 1));
+	BOOST_TEST((rst.written == 1));
+}
+
+BOOST_AUTO_TEST_CASE(convert_into_invalid)
+{
+	char16_t buf[16];
+	auto rst = simple_codecvt::convert_into(u8"abc\xC0\xAF" u8"def"sv, std::span(buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::invalid_input));
+	BOOST_TEST((rst.read == 3));
+	BOOST_TEST((rst.written == 3));
+
+	char8_t u8buf[16];
+	rst = simple_codecvt::convert_into(u"ab\xD800"sv, std::span(u8buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::invalid_input));
+	BOOST_TEST((rst.read == 2));
+}
+
+BOOST_AUTO_TEST_CASE(convert_into_string)
+{
+	std::string multibuf(simple_codecvt::required_size<char>(widestr2), 0);
+	auto rst = simple_codecvt::convert_into(widestr2, std::span(multibuf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((multibuf == multistr2));
+
+	std::u8string u8buf(simple_codecvt::required_size<char8_t>(multistr2), 0);
+	rst = simple_codecvt::convert_into(multistr2, std::span(u8buf));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((u8buf == u8str2));
+}
+
+BOOST_AUTO_TEST_CASE(stream_converter_chunks)
+{
+	for (std::size_t step = 1; step <= 7; ++step)
+	{
+		simple_codecvt::stream_converter<char8_t, char16_t> u8tou16;
+		std::u16string u16buf;
+		for (std::size_t i = 0; i < u8str3.size(); i += step)
+		{
+			u8tou16.feed(std::u8string_view(u8str3).substr(i, step), u16buf);
+		}
+		u8tou16.finish();
+		BOOST_TEST((u16buf == u16str3));
+
+		simple_codecvt::stream_converter<char16_t, char8_t> u16tou8(!simple_codecvt::is_big_endian());
+		const auto u16swapped = simple_codecvt::change_endian_copy(u16str3);
+		std::u8string u8buf;
+		for (std::size_t i = 0; i < u16swapped.size(); i += step)
+		{
+			u8buf += u16tou8.feed(std::u16string_view(u16swapped).substr(i, step));
+		}
+		u16tou8.finish();
+		BOOST_TEST((u8buf == u8str3));
+	}
+
+	simple_codecvt::stream_converter<char32_t, wchar_t> u32towide;
+	std::wstring widebuf;
+	u32towide.feed(std::u32string_view(u32str1).substr(0, 3), widebuf);
+	u32towide.feed(std::u32string_view(u32str1).substr(3), widebuf);
+	u32towide.finish();
+	BOOST_TEST((widebuf == widestr1));
+}
+
+BOOST_AUTO_TEST_CASE(stream_converter_invalid)
+{
+	simple_codecvt::stream_converter<char8_t, char32_t> u8tou32;
+	std::u32string u32buf;
+	u8tou32.feed(u8"ab\xF0\x9F"sv, u32buf);
+	BOOST_TEST((u32buf == U"ab"s));
+	BOOST_CHECK_THROW(u8tou32.finish(), std::invalid_argument);
+	BOOST_CHECK_NO_THROW(u8tou32.finish());
+
+	u8tou32.feed(u8"\xE4"sv, u32buf);
+	BOOST_CHECK_THROW(u8tou32.feed(u8"a"sv, u32buf), std::invalid_argument);
+	BOOST_CHECK_THROW(u8tou32.feed(u8"a\xFF"sv, u32buf), std::invalid_argument);
+	BOOST_TEST((u32buf == U"ab"s));
+
+	simple_codecvt::stream_converter<char16_t, char8_t> u16tou8;
+	BOOST_TEST((u16tou8.feed(u"a\xD83D"sv) == u8"a"s));
+	BOOST_CHECK_THROW(u16tou8.feed(u"\xD83D"sv), std::invalid_argument);
+	u16tou8.reset();
+	BOOST_TEST((u16tou8.feed(u"\xD83D"sv).empty()));
+	BOOST_TEST((u16tou8.feed(u"\xDE00"sv) == u8"😀"s));
+}
+
+template <typename CharType>
+static std::string as_bytes(const std::basic_string<CharType> &text)
+{
+	return std::string(reinterpret_cast<const char *>(text.data()), text.size() * sizeof(CharType));
+}
+
+BOOST_AUTO_TEST_CASE(transcoding_streambuf_input)
+{
+	const bool be = simple_codecvt::is_big_endian();
+	std::stringbuf file(as_bytes(simple_codecvt::change_endian_copy(u16str3)));
+	simple_codecvt::transcoding_streambuf tsb(&file, be ? simple_codecvt::encoding::utf16le : simple_codecvt::encoding::utf16be, simple_codecvt::encoding::utf8, 16);
+	std::istream in(&tsb);
+	std::ostringstream out;
+	out << in.rdbuf();
+	BOOST_TEST((out.str() == as_bytes(u8str3)));
+
+	std::stringbuf bad(as_bytes(u8"abc\xE4\xBD"s));
+	simple_codecvt::transcoding_streambuf tsb2(&bad, simple_codecvt::encoding::utf8, be ? simple_codecvt::encoding::utf32be : simple_codecvt::encoding::utf32le);
+	std::istream in2(&tsb2);
+	in2.exceptions(std::ios::badbit);
+	char32_t ch;
+	BOOST_CHECK_NO_THROW(in2.read(reinterpret_cast<char *>(&ch), sizeof(ch)));
+	BOOST_TEST((ch == U'a'));
+	BOOST_CHECK_THROW(in2.ignore(100), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(transcoding_streambuf_output)
+{
+	std::stringbuf file;
+	{
+		simple_codecvt::transcoding_streambuf tsb(&file, simple_codecvt::encoding::utf16be, simple_codecvt::encoding::utf8, 16);
+		std::ostream out(&tsb);
+		const auto bytes = as_bytes(u8str3);
+		for (std::size_t i = 0; i < bytes.size(); i += 5)
+		{
+			out << std::string_view(bytes).substr(i, 5);
+		}
+		out.flush();
+		BOOST_TEST((file.str() == as_bytes(simple_codecvt::to_utf16(u8str3, true))));
+	}
+	BOOST_TEST((file.str() == as_bytes(simple_codecvt::to_utf16(u8str3, true))));
+}
+
+BOOST_AUTO_TEST_CASE(convert_into_bytes)
+{
+	const auto input = as_bytes(simple_codecvt::to_utf16(u8str3, false));
+	const auto size = simple_codecvt::required_size(input, simple_codecvt::encoding::utf16le, simple_codecvt::encoding::utf32be);
+	BOOST_TEST((size == u32str3.size() * 4));
+	std::string output(size, '\0');
+	auto rst = simple_codecvt::convert_into(input, simple_codecvt::encoding::utf16le, output, simple_codecvt::encoding::utf32be);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((rst.read == input.size()));
+	BOOST_TEST((output == as_bytes(simple_codecvt::to_utf32(u8str3, true))));
+
+	rst = simple_codecvt::convert_into(std::string_view(input).substr(0, 3), simple_codecvt::encoding::utf16le, output, simple_codecvt::encoding::utf8);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::invalid_input));
+	BOOST_TEST((rst.read == 2));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_convert)
+{
+	std::u8string u8buf;
+	while (u8buf.size() < (1 << 20))
+	{
+		u8buf += u8str3;
+	}
+	const auto u16buf = simple_codecvt::to_utf16(u8buf);
+	BOOST_TEST((simple_codecvt::parallel_convert<char16_t>(u8buf, 4) == u16buf));
+	BOOST_TEST((simple_codecvt::parallel_convert<char8_t>(u16buf, simple_codecvt::is_big_endian(), 3) == u8buf));
+	BOOST_TEST((simple_codecvt::parallel_convert<char32_t>(u8str3, 4) == u32str3));
+
+	auto bad = u8buf;
+	bad[bad.size() / 2] = u8'\xFF';
+	BOOST_CHECK_THROW(simple_codecvt::parallel_convert<char16_t>(bad, 4), std::invalid_argument);
+
+	const auto input = as_bytes(u8buf);
+	std::string output(simple_codecvt::required_size(input, simple_codecvt::encoding::utf8, simple_codecvt::encoding::utf16le), '\0');
+	auto rst = simple_codecvt::parallel_convert_into(input, simple_codecvt::encoding::utf8, output, simple_codecvt::encoding::utf16le, 4);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((output == as_bytes(simple_codecvt::to_utf16(u8buf, false))));
+	rst = simple_codecvt::parallel_convert_into(as_bytes(bad), simple_codecvt::encoding::utf8, output, simple_codecvt::encoding::utf16le, 4);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::invalid_input));
+	BOOST_TEST((rst.read == bad.size() / 2));
+}
+
+BOOST_AUTO_TEST_CASE(convert_column)
+{
+	const std::u8string rows[] = { u8"", u8"abc", u8"你好世界", u8"😀é", u8str3 };
+	std::vector<std::int32_t> offsets{ 0 };
+	std::string data;
+	for (auto &row : rows)
+	{
+		data += as_bytes(row);
+		offsets.push_back(static_cast<std::int32_t>(data.size()));
+	}
+
+	simple_codecvt::string_column<std::int32_t> column;
+	auto rst = simple_codecvt::convert_column<std::int32_t>(offsets, data, simple_codecvt::encoding::utf8, column, simple_codecvt::encoding::utf16le);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((column.offsets.size() == offsets.size()));
+	BOOST_TEST((column.data.size() == static_cast<std::size_t>(column.offsets.back())));
+	for (std::size_t i = 0; i < std::size(rows); ++i)
+	{
+		BOOST_TEST((column.data.substr(column.offsets[i], column.offsets[i + 1] - column.offsets[i]) == as_bytes(simple_codecvt::to_utf16(rows[i], false))));
+	}
+
+	// A sequence may not run across two strings.
+	const std::int64_t split[] = { 0, 4, 6 };
+	simple_codecvt::string_column<std::int64_t> wide_column;
+	rst = simple_codecvt::convert_column<std::int64_t>(split, "ab\xE4\xBD\xA0" "c"sv, simple_codecvt::encoding::utf8, wide_column, simple_codecvt::encoding::utf32le);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::invalid_input));
+	BOOST_TEST((rst.read == 2));
+	BOOST_TEST((rst.written == 0));
+	BOOST_TEST((wide_column.offsets.size() == 1));
+	BOOST_TEST((wide_column.data.empty()));
+
+	rst = simple_codecvt::convert_column<std::int64_t>(split, "ab\xE4\xBD\xA0" "c"sv, simple_codecvt::encoding::utf8, wide_column, simple_codecvt::encoding::utf32le, { simple_codecvt::error_action::replace, U'?' });
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((wide_column.offsets == std::vector<std::int64_t>{ 0, 12, 20 }));
+	BOOST_TEST((wide_column.data == as_bytes(simple_codecvt::to_little_endian(U"ab??c"sv))));
+
+	rst = simple_codecvt::convert_column<std::int32_t>({}, {}, simple_codecvt::encoding::utf8, column, simple_codecvt::encoding::utf16be);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((column.offsets == std::vector<std::int32_t>{ 0 }));
+	BOOST_TEST((column.data.empty()));
+}
+
+BOOST_AUTO_TEST_CASE(memory_resource)
+{
+	// Anything the conversions allocate beyond the buffer throws std::bad_alloc.
+	static std::byte buffer[1 << 20];
+	std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+	const auto u8 = simple_codecvt::to_utf8(u16str3, &arena);
+	BOOST_TEST((u8.get_allocator().resource() == &arena));
+	BOOST_TEST((std::u8string_view(u8) == u8str3));
+	BOOST_TEST((std::u16string_view(simple_codecvt::to_utf16(u8str3, &arena, !simple_codecvt::is_big_endian())) == simple_codecvt::change_endian_copy(u16str3)));
+	BOOST_TEST((std::u32string_view(simple_codecvt::to_utf32(u16str3, &arena)) == u32str3));
+	BOOST_TEST((std::wstring_view(simple_codecvt::to_wstring(u8str3, &arena)) == simple_codecvt::to_wstring(u8str3)));
+
+	std::pmr::u16string u16(&arena);
+	simple_codecvt::append_utf16(u16, u8str3);
+	simple_codecvt::append_utf16(u16, u32str3);
+	BOOST_TEST((std::u16string_view(u16) == u16str3 + u16str3));
+	simple_codecvt::assign_utf16(u16, u8"abc"sv);
+	BOOST_TEST((std::u16string_view(u16) == u"abc"sv));
+	BOOST_CHECK_THROW(simple_codecvt::append_utf16(u16, U"\xD800"sv), std::invalid_argument);
+	BOOST_TEST((std::u16string_view(u16) == u"abc"sv));
+	BOOST_TEST((u16.get_allocator().resource() == &arena));
+}
+
+BOOST_AUTO_TEST_CASE(validate)
+{
+	BOOST_TEST((simple_codecvt::validate_utf8(u8str3) == u8str3.size()));
+	BOOST_TEST((simple_codecvt::validate_utf8(u8"abc\xE4\xBD"sv) == 3));
+	BOOST_TEST((simple_codecvt::validate_utf8(u8"abc\xED\xA0\x80"sv) == 3));
+	BOOST_TEST((simple_codecvt::validate_utf8(u8str3 + u8"\xC0\xAF" + u8str3) == u8str3.size()));
+
+	const auto u16buf = u16str3 + u"\xDC00" + u16str3;
+	BOOST_TEST((simple_codecvt::validate_utf16(u16str3) == u16str3.size()));
+	BOOST_TEST((simple_codecvt::validate_utf16(simple_codecvt::change_endian_copy(u16str3), !simple_codecvt::is_big_endian()) == u16str3.size()));
+	BOOST_TEST((simple_codecvt::validate_utf16(u16buf) == u16str3.size()));
+	BOOST_TEST((simple_codecvt::validate_utf16(u"ab\xD83D"sv) == 2));
+
+	const auto u32buf = u32str3 + U"\x110000";
+	BOOST_TEST((simple_codecvt::validate_utf32(u32str3) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::validate_utf32(u32buf) == u32str3.size()));
+
+	BOOST_TEST((simple_codecvt::validate(as_bytes(u8str3), simple_codecvt::encoding::utf8) == u8str3.size()));
+	BOOST_TEST((simple_codecvt::validate("ab\0"sv, simple_codecvt::encoding::utf16le) == 2));
+	BOOST_TEST((simple_codecvt::validate(as_bytes(u32buf), simple_codecvt::is_big_endian() ? simple_codecvt::encoding::utf32be : simple_codecvt::encoding::utf32le) == u32str3.size() * 4));
+}
+
+BOOST_AUTO_TEST_CASE(count_code_points)
+{
+	BOOST_TEST((simple_codecvt::count_code_points(u8str3) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(u16str3) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(simple_codecvt::change_endian_copy(u16str3), !simple_codecvt::is_big_endian()) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(u32str3) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(simple_codecvt::to_wstring(u32str3)) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(u8""sv) == 0));
+	BOOST_TEST((simple_codecvt::count_code_points(as_bytes(u16str3), simple_codecvt::is_big_endian() ? simple_codecvt::encoding::utf16be : simple_codecvt::encoding::utf16le) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(as_bytes(u8str3), simple_codecvt::encoding::utf8) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::count_code_points(as_bytes(u32str3), simple_codecvt::encoding::utf32le) == u32str3.size()));
+	BOOST_TEST((simple_codecvt::required_size<char16_t>(u8str3) == u16str3.size()));
+	BOOST_TEST((simple_codecvt::required_size<char8_t>(u16str3) == u8str3.size()));
+}
+
+BOOST_AUTO_TEST_CASE(gb18030)
+{
+	using simple_codecvt::encoding;
+
+	// Two-byte, four-byte BMP and four-byte supplementary codes, and the euro sign.
+	const auto gb = "\xC4\xE3" "a\xBA\xC3" "b\x94\x39\xFC\x36" "c\xA2\xE3\x81\x30\x8A\x31"sv;
+	const auto text = U"你a好b😀c€ä"sv;
+	BOOST_TEST((simple_codecvt::to_utf32(gb, encoding::gb18030) == text));
+	BOOST_TEST((simple_codecvt::to_string(text, encoding::gb18030) == gb));
+	BOOST_TEST((simple_codecvt::to_utf8(simple_codecvt::to_string(u8str3, encoding::gb18030), encoding::gb18030) == u8str3));
+	BOOST_TEST((simple_codecvt::to_utf16(simple_codecvt::to_string(u16str3, encoding::gb18030), encoding::gb18030) == u16str3));
+	BOOST_TEST((simple_codecvt::to_wstring(gb, encoding::gb18030) == simple_codecvt::to_wstring(text)));
+	BOOST_TEST((simple_codecvt::count_code_points(gb, encoding::gb18030) == text.size()));
+
+	// Code points GB18030-2022 moved out of the Private Use Area, and the four-byte codes that
+	// took over the Private Use code points.
+	BOOST_TEST((simple_codecvt::to_utf32("\xA6\xD9\xFE\x59\xFE\x51"sv, encoding::gb18030) == U"\xFE10\x9FB4\xE816"sv));
+	BOOST_TEST((simple_codecvt::to_string(U"\xE78D\xE81E"sv, encoding::gb18030) == "\x84\x31\x82\x36\x82\x35\x90\x37"sv));
+
+	// GBK has only the one- and two-byte codes, and 0x80 for the euro sign.
+	BOOST_TEST((simple_codecvt::to_string(U"你a€"sv, encoding::gbk) == "\xC4\xE3" "a\x80"sv));
+	BOOST_TEST((simple_codecvt::to_utf32("\x80\xA2\xE3"sv, encoding::gbk) == U"€€"sv));
+	BOOST_CHECK_THROW((void)simple_codecvt::to_string(U"😀"sv, encoding::gbk), std::invalid_argument);
+	BOOST_CHECK_THROW((void)simple_codecvt::to_utf32(gb, encoding::gbk), std::invalid_argument);
+
+	// 80 and FF are invalid, a lead byte before a space is dropped alone, a four-byte code past
+	// U+10FFFF whole.
+	BOOST_TEST((simple_codecvt::validate("a\xC4\xE3\x80"sv, encoding::gb18030) == 3));
+	BOOST_TEST((simple_codecvt::validate("\xC4\xE3\x81\x30\x81"sv, encoding::gb18030) == 2));
+	const simple_codecvt::error_policy replace{ simple_codecvt::error_action::replace };
+	const auto bad = "\xFF" "a\xC4 b\xE3\x32\x9A\x36" "c"sv;
+	char8_t out[32];
+	const auto rst = simple_codecvt::convert_into(bad, encoding::gb18030, { reinterpret_cast<char *>(out), sizeof(out) }, encoding::utf8, replace);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok && std::u8string_view(out, rst.written) == u8"\uFFFDa\uFFFD b\uFFFDc"sv));
+	BOOST_TEST((simple_codecvt::required_size(bad, encoding::gb18030, encoding::utf8, replace) == rst.written));
+	BOOST_TEST((simple_codecvt::required_size("a\xF0\x9F\x98\x80"sv, encoding::utf8, encoding::gbk, replace) == 2));
+}
+
+BOOST_AUTO_TEST_CASE(double_byte_charsets)
+{
+	using simple_codecvt::encoding;
+
+	// Lead and trail byte pairs, half-width katakana in one byte or after 0x8E, and JIS X 0212
+	// after 0x8F.
+	const auto sjis = "\x93\xFA\x96\x7B" "a\xB1"sv;
+	const auto eucjp = "\xC6\xFC\xCB\xDC" "a\x8E\xB1\x8F\xB0\xA1"sv;
+	const auto big5 = "\xA4\xA4\xA4\xE5"sv;
+	const auto euckr = "\xC7\xD1\xB1\xB9\x8C\x63"sv;
+	BOOST_TEST((simple_codecvt::to_utf32(sjis, encoding::shift_jis) == U"日本aｱ"sv));
+	BOOST_TEST((simple_codecvt::to_utf32(eucjp, encoding::euc_jp) == U"日本aｱ丂"sv));
+	BOOST_TEST((simple_codecvt::to_utf16(big5, encoding::big5) == u"中文"sv));
+	BOOST_TEST((simple_codecvt::to_utf8(euckr, encoding::euc_kr) == u8"한국똠"sv));
+	BOOST_TEST((simple_codecvt::to_string(u8"日本aｱ"sv, encoding::shift_jis) == sjis));
+	BOOST_TEST((simple_codecvt::to_string(U"日本aｱ丂"sv, encoding::euc_jp) == eucjp));
+	BOOST_TEST((simple_codecvt::to_string(u"中文"sv, encoding::big5) == big5));
+	BOOST_TEST((simple_codecvt::to_string(U"한국똠"sv, encoding::euc_kr) == euckr));
+	BOOST_TEST((simple_codecvt::count_code_points(eucjp, encoding::euc_jp) == 5));
+	BOOST_CHECK_THROW((void)simple_codecvt::to_string(U"한"sv, encoding::shift_jis), std::invalid_argument);
+
+	// A lead byte before ASCII is dropped alone, a pair without a character and a truncated
+	// code at the end whole.
+	BOOST_TEST((simple_codecvt::validate("a\x93\xFA\x93"sv, encoding::shift_jis) == 3));
+	BOOST_TEST((simple_codecvt::validate("\x8F\xB0"sv, encoding::euc_jp) == 0));
+	const simple_codecvt::error_policy replace{ simple_codecvt::error_action::replace };
+	const auto bad = "\x81 a\x81\xB0" "b\x93"sv;
+	char8_t out[32];
+	const auto rst = simple_codecvt::convert_into(bad, encoding::shift_jis, { reinterpret_cast<char *>(out), sizeof(out) }, encoding::utf8, replace);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok && std::u8string_view(out, rst.written) == u8"\uFFFD a\uFFFDb\uFFFD"sv));
+	BOOST_TEST((simple_codecvt::required_size(bad, encoding::shift_jis, encoding::utf8, replace) == rst.written));
+}
+
+BOOST_AUTO_TEST_CASE(single_byte_code_pages)
+{
+	using simple_codecvt::encoding;
+
+	BOOST_TEST((simple_codecvt::to_utf8("\x80 \xE9"sv, encoding::windows_1252) == u8"€ é"sv));
+	BOOST_TEST((simple_codecvt::to_utf16("\xA4\xBD"sv, encoding::iso8859_15) == u"€œ"sv));
+	BOOST_TEST((simple_codecvt::to_utf32("\xF0\xD2\xC9\xD7\xC5\xD4"sv, encoding::koi8_r) == U"Привет"sv));
+	BOOST_TEST((simple_codecvt::to_string(u8"Привет"sv, encoding::windows_1251) == "\xCF\xF0\xE8\xE2\xE5\xF2"sv));
+	BOOST_TEST((simple_codecvt::to_string(U"Ζεύς"sv, encoding::iso8859_7) == "\xC6\xE5\xFD\xF2"sv));
+	BOOST_TEST((simple_codecvt::to_string(u"ÿ"sv, encoding::latin1) == "\xFF"sv));
+	BOOST_CHECK_THROW((void)simple_codecvt::to_string(u"\u0100"sv, encoding::latin1), std::invalid_argument);
+	BOOST_CHECK_THROW((void)simple_codecvt::to_string(U"€"sv, encoding::koi8_u), std::invalid_argument);
+
+	// Long enough for the vector kernels, with every byte that has a character.
+	std::string text;
+	for (int i = 0; i < 64; ++i)
+	{
+		for (int byte = 0; byte < 256; ++byte)
+		{
+			if (byte != 0x81 && byte != 0x8D && byte != 0x8F && byte != 0x90 && byte != 0x9D)
+			{
+				text.push_back(static_cast<char>(byte));
+			}
+		}
+	}
+	for (auto page : { encoding::windows_1252, encoding::latin1 })
+	{
+		BOOST_TEST((simple_codecvt::to_string(simple_codecvt::to_utf8(text, page), page) == text));
+		BOOST_TEST((simple_codecvt::to_string(simple_codecvt::to_utf16(text, page), page) == text));
+		BOOST_TEST((simple_codecvt::count_code_points(text, page) == text.size()));
+	}
+
+	// Bytes without a character, and characters without a byte, are invalid input.
+	text[3000] = '\x81';
+	BOOST_TEST((simple_codecvt::validate(text, encoding::windows_1252) == 3000));
+	BOOST_CHECK_THROW((void)simple_codecvt::to_utf8(text, encoding::windows_1252), std::invalid_argument);
+	const simple_codecvt::error_policy replace{ simple_codecvt::error_action::replace };
+	char out[16];
+	auto rst = simple_codecvt::convert_into("a\x81" "b"sv, encoding::windows_1252, out, encoding::utf8, replace);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok && std::string_view(out, rst.written) == "a\xEF\xBF\xBD" "b"sv));
+	const auto u8text = "\xC3\xA9\xE2\x82\xAC\xC4\x80"sv;
+	rst = simple_codecvt::convert_into(u8text, encoding::utf8, out, encoding::latin1, replace);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok && std::string_view(out, rst.written) == "\xE9??"sv));
+	BOOST_TEST((simple_codecvt::required_size(u8text, encoding::utf8, encoding::latin1, replace) == rst.written));
+	rst = simple_codecvt::convert_into(u8text, encoding::utf8, out, encoding::latin1);
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::invalid_input && rst.read == 2 && rst.written == 1));
+}
+
+BOOST_AUTO_TEST_CASE(error_policy)
+{
+	const simple_codecvt::error_policy replace{ simple_codecvt::error_action::replace };
+	const simple_codecvt::error_policy skip{ simple_codecvt::error_action::skip };
+	const simple_codecvt::error_policy question{ simple_codecvt::error_action::replace, U'?' };
+
+	// C0, ED, A0 and 80 are invalid one by one, E4 BD is a sequence cut off before "c".
+	const auto u8bad = u8"a\xC0\xED\xA0\x80" "b\xE4\xBD" "c"sv;
+	BOOST_TEST((simple_codecvt::convert<char32_t>(u8bad, replace) == U"a\xFFFD\xFFFD\xFFFD\xFFFD" "b\xFFFD" "c"sv));
+	BOOST_TEST((simple_codecvt::convert<char32_t>(u8bad, skip) == U"abc"sv));
+	BOOST_TEST((simple_codecvt::convert<char16_t>(u8bad, question) == u"a????b?c"sv));
+	BOOST_TEST((simple_codecvt::convert<char8_t>(u8str3 + u8"\xFF" + u8str3, skip) == u8str3 + u8str3));
+	BOOST_TEST((simple_codecvt::convert<char8_t>(u"ab\xD83D"sv, replace) == u8"ab\xEF\xBF\xBD"sv));
+	BOOST_TEST((simple_codecvt::convert<char16_t>(U"a\xD800" "b\x110000"sv, replace) == u"a\xFFFD" "b\xFFFD"sv));
+	BOOST_TEST((simple_codecvt::convert<char16_t>(simple_codecvt::change_endian_copy(u16str3), replace, !simple_codecvt::is_big_endian()) == u16str3));
+	BOOST_CHECK_THROW((void)simple_codecvt::convert<char16_t>(u8bad, {}), std::invalid_argument);
+
+	auto rst = simple_codecvt::try_convert<char16_t>(u8str3 + u8"\xFF");
+	BOOST_TEST((!rst && rst.error() == u8str3.size()));
+	rst = simple_codecvt::try_convert<char16_t>(u8str3);
+	BOOST_TEST((rst.has_value() && *rst == u16str3));
+	BOOST_TEST((simple_codecvt::try_convert<wchar_t>(u8bad, skip).value() == L"abc"));
+
+	const auto bytes = "a\0\0\xD8" "b"sv;
+	const auto size = simple_codecvt::required_size(bytes, simple_codecvt::encoding::utf16le, simple_codecvt::encoding::utf8, replace);
+	BOOST_TEST((size == 7));
+	std::string output(size, '\0');
+	auto brst = simple_codecvt::convert_into(bytes, simple_codecvt::encoding::utf16le, output, simple_codecvt::encoding::utf8, replace);
+	BOOST_TEST((brst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((brst.read == bytes.size()));
+	BOOST_TEST((output == "a\xEF\xBF\xBD\xEF\xBF\xBD"));
+}
+
+BOOST_AUTO_TEST_CASE(narrow_ascii_runs)
+{
+	const auto ascii = repeat<wchar_t>(L"abcdefghijklmnopqrstuvwxyz0123456789"sv, 100);
+	const auto mixed = repeat<wchar_t>(L"abcdefghijklmnopqrstuvwxyz0123456789"s + widestr2, 100);
+	BOOST_TEST((simple_codecvt::to_string(ascii) == repeat<char>("abcdefghijklmnopqrstuvwxyz0123456789"sv, 100)));
+	BOOST_TEST((simple_codecvt::to_wstring(simple_codecvt::to_string(mixed)) == mixed));
+	BOOST_TEST((simple_codecvt::to_utf8(simple_codecvt::to_string(mixed)) == simple_codecvt::to_utf8(mixed)));
+
+	const auto narrow = simple_codecvt::to_string(mixed);
+	std::wstring output(simple_codecvt::required_size<wchar_t>(narrow), L'\0');
+	BOOST_TEST((output.size() == mixed.size()));
+	auto rst = simple_codecvt::convert_into(narrow, std::span<wchar_t>(output));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::ok));
+	BOOST_TEST((output == mixed));
+	rst = simple_codecvt::convert_into(narrow, std::span<wchar_t>(output).first(50));
+	BOOST_TEST((rst.status == simple_codecvt::convert_status::output_full));
+	BOOST_TEST((output.compare(0, rst.written, mixed, 0, rst.written) == 0));
+}
+
+BOOST_AUTO_TEST_CASE(narrow_byte_order)
+{
+	const auto be = simple_codecvt::is_big_endian();
+	const auto mixed = repeat<char16_t>(u"abcdefghijklmnopqrstuvwxyz0123456789"s + u16str2 + repeat<char16_t>(u16str2, 100), 10);
+	const auto narrow = simple_codecvt::to_string(mixed);
+	const auto swapped = simple_codecvt::change_endian_copy(mixed);
+	BOOST_TEST((simple_codecvt::to_string(swapped, !be) == narrow));
+	BOOST_TEST((simple_codecvt::to_utf16(narrow, !be) == swapped));
+	BOOST_TEST((simple_codecvt::to_utf32(narrow, !be) == simple_codecvt::change_endian_copy(simple_codecvt::to_utf32(mixed))));
+}
+
+#ifndef _MSC_VER
+BOOST_AUTO_TEST_CASE(narrow_locale_refresh)
+{
+	// The narrow encoding is looked up once; refresh_locale() picks up a setlocale() call.
+	const std::string previous = std::setlocale(LC_CTYPE, nullptr);
+	if (std::setlocale(LC_CTYPE, "C.UTF-8") != nullptr)
+	{
+		simple_codecvt::refresh_locale();
+		BOOST_TEST((simple_codecvt::to_utf8(multistr2) == u8str2));
+		BOOST_TEST((simple_codecvt::to_string(u32str2) == multistr2));
+		BOOST_CHECK_THROW((void)simple_codecvt::to_utf16("a\xFF"s), std::invalid_argument);
+		std::setlocale(LC_CTYPE, previous.c_str());
+		simple_codecvt::refresh_locale();
+	}
+	BOOST_TEST((simple_codecvt::to_wstring(multistr2) == widestr2));
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(kernel_tiers)
+{
+	const auto initial = simple_codecvt::active_kernel_tier();
+	BOOST_TEST(simple_codecvt::set_kernel_tier(simple_codecvt::kernel_tier::scalar));
+	BOOST_TEST((simple_codecvt::active_kernel_tier() == simple_codecvt::kernel_tier::scalar));
+	const auto be = simple_codecvt::is_big_endian();
+	for (auto tier : { simple_codecvt::kernel_tier::scalar, simple_codecvt::kernel_tier::sse2, simple_codecvt::kernel_tier::ssse3, simple_codecvt::kernel_tier::avx2 })
+	{
+		if (!simple_codecvt::set_kernel_tier(tier))
+		{
+			continue;
+		}
+		BOOST_TEST((simple_codecvt::to_utf16(u8str3) == u16str3));
+		BOOST_TEST((simple_codecvt::to_utf8(u16str3) == u8str3));
+		BOOST_TEST((simple_codecvt::to_utf32(u8str3) == u32str3));
+		BOOST_TEST((simple_codecvt::to_utf8(u32str3) == u8str3));
+		BOOST_TEST((simple_codecvt::to_utf16(u32str3, be, !be) == simple_codecvt::change_endian_copy(u16str3)));
+		BOOST_TEST((simple_codecvt::to_utf32(simple_codecvt::change_endian_copy(u16str3), !be) == u32str3));
+		BOOST_TEST((simple_codecvt::validate_utf8(u8str3 + u8"\xC0"s) == u8str3.size()));
+		BOOST_TEST((simple_codecvt::required_size<char16_t>(u8str3) == u16str3.size()));
+		BOOST_TEST((simple_codecvt::convert<char16_t>(u8"a\xC0" "b"sv, { simple_codecvt::error_action::replace }) == u"a\xFFFD" "b"));
+	}
+	BOOST_TEST(simple_codecvt::set_kernel_tier(initial));
+}
+
+BOOST_AUTO_TEST_CASE(converter_cache)
+{
+	BOOST_CHECK_NO_THROW(simple_codecvt::warm_up_converters());
+	BOOST_CHECK_NO_THROW(simple_codecvt::warm_up_converters());
+	BOOST_TEST((simple_codecvt::to_utf8(u16str1) == u8str1));
+	simple_codecvt::flush_converters();
+	simple_codecvt::flush_converters();
+	BOOST_CHECK_NO_THROW(simple_codecvt::warm_up_converters());
+}
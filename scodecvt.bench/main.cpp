@@ -0,0 +1,1023 @@
+﻿#include <scodecvt/simple_codecvt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace sc = simple_codecvt;
+
+namespace
+{
+	// One text in every form the library takes. The narrow form exists only where the text can
+	// be represented in the encoding of the current locale.
+	struct corpus
+	{
+		std::string name;
+		std::u8string utf8;
+		std::u16string utf16;
+		std::u16string utf16_swapped;
+		std::u32string utf32;
+		std::u32string utf32_swapped;
+		std::wstring wide;
+		std::string narrow;
+		bool has_narrow = false;
+		std::string gb18030;
+		// The text split after each space, as string columns of UTF-8 and of UTF-16LE.
+		std::vector<std::int64_t> words;
+		std::vector<std::int64_t> utf16_words;
+
+		template <typename CharType>
+		std::basic_string_view<CharType> text(void) const noexcept
+		{
+			if constexpr (std::is_same_v<CharType, char>)
+			{
+				return narrow;
+			}
+			else if constexpr (std::is_same_v<CharType, wchar_t>)
+			{
+				return wide;
+			}
+			else if constexpr (std::is_same_v<CharType, char8_t>)
+			{
+				return utf8;
+			}
+			else if constexpr (std::is_same_v<CharType, char16_t>)
+			{
+				return utf16;
+			}
+			else
+			{
+				return utf32;
+			}
+		}
+
+		// The UTF-8 or GB18030 text, or the UTF-16 or UTF-32 text in the named byte order, as bytes.
+		std::string_view bytes(sc::encoding encoding) const noexcept
+		{
+			const bool big = encoding == sc::encoding::utf16be || encoding == sc::encoding::utf32be;
+			switch (encoding)
+			{
+			case sc::encoding::utf16le:
+			case sc::encoding::utf16be:
+			{
+				const auto &text = big == sc::is_big_endian() ? utf16 : utf16_swapped;
+				return { reinterpret_cast<const char *>(text.data()), text.size() * sizeof(char16_t) };
+			}
+			case sc::encoding::utf32le:
+			case sc::encoding::utf32be:
+			{
+				const auto &text = big == sc::is_big_endian() ? utf32 : utf32_swapped;
+				return { reinterpret_cast<const char *>(text.data()), text.size() * sizeof(char32_t) };
+			}
+			case sc::encoding::gb18030:
+				return gb18030;
+			default:
+				return { reinterpret_cast<const char *>(utf8.data()), utf8.size() };
+			}
+		}
+	};
+
+	// A function call to time. run() returns the number of input bytes it processed.
+	struct benchmark
+	{
+		std::string name;
+		bool narrow_input;
+		std::function<std::size_t(const corpus &)> run;
+	};
+
+	// Keeps the results of the timed calls alive.
+	volatile std::size_t sink = 0;
+
+	template <typename Result>
+	void consume(const Result &result) noexcept
+	{
+		if constexpr (std::is_integral_v<Result>)
+		{
+			sink = sink + result;
+		}
+		else if constexpr (std::is_same_v<Result, sc::convert_result>)
+		{
+			sink = sink + result.written;
+		}
+		else if constexpr (requires { result.has_value(); })
+		{
+			sink = sink + (result.has_value() ? result->size() : result.error());
+		}
+		else
+		{
+			sink = sink + result.size();
+		}
+	}
+
+	template <typename CharType>
+	constexpr std::string_view type_name(void) noexcept
+	{
+		if constexpr (std::is_same_v<CharType, char>)
+		{
+			return "string";
+		}
+		else if constexpr (std::is_same_v<CharType, wchar_t>)
+		{
+			return "wstring";
+		}
+		else if constexpr (std::is_same_v<CharType, char8_t>)
+		{
+			return "u8string";
+		}
+		else if constexpr (std::is_same_v<CharType, char16_t>)
+		{
+			return "u16string";
+		}
+		else
+		{
+			return "u32string";
+		}
+	}
+
+	constexpr std::string_view encoding_name(sc::encoding encoding) noexcept
+	{
+		switch (encoding)
+		{
+		case sc::encoding::utf16le:
+			return "UTF-16LE";
+		case sc::encoding::utf16be:
+			return "UTF-16BE";
+		case sc::encoding::utf32le:
+			return "UTF-32LE";
+		case sc::encoding::utf32be:
+			return "UTF-32BE";
+		case sc::encoding::gb18030:
+			return "GB18030";
+		default:
+			return "UTF-8";
+		}
+	}
+
+	constexpr sc::encoding encodings[] = { sc::encoding::utf8, sc::encoding::utf16le, sc::encoding::utf16be, sc::encoding::utf32le, sc::encoding::utf32be, sc::encoding::gb18030 };
+
+	template <typename Function>
+	void for_each_char_type(Function function)
+	{
+		function(std::type_identity<char>());
+		function(std::type_identity<wchar_t>());
+		function(std::type_identity<char8_t>());
+		function(std::type_identity<char16_t>());
+		function(std::type_identity<char32_t>());
+	}
+
+	template <typename Function>
+	void for_each_unicode_type(Function function)
+	{
+		function(std::type_identity<wchar_t>());
+		function(std::type_identity<char8_t>());
+		function(std::type_identity<char16_t>());
+		function(std::type_identity<char32_t>());
+	}
+
+	template <typename CharType>
+	std::size_t bytes_of(std::basic_string_view<CharType> text) noexcept
+	{
+		return text.size() * sizeof(CharType);
+	}
+
+	std::string call_name(std::string_view function, std::string_view arguments)
+	{
+		std::string str(function);
+		str += '(';
+		str += arguments;
+		str += ')';
+		return str;
+	}
+
+	// to_X(), assign_X() and append_X() from every input type they take. The output strings
+	// are reused across calls, as a program converting many texts would.
+	template <typename OutputCharType, typename To, typename Assign, typename Append>
+	void add_family(std::vector<benchmark> &list, std::string_view family, To to, Assign assign, Append append)
+	{
+		for_each_char_type([&](auto type)
+		{
+			using input_type = typename decltype(type)::type;
+			using view_type = std::basic_string_view<input_type>;
+			using string_type = std::basic_string<OutputCharType>;
+			if constexpr (std::is_invocable_v<To, view_type>)
+			{
+				const bool narrow = std::is_same_v<input_type, char>;
+				const auto args = type_name<input_type>();
+				list.push_back({ call_name("to_" + std::string(family), args), narrow, [to](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					consume(to(text));
+					return bytes_of(text);
+				} });
+				auto assigned = std::make_shared<string_type>();
+				list.push_back({ call_name("assign_" + std::string(family), args), narrow, [assign, assigned](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					assign(*assigned, text);
+					consume(*assigned);
+					return bytes_of(text);
+				} });
+				auto appended = std::make_shared<string_type>();
+				list.push_back({ call_name("append_" + std::string(family), args), narrow, [append, appended](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					appended->clear();
+					append(*appended, text);
+					consume(*appended);
+					return bytes_of(text);
+				} });
+			}
+		});
+	}
+
+	// Room for any conversion of `units` input code units.
+	template <typename CharType>
+	std::span<CharType> output_buffer(std::vector<CharType> &buffer, std::size_t units)
+	{
+		if (buffer.size() < units * 4 + 4)
+		{
+			buffer.resize(units * 4 + 4);
+		}
+		return buffer;
+	}
+
+	// required_size<OutputCharType>(), convert_into() and, for Unicode input, convert(),
+	// try_convert() and parallel_convert().
+	template <typename OutputCharType>
+	void add_output(std::vector<benchmark> &list, unsigned int threads)
+	{
+		for_each_char_type([&](auto type)
+		{
+			using input_type = typename decltype(type)::type;
+			const bool narrow = std::is_same_v<input_type, char>;
+			const auto args = std::string(type_name<input_type>());
+			const auto out = std::string(type_name<OutputCharType>());
+			if constexpr (!std::is_same_v<input_type, OutputCharType>)
+			{
+				list.push_back({ "required_size<" + out + ">(" + args + ")", narrow, [](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					consume(sc::required_size<OutputCharType>(text));
+					return bytes_of(text);
+				} });
+				auto buffer = std::make_shared<std::vector<OutputCharType>>();
+				list.push_back({ "convert_into(" + args + ", span<" + out + ">)", narrow, [buffer](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					consume(sc::convert_into(text, output_buffer(*buffer, text.size())));
+					return bytes_of(text);
+				} });
+			}
+			if constexpr (!std::is_same_v<input_type, char> && !std::is_same_v<OutputCharType, char>)
+			{
+				list.push_back({ "convert<" + out + ">(" + args + ", replace)", false, [](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					consume(sc::convert<OutputCharType>(text, { sc::error_action::replace }));
+					return bytes_of(text);
+				} });
+				list.push_back({ "try_convert<" + out + ">(" + args + ")", false, [](const corpus &c)
+				{
+					const auto text = c.text<input_type>();
+					consume(sc::try_convert<OutputCharType>(text));
+					return bytes_of(text);
+				} });
+				if constexpr (!std::is_same_v<input_type, OutputCharType>)
+				{
+					list.push_back({ "parallel_convert<" + out + ">(" + args + ")", false, [threads](const corpus &c)
+					{
+						const auto text = c.text<input_type>();
+						if constexpr (std::is_same_v<input_type, char16_t> || std::is_same_v<input_type, char32_t>)
+						{
+							consume(sc::parallel_convert<OutputCharType>(text, sc::is_big_endian(), threads));
+						}
+						else
+						{
+							consume(sc::parallel_convert<OutputCharType>(text, threads));
+						}
+						return bytes_of(text);
+					} });
+				}
+			}
+		});
+	}
+
+	template <typename InputCharType, typename OutputCharType>
+	void add_stream(std::vector<benchmark> &list)
+	{
+		constexpr std::size_t chunk = 64 * 1024;
+		auto converted = std::make_shared<std::basic_string<OutputCharType>>();
+		list.push_back({ "stream_converter<" + std::string(type_name<InputCharType>()) + ", " + std::string(type_name<OutputCharType>()) + ">::feed", false, [converted](const corpus &c)
+		{
+			const auto text = c.text<InputCharType>();
+			sc::stream_converter<InputCharType, OutputCharType> converter;
+			converted->clear();
+			for (std::size_t offset = 0; offset < text.size(); offset += chunk)
+			{
+				converter.feed(text.substr(offset, chunk), *converted);
+			}
+			converter.finish();
+			consume(*converted);
+			return bytes_of(text);
+		} });
+	}
+
+	void add_streams(std::vector<benchmark> &list)
+	{
+		for_each_unicode_type([&](auto input)
+		{
+			for_each_unicode_type([&](auto output)
+			{
+				using input_type = typename decltype(input)::type;
+				using output_type = typename decltype(output)::type;
+				if constexpr (!std::is_same_v<input_type, output_type>)
+				{
+					add_stream<input_type, output_type>(list);
+				}
+			});
+		});
+	}
+
+	void add_bytes(std::vector<benchmark> &list, unsigned int threads)
+	{
+		for (auto from : encodings)
+		{
+			const auto from_name = std::string(encoding_name(from));
+			list.push_back({ "validate(" + from_name + ")", false, [from](const corpus &c)
+			{
+				const auto bytes = c.bytes(from);
+				consume(sc::validate(bytes, from));
+				return bytes.size();
+			} });
+			list.push_back({ "count_code_points(" + from_name + ")", false, [from](const corpus &c)
+			{
+				const auto bytes = c.bytes(from);
+				consume(sc::count_code_points(bytes, from));
+				return bytes.size();
+			} });
+			for (auto to : encodings)
+			{
+				if (from == to)
+				{
+					continue;
+				}
+				const auto args = from_name + ", " + std::string(encoding_name(to));
+				list.push_back({ "required_size(" + args + ")", false, [from, to](const corpus &c)
+				{
+					const auto bytes = c.bytes(from);
+					consume(sc::required_size(bytes, from, to));
+					return bytes.size();
+				} });
+				// char32_t keeps the output aligned for every encoding.
+				auto buffer = std::make_shared<std::vector<char32_t>>();
+				list.push_back({ "convert_into(" + args + ")", false, [from, to, buffer](const corpus &c)
+				{
+					const auto bytes = c.bytes(from);
+					const auto dest = std::as_writable_bytes(output_buffer(*buffer, bytes.size()));
+					consume(sc::convert_into(bytes, from, { reinterpret_cast<char *>(dest.data()), dest.size() }, to));
+					return bytes.size();
+				} });
+				list.push_back({ "convert_into(" + args + ", replace)", false, [from, to, buffer](const corpus &c)
+				{
+					const auto bytes = c.bytes(from);
+					const auto dest = std::as_writable_bytes(output_buffer(*buffer, bytes.size()));
+					consume(sc::convert_into(bytes, from, { reinterpret_cast<char *>(dest.data()), dest.size() }, to, { sc::error_action::replace }));
+					return bytes.size();
+				} });
+				list.push_back({ "parallel_convert_into(" + args + ")", false, [from, to, buffer, threads](const corpus &c)
+				{
+					const auto bytes = c.bytes(from);
+					const auto dest = std::as_writable_bytes(output_buffer(*buffer, bytes.size()));
+					consume(sc::parallel_convert_into(bytes, from, { reinterpret_cast<char *>(dest.data()), dest.size() }, to, threads));
+					return bytes.size();
+				} });
+			}
+		}
+	}
+
+	// A column of words converted at once, and the same words converted one call each.
+	void add_columns(std::vector<benchmark> &list)
+	{
+		auto column = std::make_shared<sc::string_column<std::int64_t>>();
+		list.push_back({ "convert_column<int64_t>(UTF-8, UTF-16LE)", false, [column](const corpus &c)
+		{
+			const auto bytes = c.bytes(sc::encoding::utf8);
+			consume(sc::convert_column<std::int64_t>(c.words, bytes, sc::encoding::utf8, *column, sc::encoding::utf16le));
+			return bytes.size();
+		} });
+		list.push_back({ "convert_column<int64_t>(UTF-16LE, UTF-8)", false, [column](const corpus &c)
+		{
+			const auto bytes = c.bytes(sc::encoding::utf16le);
+			consume(sc::convert_column<std::int64_t>(c.utf16_words, bytes, sc::encoding::utf16le, *column, sc::encoding::utf8));
+			return bytes.size();
+		} });
+		auto words = std::make_shared<std::vector<std::u16string>>();
+		list.push_back({ "to_utf16(u8string) per word", false, [words](const corpus &c)
+		{
+			words->resize(c.words.size() - 1);
+			for (std::size_t i = 0; i + 1 < c.words.size(); ++i)
+			{
+				(*words)[i] = sc::to_utf16(std::u8string_view(c.utf8).substr(static_cast<std::size_t>(c.words[i]), static_cast<std::size_t>(c.words[i + 1] - c.words[i])));
+			}
+			consume(words->size());
+			return bytes_of<char8_t>(c.utf8);
+		} });
+	}
+
+	void add_streambufs(std::vector<benchmark> &list)
+	{
+		list.push_back({ "transcoding_streambuf(UTF-16LE -> UTF-8, read)", false, [](const corpus &c)
+		{
+			const auto bytes = c.bytes(sc::encoding::utf16le);
+			std::stringbuf source(std::string(bytes), std::ios_base::in);
+			sc::transcoding_streambuf buffer(&source, sc::encoding::utf16le, sc::encoding::utf8);
+			std::size_t count = 0;
+			char chunk[4096];
+			for (std::streamsize n; (n = buffer.sgetn(chunk, sizeof(chunk))) > 0;)
+			{
+				count += static_cast<std::size_t>(n);
+			}
+			consume(count);
+			return bytes.size();
+		} });
+		list.push_back({ "transcoding_streambuf(UTF-8 -> UTF-16LE, write)", false, [](const corpus &c)
+		{
+			const auto bytes = c.bytes(sc::encoding::utf8);
+			std::stringbuf sink_buffer(std::ios_base::out);
+			{
+				sc::transcoding_streambuf buffer(&sink_buffer, sc::encoding::utf16le, sc::encoding::utf8);
+				buffer.sputn(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+				buffer.pubsync();
+			}
+			consume(sink_buffer.view());
+			return bytes.size();
+		} });
+	}
+
+	template <typename CharType>
+	void add_byte_order(std::vector<benchmark> &list)
+	{
+		const auto args = std::string(type_name<CharType>());
+		auto text = std::make_shared<std::basic_string<CharType>>();
+		auto prepare = [text](const corpus &c)
+		{
+			const auto source = c.text<CharType>();
+			text->assign(source.begin(), source.end());
+			return bytes_of(source);
+		};
+		list.push_back({ call_name("change_endian_copy", args), false, [](const corpus &c)
+		{
+			const auto source = c.text<CharType>();
+			consume(sc::change_endian_copy(source));
+			return bytes_of(source);
+		} });
+		list.push_back({ call_name("to_big_endian_copy", args), false, [](const corpus &c)
+		{
+			const auto source = c.text<CharType>();
+			consume(sc::to_big_endian_copy(source));
+			return bytes_of(source);
+		} });
+		list.push_back({ call_name("to_little_endian", args + "_view"), false, [](const corpus &c)
+		{
+			const auto source = c.text<CharType>();
+			consume(sc::to_little_endian(source));
+			return bytes_of(source);
+		} });
+		// The in-place functions swap a copy that is refreshed before each call, and the
+		// refresh is timed too; change_endian_copy() is the reference for its cost.
+		list.push_back({ call_name("change_endian", args + "&"), false, [text, prepare](const corpus &c)
+		{
+			const auto bytes = prepare(c);
+			sc::change_endian(*text);
+			consume(*text);
+			return bytes;
+		} });
+		list.push_back({ call_name("change_endian", std::string(type_name<CharType>()) + " pointer"), false, [text, prepare](const corpus &c)
+		{
+			const auto bytes = prepare(c);
+			sc::change_endian(text->data());
+			consume(*text);
+			return bytes;
+		} });
+		list.push_back({ call_name("change_endian", std::string(type_name<CharType>()) + " pointer, size"), false, [text, prepare](const corpus &c)
+		{
+			const auto bytes = prepare(c);
+			sc::change_endian(text->data(), text->size());
+			consume(*text);
+			return bytes;
+		} });
+		list.push_back({ call_name("to_big_endian", args + "&"), false, [text, prepare](const corpus &c)
+		{
+			const auto bytes = prepare(c);
+			sc::to_big_endian(*text);
+			sc::to_big_endian(text->data());
+			sc::to_big_endian(text->data(), text->size());
+			consume(*text);
+			return bytes;
+		} });
+		list.push_back({ call_name("to_little_endian", args + "&"), false, [text, prepare](const corpus &c)
+		{
+			const auto bytes = prepare(c);
+			sc::to_little_endian(*text);
+			sc::to_little_endian(text->data());
+			sc::to_little_endian(text->data(), text->size());
+			consume(*text);
+			return bytes;
+		} });
+	}
+
+	std::vector<benchmark> all_benchmarks(unsigned int threads)
+	{
+		std::vector<benchmark> list;
+		add_family<char8_t>(list, "utf8",
+			[](auto text) -> decltype(sc::to_utf8(text)) { return sc::to_utf8(text); },
+			[](auto &dst, auto text) -> decltype(sc::assign_utf8(dst, text)) { sc::assign_utf8(dst, text); },
+			[](auto &dst, auto text) -> decltype(sc::append_utf8(dst, text)) { sc::append_utf8(dst, text); });
+		add_family<char16_t>(list, "utf16",
+			[](auto text) -> decltype(sc::to_utf16(text)) { return sc::to_utf16(text); },
+			[](auto &dst, auto text) -> decltype(sc::assign_utf16(dst, text)) { sc::assign_utf16(dst, text); },
+			[](auto &dst, auto text) -> decltype(sc::append_utf16(dst, text)) { sc::append_utf16(dst, text); });
+		add_family<char32_t>(list, "utf32",
+			[](auto text) -> decltype(sc::to_utf32(text)) { return sc::to_utf32(text); },
+			[](auto &dst, auto text) -> decltype(sc::assign_utf32(dst, text)) { sc::assign_utf32(dst, text); },
+			[](auto &dst, auto text) -> decltype(sc::append_utf32(dst, text)) { sc::append_utf32(dst, text); });
+		add_family<char>(list, "string",
+			[](auto text) -> decltype(sc::to_string(text)) { return sc::to_string(text); },
+			[](auto &dst, auto text) -> decltype(sc::assign_string(dst, text)) { sc::assign_string(dst, text); },
+			[](auto &dst, auto text) -> decltype(sc::append_string(dst, text)) { sc::append_string(dst, text); });
+		add_family<wchar_t>(list, "wstring",
+			[](auto text) -> decltype(sc::to_wstring(text)) { return sc::to_wstring(text); },
+			[](auto &dst, auto text) -> decltype(sc::assign_wstring(dst, text)) { sc::assign_wstring(dst, text); },
+			[](auto &dst, auto text) -> decltype(sc::append_wstring(dst, text)) { sc::append_wstring(dst, text); });
+
+		// The same conversions with the UTF-16 or UTF-32 side in the other byte order.
+		const bool swapped = !sc::is_big_endian();
+		list.push_back({ "to_utf8(u16string, swapped)", false, [](const corpus &c)
+		{
+			consume(sc::to_utf8(c.utf16_swapped, !sc::is_big_endian()));
+			return bytes_of<char16_t>(c.utf16_swapped);
+		} });
+		list.push_back({ "to_utf16(u8string, swapped)", false, [swapped](const corpus &c)
+		{
+			consume(sc::to_utf16(c.utf8, swapped));
+			return bytes_of<char8_t>(c.utf8);
+		} });
+		list.push_back({ "to_utf32(u16string, swapped, swapped)", false, [swapped](const corpus &c)
+		{
+			consume(sc::to_utf32(c.utf16_swapped, swapped, swapped));
+			return bytes_of<char16_t>(c.utf16_swapped);
+		} });
+		list.push_back({ "to_string(u16string, swapped)", true, [swapped](const corpus &c)
+		{
+			consume(sc::to_string(c.utf16_swapped, swapped));
+			return bytes_of<char16_t>(c.utf16_swapped);
+		} });
+
+		// Text in a named encoding, without the locale.
+		list.push_back({ "to_utf8(string, GB18030)", false, [](const corpus &c)
+		{
+			consume(sc::to_utf8(c.gb18030, sc::encoding::gb18030));
+			return c.gb18030.size();
+		} });
+		list.push_back({ "to_utf16(string, GB18030)", false, [](const corpus &c)
+		{
+			consume(sc::to_utf16(c.gb18030, sc::encoding::gb18030));
+			return c.gb18030.size();
+		} });
+		list.push_back({ "to_string(u8string, GB18030)", false, [](const corpus &c)
+		{
+			consume(sc::to_string(c.utf8, sc::encoding::gb18030));
+			return bytes_of<char8_t>(c.utf8);
+		} });
+		list.push_back({ "to_string(u16string, GB18030)", false, [](const corpus &c)
+		{
+			consume(sc::to_string(c.utf16, sc::encoding::gb18030));
+			return bytes_of<char16_t>(c.utf16);
+		} });
+
+		list.push_back({ "validate_utf8(u8string)", false, [](const corpus &c)
+		{
+			consume(sc::validate_utf8(c.utf8));
+			return bytes_of<char8_t>(c.utf8);
+		} });
+		list.push_back({ "validate_utf16(u16string)", false, [](const corpus &c)
+		{
+			consume(sc::validate_utf16(c.utf16));
+			return bytes_of<char16_t>(c.utf16);
+		} });
+		list.push_back({ "validate_utf32(u32string)", false, [](const corpus &c)
+		{
+			consume(sc::validate_utf32(c.utf32));
+			return bytes_of<char32_t>(c.utf32);
+		} });
+
+		for_each_unicode_type([&](auto type)
+		{
+			using input_type = typename decltype(type)::type;
+			list.push_back({ call_name("count_code_points", type_name<input_type>()), false, [](const corpus &c)
+			{
+				const auto text = c.text<input_type>();
+				consume(sc::count_code_points(text));
+				return bytes_of(text);
+			} });
+		});
+
+		add_output<char>(list, threads);
+		add_output<wchar_t>(list, threads);
+		add_output<char8_t>(list, threads);
+		add_output<char16_t>(list, threads);
+		add_output<char32_t>(list, threads);
+		add_streams(list);
+		add_bytes(list, threads);
+		add_columns(list);
+		add_streambufs(list);
+		add_byte_order<char16_t>(list);
+		add_byte_order<char32_t>(list);
+		return list;
+	}
+
+	struct code_point_range
+	{
+		char32_t first;
+		char32_t last;
+		unsigned int weight;
+	};
+
+	// Random text over weighted code point ranges, with a space after every few characters.
+	std::u32string generate(const std::vector<code_point_range> &ranges, std::size_t utf8_bytes, std::mt19937 &rng)
+	{
+		std::vector<unsigned int> weights;
+		for (auto &range : ranges)
+		{
+			weights.push_back(range.weight);
+		}
+		std::discrete_distribution<std::size_t> pick(weights.begin(), weights.end());
+		std::u32string text;
+		std::size_t bytes = 0;
+		while (bytes < utf8_bytes)
+		{
+			const auto &range = ranges[pick(rng)];
+			const auto cp = static_cast<char32_t>(range.first + rng() % (range.last - range.first + 1));
+			text.push_back(cp);
+			bytes += cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+			if (rng() % 6 == 0)
+			{
+				text.push_back(U' ');
+				++bytes;
+			}
+		}
+		return text;
+	}
+
+	corpus make_corpus(std::string name, std::u32string text)
+	{
+		corpus c;
+		c.name = std::move(name);
+		c.utf32 = std::move(text);
+		c.utf8 = sc::to_utf8(c.utf32);
+		c.utf16 = sc::to_utf16(c.utf32);
+		c.wide = sc::to_wstring(c.utf32);
+		c.utf16_swapped = sc::change_endian_copy(c.utf16);
+		c.utf32_swapped = sc::change_endian_copy(c.utf32);
+		c.gb18030 = sc::to_string(c.utf32, sc::encoding::gb18030);
+		c.words.push_back(0);
+		c.utf16_words.push_back(0);
+		for (std::size_t i = 0; i < c.utf8.size(); ++i)
+		{
+			if (c.utf8[i] == u8' ' || i + 1 == c.utf8.size())
+			{
+				c.words.push_back(static_cast<std::int64_t>(i + 1));
+			}
+		}
+		for (std::size_t i = 0; i < c.utf16.size(); ++i)
+		{
+			if (c.utf16[i] == u' ' || i + 1 == c.utf16.size())
+			{
+				c.utf16_words.push_back(static_cast<std::int64_t>((i + 1) * sizeof(char16_t)));
+			}
+		}
+		try
+		{
+			c.narrow = sc::to_string(c.utf32);
+			c.has_narrow = true;
+		}
+		catch (const std::exception &)
+		{
+			c.has_narrow = false;
+		}
+		return c;
+	}
+
+	struct corpus_kind
+	{
+		std::string_view name;
+		std::vector<code_point_range> ranges;
+	};
+
+	std::vector<corpus_kind> corpus_kinds(void)
+	{
+		return {
+			{ "ascii", { { U'a', U'z', 20 }, { U'A', U'Z', 2 }, { U'0', U'9', 1 }, { U',', U'.', 1 } } },
+			{ "latin", { { U'a', U'z', 16 }, { 0xE0, 0xFF, 3 }, { 0x100, 0x17F, 1 } } },
+			{ "cjk", { { 0x4E00, 0x9FFF, 20 }, { 0x3001, 0x3002, 2 }, { 0xFF0C, 0xFF0C, 1 } } },
+			{ "emoji", { { 0x1F300, 0x1F5FF, 4 }, { 0x1F600, 0x1F64F, 4 }, { U'a', U'z', 1 } } },
+			{ "mixed", { { U'a', U'z', 8 }, { 0xE0, 0xFF, 2 }, { 0x410, 0x44F, 2 }, { 0x3B1, 0x3C9, 1 }, { 0x4E00, 0x9FFF, 4 }, { 0x1F600, 0x1F64F, 1 } } },
+		};
+	}
+
+	struct options
+	{
+		std::string filter;
+		std::string corpus_filter;
+		std::vector<std::string> files;
+		std::string format = "text";
+		double min_time = 0.02;
+		std::size_t short_size = 32;
+		std::size_t large_size = 4 * 1024 * 1024;
+		unsigned int threads = 0;
+		bool list = false;
+	};
+
+	struct measurement
+	{
+		std::size_t calls;
+		double seconds;
+		std::size_t bytes;
+	};
+
+	// Doubles the number of calls until one batch lasts at least `min_time` seconds.
+	measurement measure(const benchmark &bench, const corpus &c, double min_time)
+	{
+		(void)bench.run(c);
+		for (std::size_t calls = 1;; calls *= 2)
+		{
+			std::size_t bytes = 0;
+			const auto start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < calls; ++i)
+			{
+				bytes += bench.run(c);
+			}
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() >= min_time || calls >= (std::size_t(1) << 40))
+			{
+				return { calls, elapsed.count(), bytes };
+			}
+		}
+	}
+
+	std::string json_string(std::string_view text)
+	{
+		std::string str = "\"";
+		for (auto ch : text)
+		{
+			if (ch == '"' || ch == '\\')
+			{
+				str += '\\';
+			}
+			str += ch;
+		}
+		str += '"';
+		return str;
+	}
+
+	std::string csv_field(std::string_view text)
+	{
+		if (text.find_first_of(",\"") == std::string_view::npos)
+		{
+			return std::string(text);
+		}
+		std::string str = "\"";
+		for (auto ch : text)
+		{
+			if (ch == '"')
+			{
+				str += '"';
+			}
+			str += ch;
+		}
+		str += '"';
+		return str;
+	}
+
+	std::string_view tier_name(sc::kernel_tier tier) noexcept
+	{
+		switch (tier)
+		{
+		case sc::kernel_tier::sse2:
+			return "sse2";
+		case sc::kernel_tier::ssse3:
+			return "ssse3";
+		case sc::kernel_tier::avx2:
+			return "avx2";
+		default:
+			return "scalar";
+		}
+	}
+
+	void report(const options &opts, const benchmark &bench, const corpus &c, const measurement &m)
+	{
+		const double ns_per_call = m.seconds * 1e9 / static_cast<double>(m.calls);
+		const double gb_per_s = static_cast<double>(m.bytes) / m.seconds / 1e9;
+		const auto bytes_per_call = m.bytes / m.calls;
+		const auto tier = tier_name(sc::active_kernel_tier());
+		if (opts.format == "csv")
+		{
+			std::printf("%s,%s,%s,%zu,%zu,%.1f,%.3f\n", csv_field(bench.name).c_str(), csv_field(c.name).c_str(), std::string(tier).c_str(), bytes_per_call, m.calls, ns_per_call, gb_per_s);
+		}
+		else if (opts.format == "json")
+		{
+			std::printf("{\"function\":%s,\"corpus\":%s,\"tier\":\"%s\",\"bytes\":%zu,\"calls\":%zu,\"ns_per_call\":%.1f,\"gb_per_s\":%.3f}\n", json_string(bench.name).c_str(), json_string(c.name).c_str(), std::string(tier).c_str(), bytes_per_call, m.calls, ns_per_call, gb_per_s);
+		}
+		else
+		{
+			std::printf("%-60s %-16s %10zu B %12.1f ns %8.3f GB/s\n", bench.name.c_str(), c.name.c_str(), bytes_per_call, ns_per_call, gb_per_s);
+		}
+		std::fflush(stdout);
+	}
+
+	void usage(void)
+	{
+		std::fputs(
+			"usage: scodecvt_bench [--filter TEXT] [--corpus TEXT] [--file PATH]... [--format text|csv|json]\n"
+			"                      [--min-time SECONDS] [--short UNITS] [--large BYTES] [--threads N]\n"
+			"                      [--tier scalar|sse2|ssse3|avx2] [--list]\n"
+			"Times every function of simple_codecvt.h over generated corpora (ascii, latin, cjk, emoji,\n"
+			"mixed; short and large) and UTF-8 files. --filter and --corpus select by substring.\n", stderr);
+	}
+
+	std::string read_file(const std::string &path)
+	{
+		std::ifstream file(path, std::ios_base::binary);
+		if (!file)
+		{
+			throw std::runtime_error("cannot open " + path);
+		}
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::setlocale(LC_ALL, "");
+	options opts;
+	try
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			auto value = [&](void) -> std::string
+			{
+				if (i + 1 >= argc)
+				{
+					throw std::invalid_argument(std::string(arg) + " needs a value");
+				}
+				return argv[++i];
+			};
+			if (arg == "--filter")
+			{
+				opts.filter = value();
+			}
+			else if (arg == "--corpus")
+			{
+				opts.corpus_filter = value();
+			}
+			else if (arg == "--file")
+			{
+				opts.files.push_back(value());
+			}
+			else if (arg == "--format")
+			{
+				opts.format = value();
+				if (opts.format != "text" && opts.format != "csv" && opts.format != "json")
+				{
+					throw std::invalid_argument("unknown format " + opts.format);
+				}
+			}
+			else if (arg == "--min-time")
+			{
+				opts.min_time = std::stod(value());
+			}
+			else if (arg == "--short")
+			{
+				opts.short_size = std::stoul(value());
+			}
+			else if (arg == "--large")
+			{
+				opts.large_size = std::stoul(value());
+			}
+			else if (arg == "--threads")
+			{
+				opts.threads = static_cast<unsigned int>(std::stoul(value()));
+			}
+			else if (arg == "--tier")
+			{
+				const auto name = value();
+				bool found = false;
+				for (auto tier : { sc::kernel_tier::scalar, sc::kernel_tier::sse2, sc::kernel_tier::ssse3, sc::kernel_tier::avx2 })
+				{
+					if (tier_name(tier) == name)
+					{
+						found = true;
+						if (!sc::set_kernel_tier(tier))
+						{
+							throw std::invalid_argument("this processor or build lacks " + name);
+						}
+					}
+				}
+				if (!found)
+				{
+					throw std::invalid_argument("unknown tier " + name);
+				}
+			}
+			else if (arg == "--list")
+			{
+				opts.list = true;
+			}
+			else
+			{
+				usage();
+				return 2;
+			}
+		}
+
+		const auto benchmarks = all_benchmarks(opts.threads);
+		if (opts.list)
+		{
+			for (auto &bench : benchmarks)
+			{
+				std::printf("%s\n", bench.name.c_str());
+			}
+			return 0;
+		}
+
+		std::vector<corpus> corpora;
+		std::mt19937 rng(20201017);
+		for (auto &kind : corpus_kinds())
+		{
+			corpora.push_back(make_corpus(std::string(kind.name) + "/short", generate(kind.ranges, opts.short_size, rng)));
+			corpora.push_back(make_corpus(std::string(kind.name) + "/large", generate(kind.ranges, opts.large_size, rng)));
+		}
+		for (auto &path : opts.files)
+		{
+			const auto bytes = read_file(path);
+			const std::u8string_view text(reinterpret_cast<const char8_t *>(bytes.data()), bytes.size());
+			if (sc::validate_utf8(text) != text.size())
+			{
+				throw std::invalid_argument(path + " is not valid UTF-8");
+			}
+			corpora.push_back(make_corpus("file:" + path, sc::to_utf32(text)));
+		}
+
+		if (opts.format == "csv")
+		{
+			std::printf("function,corpus,tier,bytes,calls,ns_per_call,gb_per_s\n");
+		}
+		for (auto &c : corpora)
+		{
+			if (c.name.find(opts.corpus_filter) == std::string::npos)
+			{
+				continue;
+			}
+			for (auto &bench : benchmarks)
+			{
+				if (bench.name.find(opts.filter) == std::string::npos || (bench.narrow_input && !c.has_narrow))
+				{
+					continue;
+				}
+				try
+				{
+					report(opts, bench, c, measure(bench, c, opts.min_time));
+				}
+				catch (const std::exception &e)
+				{
+					// e.g. a narrow conversion of text the locale's encoding cannot represent
+					if (opts.format == "text")
+					{
+						std::fprintf(stderr, "%-60s %-16s skipped: %s\n", bench.name.c_str(), c.name.c_str(), e.what());
+					}
+				}
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		std::fprintf(stderr, "scodecvt_bench: %s\n", e.what());
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,495 @@
+﻿#include <scodecvt/simple_codecvt.h>
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <Windows.h>
+#else // _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif // _MSC_VER
+
+namespace sc = simple_codecvt;
+
+namespace
+{
+	struct encoding_name
+	{
+		std::string_view name;
+		sc::encoding value;
+	};
+
+	constexpr encoding_name encoding_names[] =
+	{
+		{ "UTF-8", sc::encoding::utf8 },
+		{ "UTF-16LE", sc::encoding::utf16le },
+		{ "UTF-16BE", sc::encoding::utf16be },
+		{ "UTF-32LE", sc::encoding::utf32le },
+		{ "UTF-32BE", sc::encoding::utf32be },
+		{ "GB18030", sc::encoding::gb18030 },
+		{ "GBK", sc::encoding::gbk },
+		{ "CP936", sc::encoding::gbk },
+		{ "SHIFT_JIS", sc::encoding::shift_jis },
+		{ "CP932", sc::encoding::shift_jis },
+		{ "EUC-JP", sc::encoding::euc_jp },
+		{ "BIG5", sc::encoding::big5 },
+		{ "CP950", sc::encoding::big5 },
+		{ "EUC-KR", sc::encoding::euc_kr },
+		{ "CP949", sc::encoding::euc_kr },
+		{ "ISO-8859-1", sc::encoding::latin1 },
+		{ "LATIN1", sc::encoding::latin1 },
+		{ "ISO-8859-2", sc::encoding::iso8859_2 },
+		{ "ISO-8859-3", sc::encoding::iso8859_3 },
+		{ "ISO-8859-4", sc::encoding::iso8859_4 },
+		{ "ISO-8859-5", sc::encoding::iso8859_5 },
+		{ "ISO-8859-6", sc::encoding::iso8859_6 },
+		{ "ISO-8859-7", sc::encoding::iso8859_7 },
+		{ "ISO-8859-8", sc::encoding::iso8859_8 },
+		{ "ISO-8859-9", sc::encoding::iso8859_9 },
+		{ "ISO-8859-10", sc::encoding::iso8859_10 },
+		{ "ISO-8859-11", sc::encoding::iso8859_11 },
+		{ "ISO-8859-13", sc::encoding::iso8859_13 },
+		{ "ISO-8859-14", sc::encoding::iso8859_14 },
+		{ "ISO-8859-15", sc::encoding::iso8859_15 },
+		{ "ISO-8859-16", sc::encoding::iso8859_16 },
+		{ "WINDOWS-1250", sc::encoding::windows_1250 },
+		{ "CP1250", sc::encoding::windows_1250 },
+		{ "WINDOWS-1251", sc::encoding::windows_1251 },
+		{ "CP1251", sc::encoding::windows_1251 },
+		{ "WINDOWS-1252", sc::encoding::windows_1252 },
+		{ "CP1252", sc::encoding::windows_1252 },
+		{ "WINDOWS-1253", sc::encoding::windows_1253 },
+		{ "CP1253", sc::encoding::windows_1253 },
+		{ "WINDOWS-1254", sc::encoding::windows_1254 },
+		{ "CP1254", sc::encoding::windows_1254 },
+		{ "WINDOWS-1255", sc::encoding::windows_1255 },
+		{ "CP1255", sc::encoding::windows_1255 },
+		{ "WINDOWS-1256", sc::encoding::windows_1256 },
+		{ "CP1256", sc::encoding::windows_1256 },
+		{ "WINDOWS-1257", sc::encoding::windows_1257 },
+		{ "CP1257", sc::encoding::windows_1257 },
+		{ "WINDOWS-1258", sc::encoding::windows_1258 },
+		{ "CP1258", sc::encoding::windows_1258 },
+		{ "KOI8-R", sc::encoding::koi8_r },
+		{ "KOI8-U", sc::encoding::koi8_u },
+	};
+
+	// Compares ignoring case and dashes, so that "utf8", "UTF-8" and "utf-16le" all match.
+	bool same_name(std::string_view lhs, std::string_view rhs)
+	{
+		auto normalize = [](std::string_view name)
+		{
+			std::string str;
+			for (auto ch : name)
+			{
+				if (ch != '-' && ch != '_')
+				{
+					str.push_back(ch >= 'a' && ch <= 'z' ? static_cast<char>(ch - 'a' + 'A') : ch);
+				}
+			}
+			return str;
+		};
+		return normalize(lhs) == normalize(rhs);
+	}
+
+	const encoding_name *find_encoding(std::string_view name)
+	{
+		for (auto &entry : encoding_names)
+		{
+			if (same_name(entry.name, name))
+			{
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	// A whole file mapped into memory, either read-only or created with a given size for writing.
+	// A file created for writing must not be the one `input` maps: truncating it would pull the
+	// pages out from under the input, so that case is refused before the file is touched.
+	class mapped_file
+	{
+	public:
+		explicit mapped_file(const std::string &path);
+		mapped_file(const std::string &path, std::size_t size, const mapped_file &input);
+		mapped_file(const mapped_file &) = delete;
+		mapped_file &operator=(const mapped_file &) = delete;
+		~mapped_file(void);
+
+		char *data(void) const noexcept
+		{
+			return data_;
+		}
+
+		std::size_t size(void) const noexcept
+		{
+			return size_;
+		}
+
+		// Unmaps a file opened for writing and cuts it down to `size` bytes.
+		void close(std::size_t size);
+
+	private:
+		void unmap(void) noexcept;
+
+		char *data_ = nullptr;
+		std::size_t size_ = 0;
+#ifdef _MSC_VER
+		HANDLE file_ = INVALID_HANDLE_VALUE;
+		HANDLE mapping_ = nullptr;
+#else // _MSC_VER
+		int fd_ = -1;
+#endif // _MSC_VER
+	};
+
+	[[noreturn]] void throw_same_file(const std::string &path)
+	{
+		throw std::invalid_argument(path + ": the output is the input file");
+	}
+
+#ifdef _MSC_VER
+	[[noreturn]] void throw_last_error(const std::string &path)
+	{
+		throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path);
+	}
+
+	mapped_file::mapped_file(const std::string &path)
+	{
+		file_ = CreateFileW(sc::to_wstring(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file_ == INVALID_HANDLE_VALUE)
+		{
+			throw_last_error(path);
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file_, &size))
+		{
+			CloseHandle(file_);
+			throw_last_error(path);
+		}
+		if (static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX)
+		{
+			CloseHandle(file_);
+			throw std::system_error(std::make_error_code(std::errc::file_too_large), path);
+		}
+		size_ = static_cast<std::size_t>(size.QuadPart);
+		if (size_ == 0)
+		{
+			return;
+		}
+		mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_ == nullptr || (data_ = static_cast<char *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0))) == nullptr)
+		{
+			const auto error = GetLastError();
+			unmap();
+			CloseHandle(file_);
+			SetLastError(error);
+			throw_last_error(path);
+		}
+	}
+
+	mapped_file::mapped_file(const std::string &path, std::size_t size, const mapped_file &input)
+		: size_(size)
+	{
+		// The input is only shared for reading, so an existing file is first opened without any
+		// access, which sharing does not restrict, to compare its volume and file index.
+		const auto wide_path = sc::to_wstring(path);
+		auto existing = CreateFileW(wide_path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (existing != INVALID_HANDLE_VALUE)
+		{
+			BY_HANDLE_FILE_INFORMATION info, input_info;
+			const bool same = GetFileInformationByHandle(existing, &info) && GetFileInformationByHandle(input.file_, &input_info)
+				&& info.dwVolumeSerialNumber == input_info.dwVolumeSerialNumber
+				&& info.nFileIndexHigh == input_info.nFileIndexHigh && info.nFileIndexLow == input_info.nFileIndexLow;
+			CloseHandle(existing);
+			if (same)
+			{
+				throw_same_file(path);
+			}
+		}
+		file_ = CreateFileW(wide_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_ == INVALID_HANDLE_VALUE)
+		{
+			throw_last_error(path);
+		}
+		if (size_ == 0)
+		{
+			return;
+		}
+		const auto wide_size = static_cast<unsigned long long>(size_);
+		mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(wide_size >> 32), static_cast<DWORD>(wide_size), nullptr);
+		if (mapping_ == nullptr || (data_ = static_cast<char *>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, 0))) == nullptr)
+		{
+			const auto error = GetLastError();
+			unmap();
+			CloseHandle(file_);
+			SetLastError(error);
+			throw_last_error(path);
+		}
+	}
+
+	mapped_file::~mapped_file(void)
+	{
+		unmap();
+		if (file_ != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(file_);
+		}
+	}
+
+	void mapped_file::close(std::size_t size)
+	{
+		unmap();
+		LARGE_INTEGER offset;
+		offset.QuadPart = static_cast<LONGLONG>(size);
+		if (size != size_ && (!SetFilePointerEx(file_, offset, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)))
+		{
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category());
+		}
+		size_ = size;
+	}
+
+	void mapped_file::unmap(void) noexcept
+	{
+		if (data_ != nullptr)
+		{
+			UnmapViewOfFile(data_);
+			data_ = nullptr;
+		}
+		if (mapping_ != nullptr)
+		{
+			CloseHandle(mapping_);
+			mapping_ = nullptr;
+		}
+	}
+#else // _MSC_VER
+	[[noreturn]] void throw_errno(const std::string &path)
+	{
+		throw std::system_error(errno, std::generic_category(), path);
+	}
+
+	mapped_file::mapped_file(const std::string &path)
+	{
+		fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd_ == -1)
+		{
+			throw_errno(path);
+		}
+		struct stat st;
+		if (fstat(fd_, &st) == -1)
+		{
+			const auto error = errno;
+			::close(fd_);
+			errno = error;
+			throw_errno(path);
+		}
+		size_ = static_cast<std::size_t>(st.st_size);
+		if (size_ == 0)
+		{
+			return;
+		}
+		auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+		if (data == MAP_FAILED)
+		{
+			const auto error = errno;
+			::close(fd_);
+			errno = error;
+			throw_errno(path);
+		}
+		data_ = static_cast<char *>(data);
+		madvise(data, size_, MADV_SEQUENTIAL);
+	}
+
+	mapped_file::mapped_file(const std::string &path, std::size_t size, const mapped_file &input)
+		: size_(size)
+	{
+		// Opened without O_TRUNC, so that nothing is lost until it is known not to be the input.
+		fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+		if (fd_ == -1)
+		{
+			throw_errno(path);
+		}
+		struct stat st, input_st;
+		if (fstat(fd_, &st) == -1 || fstat(input.fd_, &input_st) == -1)
+		{
+			const auto error = errno;
+			::close(fd_);
+			errno = error;
+			throw_errno(path);
+		}
+		if (st.st_dev == input_st.st_dev && st.st_ino == input_st.st_ino)
+		{
+			::close(fd_);
+			throw_same_file(path);
+		}
+		void *data = MAP_FAILED;
+		if (ftruncate(fd_, static_cast<off_t>(size_)) == -1 || (size_ != 0 && (data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)) == MAP_FAILED))
+		{
+			const auto error = errno;
+			::close(fd_);
+			errno = error;
+			throw_errno(path);
+		}
+		if (size_ == 0)
+		{
+			return;
+		}
+		data_ = static_cast<char *>(data);
+		madvise(data, size_, MADV_SEQUENTIAL);
+	}
+
+	mapped_file::~mapped_file(void)
+	{
+		unmap();
+		if (fd_ != -1)
+		{
+			::close(fd_);
+			fd_ = -1;
+		}
+	}
+
+	void mapped_file::close(std::size_t size)
+	{
+		unmap();
+		if (size != size_ && ftruncate(fd_, static_cast<off_t>(size)) == -1)
+		{
+			throw std::system_error(errno, std::generic_category());
+		}
+		size_ = size;
+	}
+
+	void mapped_file::unmap(void) noexcept
+	{
+		if (data_ != nullptr)
+		{
+			munmap(data_, size_);
+			data_ = nullptr;
+		}
+	}
+#endif // _MSC_VER
+
+	void print_usage(void)
+	{
+		std::fputs(
+			"usage: scodecvt --from ENCODING --to ENCODING [--threads N] INPUT OUTPUT\n"
+			"\n"
+			"Converts INPUT into OUTPUT through memory mappings and prints throughput to stderr.\n"
+			"--threads converts on N threads, 0 for one per hardware thread (default 1).\n"
+			"Encodings:", stderr);
+		for (auto &entry : encoding_names)
+		{
+			std::fprintf(stderr, " %.*s", static_cast<int>(entry.name.size()), entry.name.data());
+		}
+		std::fputc('\n', stderr);
+	}
+
+	double seconds(std::chrono::steady_clock::duration duration) noexcept
+	{
+		return std::chrono::duration<double>(duration).count();
+	}
+
+	double megabytes_per_second(std::size_t bytes, std::chrono::steady_clock::duration duration) noexcept
+	{
+		const auto elapsed = seconds(duration);
+		return elapsed > 0 ? static_cast<double>(bytes) / elapsed / 1e6 : 0;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const encoding_name *from = nullptr;
+	const encoding_name *to = nullptr;
+	unsigned long threads = 1;
+	std::string paths[2];
+	int path_count = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+		if (arg == "-h" || arg == "--help")
+		{
+			print_usage();
+			return 0;
+		}
+		if (arg == "-j" || arg == "--threads")
+		{
+			char *end = nullptr;
+			if (i + 1 == argc || (threads = std::strtoul(argv[++i], &end, 10), *end != '\0') || threads > UINT_MAX)
+			{
+				print_usage();
+				return 2;
+			}
+		}
+		else if (arg == "-f" || arg == "--from" || arg == "-t" || arg == "--to")
+		{
+			if (i + 1 == argc)
+			{
+				print_usage();
+				return 2;
+			}
+			auto found = find_encoding(argv[++i]);
+			if (found == nullptr)
+			{
+				std::fprintf(stderr, "scodecvt: unsupported encoding %s\n", argv[i]);
+				return 2;
+			}
+			(arg == "-f" || arg == "--from" ? from : to) = found;
+		}
+		else if (path_count < 2)
+		{
+			paths[path_count++] = arg;
+		}
+		else
+		{
+			print_usage();
+			return 2;
+		}
+	}
+	if (from == nullptr || to == nullptr || path_count != 2)
+	{
+		print_usage();
+		return 2;
+	}
+
+	try
+	{
+		using clock = std::chrono::steady_clock;
+
+		const auto start = clock::now();
+		mapped_file input(paths[0]);
+		const std::string_view bytes(input.data(), input.size());
+		const auto size = sc::required_size(bytes, from->value, to->value);
+		const auto measured = clock::now();
+		mapped_file output(paths[1], size, input);
+		const auto rst = sc::parallel_convert_into(bytes, from->value, { output.data(), output.size() }, to->value, static_cast<unsigned int>(threads));
+		output.close(rst.written);
+		const auto converted = clock::now();
+
+		if (rst.status != sc::convert_status::ok)
+		{
+			std::fprintf(stderr, "scodecvt: %s: invalid %.*s input at byte %zu\n", paths[0].c_str(), static_cast<int>(from->name.size()), from->name.data(), rst.read);
+			return 1;
+		}
+		std::fprintf(stderr, "%.*s -> %.*s: %zu bytes -> %zu bytes\n",
+			static_cast<int>(from->name.size()), from->name.data(), static_cast<int>(to->name.size()), to->name.data(), bytes.size(), rst.written);
+		std::fprintf(stderr, "measure %.3f s (%.1f MB/s), convert %.3f s (%.1f MB/s), total %.3f s (%.1f MB/s)\n",
+			seconds(measured - start), megabytes_per_second(bytes.size(), measured - start),
+			seconds(converted - measured), megabytes_per_second(bytes.size(), converted - measured),
+			seconds(converted - start), megabytes_per_second(bytes.size(), converted - start));
+	}
+	catch (const std::exception &e)
+	{
+		std::fprintf(stderr, "scodecvt: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
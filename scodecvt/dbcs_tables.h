@@ -0,0 +1,78 @@
+﻿// Generated by scodecvt/tables/generate_tables.py from CP932.txt, EUC-JP.txt, CP950.txt and
+// CP949.txt, which hold the converters of glibc 2.36.
+// Do not edit by hand: change the mapping files and run python3 scodecvt/tables/generate_tables.py.
+#ifndef __SIMPLE_CODECVT_DBCS_TABLES_H__
+#define __SIMPLE_CODECVT_DBCS_TABLES_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// The tables of the double-byte character sets, laid out as dbcs_codec in table_codecs.h reads them.
+namespace simple_codecvt::detail
+{
+	// Shift_JIS as Windows code page 932.
+	struct shift_jis_table
+	{
+		static constexpr std::uint8_t prefix = 0x00;
+		static constexpr std::uint8_t trail_first = 0x40;
+		static constexpr std::uint8_t trail_last = 0xFC;
+		static constexpr std::size_t row_count = 55;
+		static constexpr std::size_t block_count = 107;
+		static const char16_t single[128];
+		static const std::uint8_t lead_rows[128];
+		static const std::uint8_t prefix_rows[128];
+		static const char16_t rows[row_count][trail_last - trail_first + 1];
+		static const std::uint8_t pages[256];
+		static const std::uint16_t blocks[block_count][256];
+	};
+
+	// EUC-JP with JIS X 0208 and, after the prefix 0x8F, JIS X 0212.
+	struct euc_jp_table
+	{
+		static constexpr std::uint8_t prefix = 0x8F;
+		static constexpr std::uint8_t trail_first = 0xA1;
+		static constexpr std::uint8_t trail_last = 0xFE;
+		static constexpr std::size_t row_count = 146;
+		static constexpr std::size_t block_count = 96;
+		static const char16_t single[128];
+		static const std::uint8_t lead_rows[128];
+		static const std::uint8_t prefix_rows[128];
+		static const char16_t rows[row_count][trail_last - trail_first + 1];
+		static const std::uint8_t pages[256];
+		static const std::uint16_t blocks[block_count][256];
+	};
+
+	// Big5 as Windows code page 950.
+	struct big5_table
+	{
+		static constexpr std::uint8_t prefix = 0x00;
+		static constexpr std::uint8_t trail_first = 0x40;
+		static constexpr std::uint8_t trail_last = 0xFE;
+		static constexpr std::size_t row_count = 89;
+		static constexpr std::size_t block_count = 101;
+		static const char16_t single[128];
+		static const std::uint8_t lead_rows[128];
+		static const std::uint8_t prefix_rows[128];
+		static const char16_t rows[row_count][trail_last - trail_first + 1];
+		static const std::uint8_t pages[256];
+		static const std::uint16_t blocks[block_count][256];
+	};
+
+	// EUC-KR extended to all of Hangul as Windows code page 949.
+	struct euc_kr_table
+	{
+		static constexpr std::uint8_t prefix = 0x00;
+		static constexpr std::uint8_t trail_first = 0x41;
+		static constexpr std::uint8_t trail_last = 0xFE;
+		static constexpr std::size_t row_count = 124;
+		static constexpr std::size_t block_count = 146;
+		static const char16_t single[128];
+		static const std::uint8_t lead_rows[128];
+		static const std::uint8_t prefix_rows[128];
+		static const char16_t rows[row_count][trail_last - trail_first + 1];
+		static const std::uint8_t pages[256];
+		static const std::uint16_t blocks[block_count][256];
+	};
+}
+
+#endif // __SIMPLE_CODECVT_DBCS_TABLES_H__
@@ -0,0 +1,114 @@
+﻿#ifndef __SIMPLE_CODECVT_KERNEL_TABLE_H__
+#define __SIMPLE_CODECVT_KERNEL_TABLE_H__
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include "utf_kernels.h"
+
+namespace simple_codecvt::detail
+{
+	constexpr std::size_t codec_count = 5;
+
+	// Entry points of one build of the kernels. Code units are passed untyped, codecs are
+	// numbered as in codec_index.
+	struct kernel_table
+	{
+		transcode_result (*convert[codec_count][codec_count])(const void *first, const void *last, void *dest, void *dest_last, const recovery *errors) noexcept;
+		std::size_t (*length[codec_count][codec_count])(const void *first, const void *last) noexcept;
+		std::size_t (*recovering_length[codec_count][codec_count])(const void *first, const void *last, const recovery &errors) noexcept;
+		std::size_t (*validate[codec_count])(const void *first, const void *last) noexcept;
+		void (*byteswap16)(const char16_t *first, const char16_t *last, char16_t *dest) noexcept;
+		void (*byteswap32)(const char32_t *first, const char32_t *last, char32_t *dest) noexcept;
+		void (*decode_latin1)(const char8_t *first, const char8_t *last, char16_t *dest) noexcept;
+		std::size_t (*encode_latin1)(const char16_t *first, const char16_t *last, char8_t *dest) noexcept;
+		std::size_t (*decode_single_byte)(const char8_t *first, const char8_t *last, const single_byte_table &table, char16_t *dest) noexcept;
+		std::size_t (*encode_single_byte)(const char16_t *first, const char16_t *last, const single_byte_table &table, char8_t *dest) noexcept;
+	};
+
+	// Each translation unit builds the kernels for one instruction set. They return nullptr
+	// where the target has no such instructions.
+	const kernel_table *scalar_kernels(void) noexcept;
+	const kernel_table *sse2_kernels(void) noexcept;
+	const kernel_table *ssse3_kernels(void) noexcept;
+	const kernel_table *avx2_kernels(void) noexcept;
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	using codec_list = std::tuple<utf8, utf16<false>, utf16<true>, utf32<false>, utf32<true>>;
+
+	template <std::size_t Index>
+	using codec_at = std::tuple_element_t<Index, codec_list>;
+
+	template <typename Codec, std::size_t Index = 0>
+	constexpr std::size_t codec_index(void) noexcept
+	{
+		if constexpr (std::is_same_v<Codec, codec_at<Index>>)
+		{
+			return Index;
+		}
+		else
+		{
+			return codec_index<Codec, Index + 1>();
+		}
+	}
+
+	template <typename From, typename To>
+	transcode_result convert_entry(const void *first, const void *last, void *dest, void *dest_last, const recovery *errors) noexcept
+	{
+		using input_type = const typename From::char_type *;
+		using output_type = typename To::char_type *;
+		return convert<From, To>(static_cast<input_type>(first), static_cast<input_type>(last), static_cast<output_type>(dest), static_cast<output_type>(dest_last), errors);
+	}
+
+	template <typename From, typename To>
+	std::size_t length_entry(const void *first, const void *last) noexcept
+	{
+		using input_type = const typename From::char_type *;
+		return length<From, To>(static_cast<input_type>(first), static_cast<input_type>(last));
+	}
+
+	template <typename From, typename To>
+	std::size_t recovering_length_entry(const void *first, const void *last, const recovery &errors) noexcept
+	{
+		using input_type = const typename From::char_type *;
+		return length<From, To>(static_cast<input_type>(first), static_cast<input_type>(last), errors);
+	}
+
+	template <typename Codec>
+	std::size_t validate_entry(const void *first, const void *last) noexcept
+	{
+		using input_type = const typename Codec::char_type *;
+		return validate<Codec>(static_cast<input_type>(first), static_cast<input_type>(last));
+	}
+
+	template <std::size_t... Pair>
+	constexpr kernel_table make_kernel_table(std::index_sequence<Pair...>) noexcept
+	{
+		kernel_table table{};
+		((table.convert[Pair / codec_count][Pair % codec_count] = convert_entry<codec_at<Pair / codec_count>, codec_at<Pair % codec_count>>), ...);
+		((table.length[Pair / codec_count][Pair % codec_count] = length_entry<codec_at<Pair / codec_count>, codec_at<Pair % codec_count>>), ...);
+		((table.recovering_length[Pair / codec_count][Pair % codec_count] = recovering_length_entry<codec_at<Pair / codec_count>, codec_at<Pair % codec_count>>), ...);
+		table.validate[0] = validate_entry<codec_at<0>>;
+		table.validate[1] = validate_entry<codec_at<1>>;
+		table.validate[2] = validate_entry<codec_at<2>>;
+		table.validate[3] = validate_entry<codec_at<3>>;
+		table.validate[4] = validate_entry<codec_at<4>>;
+		table.byteswap16 = byteswap_copy<char16_t>;
+		table.byteswap32 = byteswap_copy<char32_t>;
+		table.decode_latin1 = decode_latin1;
+		table.encode_latin1 = encode_latin1;
+		table.decode_single_byte = decode_single_byte;
+		table.encode_single_byte = encode_single_byte;
+		return table;
+	}
+
+	constexpr kernel_table make_kernel_table(void) noexcept
+	{
+		return make_kernel_table(std::make_index_sequence<codec_count * codec_count>());
+	}
+}
+
+#endif // __SIMPLE_CODECVT_KERNEL_TABLE_H__
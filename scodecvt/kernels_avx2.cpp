@@ -0,0 +1,22 @@
+﻿// The kernels built for AVX2. Only run them where the processor has it.
+#if defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__
+#define SIMPLE_CODECVT_TARGET_AVX2
+#include "kernel_table.h"
+
+namespace simple_codecvt::detail
+{
+	static constexpr kernel_table avx2_table = make_kernel_table();
+}
+
+const simple_codecvt::detail::kernel_table *simple_codecvt::detail::avx2_kernels(void) noexcept
+{
+	return &avx2_table;
+}
+#else // x86
+#include "kernel_table.h"
+
+const simple_codecvt::detail::kernel_table *simple_codecvt::detail::avx2_kernels(void) noexcept
+{
+	return nullptr;
+}
+#endif // x86
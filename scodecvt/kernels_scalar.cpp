@@ -0,0 +1,13 @@
+﻿// The portable kernels, built without any vector instructions.
+#define SIMPLE_CODECVT_TARGET_SCALAR
+#include "kernel_table.h"
+
+namespace simple_codecvt::detail
+{
+	static constexpr kernel_table scalar_table = make_kernel_table();
+}
+
+const simple_codecvt::detail::kernel_table *simple_codecvt::detail::scalar_kernels(void) noexcept
+{
+	return &scalar_table;
+}
@@ -1,26 +1,334 @@
 ﻿#include "simple_codecvt.h"
+#include "kernel_table.h"
+#include "table_codecs.h"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <list>
+#include <mutex>
 #include <stdexcept>
-#include <memory>
+#include <thread>
 #include <type_traits>
+#include <vector>
+#include <cctype>
+#include <cerrno>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 
 #include <iconv.h>
+#ifndef _MSC_VER
+#include <langinfo.h>
+#endif // _MSC_VER
 
 //#undef _MSC_VER
+namespace simple_codecvt
+{
+	// Appends up to `count` characters that `write` fills in, without zero-filling them first;
+	// `write` returns how many it wrote and must not throw. Capacity grows geometrically, so a
+	// string that is cleared and reused soon stops reallocating. Some standard libraries hand
+	// resize_and_overwrite() callbacks the rounded-up capacity, so `count` is passed on as requested.
+	template <typename CharType, typename Allocator, typename Writer>
+	static void append_with(std::basic_string<CharType, std::char_traits<CharType>, Allocator> &str, std::size_t count, Writer write)
+	{
+		const auto size = str.size();
+		if (count > str.capacity() - size)
+		{
+			str.reserve(std::max(size + count, str.capacity() * 2));
+		}
+#ifdef __cpp_lib_string_resize_and_overwrite
+		str.resize_and_overwrite(size + count, [&write, size, count](CharType *data, std::size_t) noexcept { return size + write(data + size, count); });
+#else // __cpp_lib_string_resize_and_overwrite
+		str.resize(size + count);
+		str.resize(size + write(str.data() + size, count));
+#endif // __cpp_lib_string_resize_and_overwrite
+	}
+}
+
+#if defined _MSC_VER && (defined _M_X64 || defined _M_IX86)
+#include <intrin.h>
+#endif // _MSC_VER
+
+namespace simple_codecvt
+{
+	static bool cpu_supports(kernel_tier tier) noexcept
+	{
+#if defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__
+		switch (tier)
+		{
+#ifdef _MSC_VER
+		case kernel_tier::sse2:
+		case kernel_tier::ssse3:
+		case kernel_tier::avx2:
+		{
+			int info[4] = {};
+			::__cpuid(info, 0);
+			const int max_leaf = info[0];
+			::__cpuid(info, 1);
+			if (tier == kernel_tier::sse2)
+			{
+				return (info[3] & (1 << 26)) != 0;
+			}
+			if (tier == kernel_tier::ssse3)
+			{
+				return (info[2] & (1 << 9)) != 0;
+			}
+			// AVX2 also needs the operating system to save the YMM registers.
+			const bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (::_xgetbv(0) & 6) == 6;
+			if (!avx || max_leaf < 7)
+			{
+				return false;
+			}
+			::__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+		}
+#else // _MSC_VER
+		case kernel_tier::sse2:
+			return __builtin_cpu_supports("sse2");
+		case kernel_tier::ssse3:
+			return __builtin_cpu_supports("ssse3");
+		case kernel_tier::avx2:
+			return __builtin_cpu_supports("avx2");
+#endif // _MSC_VER
+		default:
+			return true;
+		}
+#else // x86
+		return tier == kernel_tier::scalar;
+#endif // x86
+	}
+
+	static const detail::kernel_table *built_kernels(kernel_tier tier) noexcept
+	{
+		switch (tier)
+		{
+		case kernel_tier::sse2:
+			return detail::sse2_kernels();
+		case kernel_tier::ssse3:
+			return detail::ssse3_kernels();
+		case kernel_tier::avx2:
+			return detail::avx2_kernels();
+		default:
+			return detail::scalar_kernels();
+		}
+	}
+
+	static std::atomic<const detail::kernel_table *> active_kernels{ nullptr };
+	static std::atomic<kernel_tier> active_tier{ kernel_tier::scalar };
+
+	static const detail::kernel_table *select_kernels(void) noexcept
+	{
+		static constexpr std::pair<const char *, kernel_tier> names[] = {
+			{ "scalar", kernel_tier::scalar }, { "sse2", kernel_tier::sse2 }, { "ssse3", kernel_tier::ssse3 }, { "avx2", kernel_tier::avx2 },
+		};
+		const char *requested = std::getenv("SIMPLE_CODECVT_KERNELS");
+		if (requested != nullptr)
+		{
+			for (auto &name : names)
+			{
+				if (std::strcmp(requested, name.first) == 0 && set_kernel_tier(name.second))
+				{
+					return active_kernels.load(std::memory_order_acquire);
+				}
+			}
+		}
+		for (auto tier : { kernel_tier::avx2, kernel_tier::ssse3, kernel_tier::sse2, kernel_tier::scalar })
+		{
+			if (set_kernel_tier(tier))
+			{
+				break;
+			}
+		}
+		return active_kernels.load(std::memory_order_acquire);
+	}
+
+	// Picks the kernels when the library is loaded. Conversions that run before, from other
+	// static initializers, pick them on first use.
+	[[maybe_unused]] static const auto *const initial_kernels = select_kernels();
+}
+
+// The UTF kernels as run through the kernel table; same signatures as in utf_kernels.h. Pairs
+// with a table codec run the table loop of this translation unit instead.
+namespace simple_codecvt::kernels
+{
+	static const detail::kernel_table &table(void) noexcept
+	{
+		auto kernels = active_kernels.load(std::memory_order_acquire);
+		return kernels != nullptr ? *kernels : *select_kernels();
+	}
+
+	template <typename From, typename To>
+	static detail::transcode_result convert(const typename From::char_type *first, const typename From::char_type *last, typename To::char_type *dest, typename To::char_type *dest_last, const detail::recovery *errors = nullptr) noexcept
+	{
+		if constexpr (detail::is_table_codec<From> || detail::is_table_codec<To>)
+		{
+			return detail::table_convert<From, To>(first, last, dest, dest_last, errors);
+		}
+		else
+		{
+			return table().convert[detail::codec_index<From>()][detail::codec_index<To>()](first, last, dest, dest_last, errors);
+		}
+	}
+
+	template <typename From, typename To>
+	static std::size_t length(const typename From::char_type *first, const typename From::char_type *last) noexcept
+	{
+		if constexpr (detail::is_table_codec<From> || detail::is_table_codec<To>)
+		{
+			return detail::table_length<From, To>(first, last, nullptr);
+		}
+		else
+		{
+			return table().length[detail::codec_index<From>()][detail::codec_index<To>()](first, last);
+		}
+	}
+
+	template <typename From, typename To>
+	static std::size_t length(const typename From::char_type *first, const typename From::char_type *last, const detail::recovery &errors) noexcept
+	{
+		if constexpr (detail::is_table_codec<From> || detail::is_table_codec<To>)
+		{
+			return detail::table_length<From, To>(first, last, &errors);
+		}
+		else
+		{
+			return table().recovering_length[detail::codec_index<From>()][detail::codec_index<To>()](first, last, errors);
+		}
+	}
+
+	template <typename Codec>
+	static std::size_t validate(const typename Codec::char_type *first, const typename Codec::char_type *last) noexcept
+	{
+		if constexpr (detail::is_table_codec<Codec>)
+		{
+			return detail::table_validate<Codec>(first, last);
+		}
+		else
+		{
+			return table().validate[detail::codec_index<Codec>()](first, last);
+		}
+	}
+
+	static void byteswap_copy(const char16_t *first, const char16_t *last, char16_t *dest) noexcept
+	{
+		table().byteswap16(first, last, dest);
+	}
+
+	static void byteswap_copy(const char32_t *first, const char32_t *last, char32_t *dest) noexcept
+	{
+		table().byteswap32(first, last, dest);
+	}
+
+	// Single-byte code pages to and from UTF-16 in host byte order, up to the first byte or unit
+	// without a counterpart; both return the number converted. Latin-1 widens and narrows.
+	static std::size_t decode_single_byte(const char8_t *first, const char8_t *last, const detail::single_byte_table &code_page, char16_t *dest) noexcept
+	{
+		if (&code_page == detail::latin1_table)
+		{
+			table().decode_latin1(first, last, dest);
+			return static_cast<std::size_t>(last - first);
+		}
+		return table().decode_single_byte(first, last, code_page, dest);
+	}
+
+	static std::size_t encode_single_byte(const char16_t *first, const char16_t *last, const detail::single_byte_table &code_page, char8_t *dest) noexcept
+	{
+		if (&code_page == detail::latin1_table)
+		{
+			return table().encode_latin1(first, last, dest);
+		}
+		return table().encode_single_byte(first, last, code_page, dest);
+	}
+}
+
 #ifdef _MSC_VER
 
 #include <Windows.h>
 
 namespace simple_codecvt
 {
-	template <typename OutputCharType, typename InputCharType>
-	static std::basic_string<OutputCharType> to_multistring(const InputCharType *text, std::size_t size)
+	// Whether the last byte of [first, last) is the lead byte of a double-byte character in the
+	// ANSI code page; `first` has to start a character. Lead bytes may also serve as trail bytes,
+	// so it is the parity of the lead bytes that end the range which tells.
+	static bool ends_in_lead_byte(const char8_t *first, const char8_t *last) noexcept
+	{
+		auto src = last;
+		while (src != first && ::IsDBCSLeadByteEx(CP_ACP, static_cast<BYTE>(src[-1])))
+		{
+			--src;
+		}
+		return (last - src) % 2 != 0;
+	}
+
+	// Calls ascii(first, last) for each ASCII run of the text and other(first, last) for the text
+	// between them, in order. In the ANSI code page the trail byte of a double-byte character may
+	// look like ASCII; it is kept with its lead byte.
+	template <typename Codec, typename Ascii, typename Other>
+	static void for_each_run(const typename Codec::char_type *first, const typename Codec::char_type *last, bool ansi, Ascii ascii, Other other)
+	{
+		for (auto src = first; src != last;)
+		{
+			const auto ascii_last = detail::ascii_prefix<Codec>(src, last);
+			if (ascii_last != src)
+			{
+				ascii(src, ascii_last);
+				src = ascii_last;
+				continue;
+			}
+			auto segment_last = detail::find_ascii_block<Codec>(src + 1, last);
+			if constexpr (std::is_same_v<Codec, detail::utf8>)
+			{
+				if (ansi && segment_last != last && ends_in_lead_byte(src, segment_last))
+				{
+					++segment_last;
+				}
+			}
+			other(src, segment_last);
+			src = segment_last;
+		}
+	}
+
+	// Narrows UTF-16 text in the host byte order. Swapped text is byte-swapped into a buffer on the
+	// stack piece by piece, without splitting surrogate pairs.
+	template <bool Swap>
+	static int narrow_segment(int codepage, const char16_t *first, const char16_t *last, char8_t *dest, std::size_t dest_size) noexcept
+	{
+		if constexpr (!Swap)
+		{
+			return ::WideCharToMultiByte(codepage, 0, reinterpret_cast<const wchar_t *>(first), static_cast<int>(last - first), reinterpret_cast<char *>(dest), static_cast<int>(dest_size), nullptr, nullptr);
+		}
+		else
+		{
+			constexpr std::size_t piece = 256;
+			char16_t buffer[piece];
+			std::size_t written = 0;
+			while (first != last)
+			{
+				auto count = std::min(piece, static_cast<std::size_t>(last - first));
+				kernels::byteswap_copy(first, first + count, buffer);
+				if (first + count != last && (buffer[count - 1] & 0xFC00) == 0xD800)
+				{
+					--count;
+				}
+				const int n = narrow_segment<false>(codepage, buffer, buffer + count, dest == nullptr ? nullptr : dest + written, dest == nullptr ? 0 : dest_size - written);
+				if (n == 0)
+				{
+					return 0;
+				}
+				written += static_cast<std::size_t>(n);
+				first += count;
+			}
+			return static_cast<int>(written);
+		}
+	}
+
+	// ASCII runs are narrowed by the UTF kernels, WideCharToMultiByte() only sees the text between them.
+	template <bool Swap = false, typename OutputCharType, typename Allocator, typename InputCharType>
+	static void append_multistring(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, const InputCharType *text, std::size_t size)
 	{
 		using input_type = InputCharType;
 		using output_type = OutputCharType;
-		using output_string_type = std::basic_string<output_type>;
 		static_assert(std::is_same_v<input_type, wchar_t> || std::is_same_v<input_type, char16_t>, "InputCharType must be wchar_t or char16_t.");
 
 		int codepage = 0;
@@ -37,25 +345,51 @@ namespace simple_codecvt
 			static_assert(false, "OutputCharType must be char or char8_t.");
 		}
 
-		auto pinput = reinterpret_cast<const wchar_t *>(text);
-		auto insize = static_cast<int>(size);
-		int length = ::WideCharToMultiByte(codepage, 0, pinput, insize, nullptr, 0, nullptr, nullptr);
-		if (length == 0)
+		if (size == 0)
 		{
-			throw std::invalid_argument("Invalid Unicode was found in a string.");
+			return;
 		}
-		output_string_type rst(length, 0);
-		::WideCharToMultiByte(codepage, 0, pinput, insize, reinterpret_cast<char *>(rst.data()), static_cast<int>(rst.size()), nullptr, nullptr);
-
-		return rst;
+		auto first = reinterpret_cast<const char16_t *>(text);
+		auto last = first + size;
+		auto segment = [codepage](const char16_t *segment_first, const char16_t *segment_last, char8_t *dest, std::size_t dest_size) noexcept
+		{
+			return narrow_segment<Swap>(codepage, segment_first, segment_last, dest, dest_size);
+		};
+		std::size_t length = 0;
+		for_each_run<detail::utf16<Swap>>(first, last, false, [&](const char16_t *run_first, const char16_t *run_last)
+		{
+			length += static_cast<std::size_t>(run_last - run_first);
+		}, [&](const char16_t *segment_first, const char16_t *segment_last)
+		{
+			const int count = segment(segment_first, segment_last, nullptr, 0);
+			if (count == 0)
+			{
+				throw std::invalid_argument("Invalid Unicode was found in a string.");
+			}
+			length += static_cast<std::size_t>(count);
+		});
+		append_with(str, length, [&](output_type *data, std::size_t size) noexcept
+		{
+			auto dest = reinterpret_cast<char8_t *>(data);
+			auto dst = dest;
+			for_each_run<detail::utf16<Swap>>(first, last, false, [&](const char16_t *run_first, const char16_t *run_last) noexcept
+			{
+				dst = detail::copy_ascii<detail::utf16<Swap>, detail::utf8>(run_first, run_last, dst);
+			}, [&](const char16_t *segment_first, const char16_t *segment_last) noexcept
+			{
+				dst += segment(segment_first, segment_last, dst, size - static_cast<std::size_t>(dst - dest));
+			});
+			return static_cast<std::size_t>(dst - dest);
+		});
 	}
 
-	template <typename OutputCharType, typename InputCharType>
-	static std::basic_string<OutputCharType> to_widestring(const InputCharType *text, std::size_t size)
+	// ASCII runs are widened by the UTF kernels, MultiByteToWideChar() only sees the text between them.
+	// Swapped output is byte-swapped segment by segment while it is still in the cache.
+	template <bool Swap = false, typename OutputCharType, typename Allocator, typename InputCharType>
+	static void append_widestring(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, const InputCharType *text, std::size_t size)
 	{
 		using input_type = InputCharType;
 		using output_type = OutputCharType;
-		using output_string_type = std::basic_string<output_type>;
 		static_assert(std::is_same_v<output_type, wchar_t> || std::is_same_v<output_type, char16_t>, "OutputCharType must be wchar_t or char16_t.");
 
 		int codepage = 0;
@@ -72,554 +406,3510 @@ namespace simple_codecvt
 			static_assert(false, "InputCharType must be char or char8_t.");
 		}
 
-		auto pinput = reinterpret_cast<const char *>(text);
-		auto insize = static_cast<int>(size);
-		int length = ::MultiByteToWideChar(codepage, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, pinput, insize, nullptr, 0);
-		if (length == 0)
+		if (size == 0)
 		{
-			throw std::invalid_argument("The function encounters an invalid input character.");
+			return;
 		}
-		output_string_type rst(length, 0);
-		::MultiByteToWideChar(codepage, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, pinput, insize, reinterpret_cast<wchar_t *>(rst.data()), static_cast<int>(rst.size()));
+		auto first = reinterpret_cast<const char8_t *>(text);
+		auto last = first + size;
+		auto segment = [codepage](const char8_t *segment_first, const char8_t *segment_last, char16_t *dest, std::size_t dest_size) noexcept
+		{
+			return ::MultiByteToWideChar(codepage, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, reinterpret_cast<const char *>(segment_first), static_cast<int>(segment_last - segment_first), reinterpret_cast<wchar_t *>(dest), static_cast<int>(dest_size));
+		};
+		std::size_t length = 0;
+		for_each_run<detail::utf8>(first, last, codepage == CP_ACP, [&](const char8_t *run_first, const char8_t *run_last)
+		{
+			length += static_cast<std::size_t>(run_last - run_first);
+		}, [&](const char8_t *segment_first, const char8_t *segment_last)
+		{
+			const int count = segment(segment_first, segment_last, nullptr, 0);
+			if (count == 0)
+			{
+				throw std::invalid_argument("The function encounters an invalid input character.");
+			}
+			length += static_cast<std::size_t>(count);
+		});
+		append_with(str, length, [&](output_type *data, std::size_t size) noexcept
+		{
+			auto dest = reinterpret_cast<char16_t *>(data);
+			auto dst = dest;
+			for_each_run<detail::utf8>(first, last, codepage == CP_ACP, [&](const char8_t *run_first, const char8_t *run_last) noexcept
+			{
+				dst = detail::copy_ascii<detail::utf8, detail::utf16<Swap>>(run_first, run_last, dst);
+			}, [&](const char8_t *segment_first, const char8_t *segment_last) noexcept
+			{
+				const auto segment_dest = dst;
+				dst += segment(segment_first, segment_last, dst, size - static_cast<std::size_t>(dst - dest));
+				if constexpr (Swap)
+				{
+					kernels::byteswap_copy(segment_dest, dst, segment_dest);
+				}
+			});
+			return static_cast<std::size_t>(dst - dest);
+		});
+	}
 
-		return rst;
+	// The string allocates with `allocator`, rebound to OutputCharType.
+	template <typename OutputCharType, typename InputCharType, typename Allocator>
+	static auto to_widestring(const InputCharType *text, std::size_t size, const Allocator &allocator)
+	{
+		using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<OutputCharType>;
+		std::basic_string<OutputCharType, std::char_traits<OutputCharType>, allocator_type> str(static_cast<allocator_type>(allocator));
+		append_widestring(str, text, size);
+		return str;
 	}
 
-	template <typename OutputCharType>
-	static std::basic_string<OutputCharType> to_utf16string(const char32_t *s, std::size_t n)
+	// MultiByteToWideChar() and WideCharToMultiByte() convert a piece of text whole or fail, so
+	// converting into a caller's buffer goes a piece at a time, small enough for a buffer on the
+	// stack. A piece that fails is converted again a character at a time to find where to stop.
+	constexpr std::size_t pivot_size = 256;
+
+	static int buffer_room(std::size_t size) noexcept
 	{
-		using output_type = OutputCharType;
-		using output_string_type = std::basic_string<output_type>;
-		static_assert(std::is_same_v<output_type, wchar_t> || std::is_same_v<output_type, char16_t>, "OutputCharType must be wchar_t or char16_t.");
+		return static_cast<int>(std::min(size, static_cast<std::size_t>(std::numeric_limits<int>::max())));
+	}
 
-		output_string_type container;
-		container.reserve(n * 2);
+	// End of the character of the ANSI code page that starts at `src`.
+	static const char8_t *ansi_char_last(const char8_t *src, const char8_t *last) noexcept
+	{
+		std::size_t size = 1;
+		if (::GetACP() == CP_UTF8)
+		{
+			size = *src < 0x80 ? 1 : *src < 0xE0 ? 2 : *src < 0xF0 ? 3 : 4;
+		}
+		else if (::IsDBCSLeadByteEx(CP_ACP, static_cast<BYTE>(*src)))
+		{
+			size = 2;
+		}
+		return src + std::min(size, static_cast<std::size_t>(last - src));
+	}
 
-		for (std::size_t i = 0; i < n; ++i)
+	// Widens [first, last) onto [dst, dest_last) and advances `dst` if all of it fits. UTF-16 is
+	// written in place, other encodings go through a buffer on the stack; [first, last) must not
+	// widen to more than pivot_size units.
+	template <typename To>
+	static convert_status widen_piece(const char8_t *first, const char8_t *last, typename To::char_type *&dst, typename To::char_type *dest_last) noexcept
+	{
+		const auto input = reinterpret_cast<const char *>(first);
+		const auto input_size = static_cast<int>(last - first);
+		if constexpr (std::is_same_v<typename To::char_type, char16_t>)
 		{
-			auto c = s[i];
-			if (c < 0x10000)
+			if (dst == dest_last)
 			{
-				container.push_back(static_cast<output_type>(c));
-				continue;
+				return ::MultiByteToWideChar(CP_ACP, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, input, input_size, nullptr, 0) == 0 ? convert_status::invalid_input : convert_status::output_full;
+			}
+			const int count = ::MultiByteToWideChar(CP_ACP, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, input, input_size, reinterpret_cast<wchar_t *>(dst), buffer_room(static_cast<std::size_t>(dest_last - dst)));
+			if (count == 0)
+			{
+				return ::GetLastError() == ERROR_INSUFFICIENT_BUFFER ? convert_status::output_full : convert_status::invalid_input;
+			}
+			if constexpr (!std::is_same_v<To, detail::utf16<false>>)
+			{
+				kernels::byteswap_copy(dst, dst + count, dst);
 			}
-			auto t = c - 0x10000;
-			auto h = (((t << 12) >> 22) + 0xD800);
-			auto l = (((t << 22) >> 22) + 0xDC00);
-			container.push_back(static_cast<output_type>(h));
-			container.push_back(static_cast<output_type>(l));
+			dst += count;
 		}
-
-		return container;
+		else
+		{
+			char16_t pivot[pivot_size];
+			const int count = ::MultiByteToWideChar(CP_ACP, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, input, input_size, reinterpret_cast<wchar_t *>(pivot), static_cast<int>(pivot_size));
+			if (count == 0)
+			{
+				return convert_status::invalid_input;
+			}
+			if (kernels::length<detail::utf16<false>, To>(pivot, pivot + count) > static_cast<std::size_t>(dest_last - dst))
+			{
+				return convert_status::output_full;
+			}
+			dst += kernels::convert<detail::utf16<false>, To>(pivot, pivot + count, dst, dest_last).written;
+		}
+		return convert_status::ok;
 	}
 
-	template <typename InputCharType>
-	static std::u32string to_utf32string(const InputCharType *s, std::size_t n)
+	// Converts the ANSI text of [src, last) into [dst, dest_last), advancing both, the way
+	// iconv_runs() does on the other platforms.
+	template <typename To>
+	static convert_status widen_runs(const char8_t *&src, const char8_t *last, typename To::char_type *&dst, typename To::char_type *dest_last) noexcept
 	{
-		using input_type = InputCharType;
-		static_assert(std::is_same_v<input_type, wchar_t> || std::is_same_v<input_type, char16_t>, "InputCharType must be wchar_t or char16_t.");
-
-		std::u32string container;
-		container.reserve(n);
-
-		for (auto iter = s, last = s + n; iter != last;)
+		while (src != last)
 		{
-			const char16_t prev = *iter;
-			++iter;
-			if (static_cast<std::size_t>(prev - 0xd800) < 2048)
+			const auto ascii_last = detail::ascii_prefix<detail::utf8>(src, last);
+			const auto count = std::min(static_cast<std::size_t>(ascii_last - src), static_cast<std::size_t>(dest_last - dst));
+			dst = detail::copy_ascii<detail::utf8, To>(src, src + count, dst);
+			src += count;
+			if (src != ascii_last)
+			{
+				return convert_status::output_full;
+			}
+			if (src == last)
+			{
+				break;
+			}
+			// Each byte widens to at most one unit, so the piece, with the trail byte it may
+			// take in, fits the stack buffer.
+			auto piece_last = detail::find_ascii_block<detail::utf8>(src + 1, src + std::min(pivot_size - 1, static_cast<std::size_t>(last - src)));
+			if (piece_last != last && ends_in_lead_byte(src, piece_last))
+			{
+				++piece_last;
+			}
+			else if (::GetACP() == CP_UTF8)
 			{
-				if (iter != last)
+				while (piece_last != last && piece_last - src > 1 && (*piece_last & 0xC0) == 0x80)
 				{
-					const char16_t curr = *iter;
-					auto is_high_surrogate = (prev & 0xfffffc00) == 0xd800;
-					auto is_low_surrogate = (curr & 0xfffffc00) == 0xdc00;
-					if (is_high_surrogate && is_low_surrogate)
-					{
-						container.push_back((prev << 10) + curr - 0x35fdc00);
-						++iter;
-						continue;
-					}
+					--piece_last;
 				}
-				throw std::invalid_argument("The function encounters an invalid input character.");
 			}
-			else
+			if (widen_piece<To>(src, piece_last, dst, dest_last) == convert_status::ok)
+			{
+				src = piece_last;
+				continue;
+			}
+			while (src < piece_last)
 			{
-				container.push_back(prev);
+				const auto char_last = ansi_char_last(src, last);
+				const auto status = widen_piece<To>(src, char_last, dst, dest_last);
+				if (status != convert_status::ok)
+				{
+					return status;
+				}
+				src = char_last;
 			}
 		}
-
-		return container;
+		return convert_status::ok;
 	}
-}
-#endif // _MSC_VER
 
-namespace simple_codecvt
-{
-	template <typename OutputCharType, typename InputCharType>
-	static std::basic_string<OutputCharType> iconvert(std::basic_string_view<InputCharType> text, const char *tocode, const char *fromcode)
+	// Narrows [first, last) into the ANSI code page onto [dst, dest_last) and advances `dst` if
+	// all of it fits. UTF-16 in the host byte order is read in place, other encodings go through
+	// a buffer on the stack; [first, last) must not take more than pivot_size UTF-16 units.
+	template <typename From>
+	static convert_status narrow_piece(const typename From::char_type *first, const typename From::char_type *last, char8_t *&dst, char8_t *dest_last) noexcept
 	{
-		using input_type = InputCharType;
-		using output_type = OutputCharType;
-		using input_string_type = std::basic_string<input_type>;
-		using output_string_type = std::basic_string<output_type>;
+		char16_t pivot[pivot_size];
+		const char16_t *wide = pivot;
+		std::size_t wide_size = 0;
+		if constexpr (std::is_same_v<From, detail::utf16<false>>)
+		{
+			wide = first;
+			wide_size = static_cast<std::size_t>(last - first);
+		}
+		else if constexpr (std::is_same_v<From, detail::utf16<true>>)
+		{
+			kernels::byteswap_copy(first, last, pivot);
+			wide_size = static_cast<std::size_t>(last - first);
+		}
+		else
+		{
+			const auto rst = kernels::convert<From, detail::utf16<false>>(first, last, pivot, pivot + pivot_size);
+			if (rst.status != detail::transcode_status::ok)
+			{
+				return convert_status::invalid_input;
+			}
+			wide_size = rst.written;
+		}
+		const auto input = reinterpret_cast<const wchar_t *>(wide);
+		const auto input_size = static_cast<int>(wide_size);
+		if (dst == dest_last)
+		{
+			return ::WideCharToMultiByte(CP_ACP, 0, input, input_size, nullptr, 0, nullptr, nullptr) == 0 ? convert_status::invalid_input : convert_status::output_full;
+		}
+		const int count = ::WideCharToMultiByte(CP_ACP, 0, input, input_size, reinterpret_cast<char *>(dst), buffer_room(static_cast<std::size_t>(dest_last - dst)), nullptr, nullptr);
+		if (count == 0)
+		{
+			return ::GetLastError() == ERROR_INSUFFICIENT_BUFFER ? convert_status::output_full : convert_status::invalid_input;
+		}
+		dst += count;
+		return convert_status::ok;
+	}
 
-		typename input_string_type::size_type outlength = text.size();
-		if constexpr (std::is_same_v<output_type, char> || std::is_same_v<output_type, char8_t>)
+	// End of the code point that starts at `src`, or nullptr if it is invalid. Unpaired
+	// surrogates are left to WideCharToMultiByte(), as in the conversions to std::string.
+	template <typename From>
+	static const typename From::char_type *code_point_last(const typename From::char_type *src, const typename From::char_type *last) noexcept
+	{
+		auto next = src;
+		char32_t cp = 0;
+		if (From::decode(next, last, cp) == detail::transcode_status::ok)
 		{
-			outlength *= 4;
+			return next;
 		}
-		else if constexpr (std::is_same_v<output_type, wchar_t> || std::is_same_v<output_type, char16_t>)
+		if constexpr (std::is_same_v<typename From::char_type, char16_t>)
 		{
-			outlength *= 2;
+			return src + 1;
 		}
-		else if constexpr (!std::is_same_v<output_type, char32_t>)
+		else
 		{
-			static_assert(false, "Character type is illegal.");
+			return nullptr;
 		}
+	}
 
-		auto cvt = iconv_open(tocode, fromcode);
-		if (cvt == reinterpret_cast<iconv_t>(-1))
+	// Converts [src, last) into the ANSI text of [dst, dest_last), advancing both, the way
+	// iconv_runs() does on the other platforms.
+	template <typename From>
+	static convert_status narrow_runs(const typename From::char_type *&src, const typename From::char_type *last, char8_t *&dst, char8_t *dest_last) noexcept
+	{
+		using input_type = typename From::char_type;
+		// A unit of UTF-32 may take two of UTF-16.
+		constexpr std::size_t piece_size = std::is_same_v<input_type, char32_t> ? pivot_size / 2 : pivot_size;
+		while (src != last)
 		{
-			throw std::invalid_argument(std::strerror(errno));
+			const auto ascii_last = detail::ascii_prefix<From>(src, last);
+			const auto count = std::min(static_cast<std::size_t>(ascii_last - src), static_cast<std::size_t>(dest_last - dst));
+			dst = detail::copy_ascii<From, detail::utf8>(src, src + count, dst);
+			src += count;
+			if (src != ascii_last)
+			{
+				return convert_status::output_full;
+			}
+			if (src == last)
+			{
+				break;
+			}
+			// Pieces end on a code point so that only invalid input or a full buffer fails them.
+			auto piece_last = detail::find_ascii_block<From>(src + 1, src + std::min(piece_size, static_cast<std::size_t>(last - src)));
+			if constexpr (std::is_same_v<From, detail::utf8>)
+			{
+				while (piece_last != last && piece_last - src > 1 && (*piece_last & 0xC0) == 0x80)
+				{
+					--piece_last;
+				}
+			}
+			else if constexpr (std::is_same_v<input_type, char16_t>)
+			{
+				const auto unit = piece_last[-1];
+				const auto host = std::is_same_v<From, detail::utf16<true>> ? static_cast<char16_t>(unit << 8 | unit >> 8) : unit;
+				if (piece_last != last && piece_last - src > 1 && (host & 0xFC00) == 0xD800)
+				{
+					--piece_last;
+				}
+			}
+			if (narrow_piece<From>(src, piece_last, dst, dest_last) == convert_status::ok)
+			{
+				src = piece_last;
+				continue;
+			}
+			while (src < piece_last)
+			{
+				const auto char_last = code_point_last<From>(src, last);
+				if (char_last == nullptr)
+				{
+					return convert_status::invalid_input;
+				}
+				const auto status = narrow_piece<From>(src, char_last, dst, dest_last);
+				if (status != convert_status::ok)
+				{
+					return status;
+				}
+				src = char_last;
+			}
 		}
-		std::shared_ptr<void> ptr(cvt, iconv_close);
+		return convert_status::ok;
+	}
 
-		std::basic_string<output_type> ans(outlength, 0);
-		auto pinbuf = reinterpret_cast<const char *>(text.data());
-		auto poutbuf = reinterpret_cast<char *>(ans.data());
-		auto insize = static_cast<size_t>(sizeof(input_type) * text.size());
-		auto outsize = static_cast<size_t>(sizeof(output_type) * outlength);
-		if (iconv(cvt, &pinbuf, &insize, &poutbuf, &outsize) == static_cast<std::size_t>(-1))
+	// Runs `runs(dst, dest_last)` into a buffer on the stack until it stops for anything but a
+	// full buffer, and returns the number of units written; stops counting at invalid input.
+	template <typename OutputCharType, typename Runs>
+	static std::size_t runs_length(Runs runs) noexcept
+	{
+		OutputCharType scratch[1024 / sizeof(OutputCharType)];
+		std::size_t length = 0;
+		auto status = convert_status::output_full;
+		while (status == convert_status::output_full)
 		{
-			throw std::invalid_argument(std::strerror(errno));
+			auto dst = scratch;
+			status = runs(dst, std::end(scratch));
+			length += static_cast<std::size_t>(dst - scratch);
 		}
-		ans.resize(ans.size() - outsize / sizeof(output_type));
-		ans.shrink_to_fit();
+		return length;
+	}
 
-		return ans;
+	// `To` is a kernel codec. On a full buffer or invalid input, everything before `read` has
+	// been converted.
+	template <typename To, typename OutputCharType>
+	static convert_result widen_into(std::string_view text, std::span<OutputCharType> dest) noexcept
+	{
+		const auto first = reinterpret_cast<const char8_t *>(text.data());
+		const auto out = reinterpret_cast<typename To::char_type *>(dest.data());
+		auto src = first;
+		auto dst = out;
+		const auto status = widen_runs<To>(src, first + text.size(), dst, out + dest.size());
+		return { static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - out), status };
 	}
-}
 
-#ifdef _MSC_VER
+	template <typename From, typename InputCharType>
+	static convert_result narrow_into(std::basic_string_view<InputCharType> text, std::span<char> dest) noexcept
+	{
+		const auto first = reinterpret_cast<const typename From::char_type *>(text.data());
+		const auto out = reinterpret_cast<char8_t *>(dest.data());
+		auto src = first;
+		auto dst = out;
+		const auto status = narrow_runs<From>(src, first + text.size(), dst, out + dest.size());
+		return { static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - out), status };
+	}
+
+	template <typename To>
+	static std::size_t widen_length(std::string_view text) noexcept
+	{
+		auto src = reinterpret_cast<const char8_t *>(text.data());
+		const auto last = src + text.size();
+		return runs_length<typename To::char_type>([&](typename To::char_type *&dst, typename To::char_type *dest_last) noexcept
+		{
+			return widen_runs<To>(src, last, dst, dest_last);
+		});
+	}
+
+	template <typename From, typename InputCharType>
+	static std::size_t narrow_length(std::basic_string_view<InputCharType> text) noexcept
+	{
+		auto src = reinterpret_cast<const typename From::char_type *>(text.data());
+		const auto last = src + text.size();
+		return runs_length<char8_t>([&](char8_t *&dst, char8_t *dest_last) noexcept
+		{
+			return narrow_runs<From>(src, last, dst, dest_last);
+		});
+	}
+}
+#endif // _MSC_VER
+
+namespace simple_codecvt
+{
+	// POSIX declares the input buffer of iconv() as `char **`, while some libiconv builds use `const char **`.
+	class iconv_inbuf
+	{
+	public:
+		explicit iconv_inbuf(const char **buf) noexcept : buf_(buf) {}
+		operator const char **() const noexcept { return buf_; }
+		operator char **() const noexcept { return const_cast<char **>(buf_); }
+
+	private:
+		const char **buf_;
+	};
+
+	// Open iconv descriptors of the calling thread, keyed by (tocode, fromcode). iconv_open() has to
+	// parse the names and load the conversion tables, which costs far more than converting a short
+	// string, so descriptors are kept open and only have their shift state reset between uses.
+	class iconv_cache
+	{
+	public:
+		iconv_cache(void) = default;
+		iconv_cache(const iconv_cache &) = delete;
+		iconv_cache &operator=(const iconv_cache &) = delete;
+
+		~iconv_cache(void)
+		{
+			flush();
+		}
+
+		iconv_t acquire(const char *tocode, const char *fromcode)
+		{
+			auto cvt = open(tocode, fromcode);
+			if (cvt == reinterpret_cast<iconv_t>(-1))
+			{
+				throw std::invalid_argument(std::strerror(errno));
+			}
+			return cvt;
+		}
+
+		// Returns iconv_t(-1) with errno set if the pair cannot be opened.
+		iconv_t open(const char *tocode, const char *fromcode)
+		{
+			for (auto &item : entries_)
+			{
+				if (std::strcmp(item.tocode, tocode) == 0 && std::strcmp(item.fromcode, fromcode) == 0)
+				{
+					iconv(item.cvt, nullptr, nullptr, nullptr, nullptr);
+					return item.cvt;
+				}
+			}
+
+			auto cvt = iconv_open(tocode, fromcode);
+			if (cvt == reinterpret_cast<iconv_t>(-1))
+			{
+				return cvt;
+			}
+			try
+			{
+				entries_.push_back({ tocode, fromcode, cvt });
+			}
+			catch (...)
+			{
+				iconv_close(cvt);
+				throw;
+			}
+			return cvt;
+		}
+
+		void flush(void) noexcept
+		{
+			for (auto &item : entries_)
+			{
+				iconv_close(item.cvt);
+			}
+			entries_.clear();
+		}
+
+	private:
+		struct entry
+		{
+			const char *tocode;
+			const char *fromcode;
+			iconv_t cvt;
+		};
+
+		std::vector<entry> entries_;
+	};
+
+	static iconv_cache &thread_iconv_cache(void)
+	{
+		static thread_local iconv_cache cache;
+		return cache;
+	}
+
+	// Converts as much of the input as fits and then writes the closing shift sequence. Returns 0
+	// when done, E2BIG if the output buffer ran out first, or the error of an invalid input.
+	static int iconv_step(iconv_t cvt, const char **inbuf, std::size_t *insize, char **outbuf, std::size_t *outsize) noexcept
+	{
+		if ((*insize != 0 && iconv(cvt, iconv_inbuf(inbuf), insize, outbuf, outsize) == static_cast<std::size_t>(-1))
+			|| iconv(cvt, nullptr, nullptr, outbuf, outsize) == static_cast<std::size_t>(-1))
+		{
+			return errno;
+		}
+		return 0;
+	}
+
+	// Converts [src, segment_last) and writes the closing shift sequence, like iconv_step(). A
+	// segment may stop inside a double-byte character whose trail byte is in the ASCII range;
+	// iconv reports it as incomplete, and the segment then grows a block at a time up to `last`.
+	template <typename From, typename To>
+	static int iconv_segment(iconv_t cvt, const typename From::char_type *&src, const typename From::char_type *&segment_last, const typename From::char_type *last, typename To::char_type *&dst, typename To::char_type *dest_last) noexcept
+	{
+		// glibc asserts on a null output buffer, and a non-ASCII segment never converts to nothing.
+		if (dst == dest_last)
+		{
+			return E2BIG;
+		}
+		for (;;)
+		{
+			auto pinbuf = reinterpret_cast<const char *>(src);
+			auto insize = sizeof(*src) * static_cast<std::size_t>(segment_last - src);
+			auto poutbuf = reinterpret_cast<char *>(dst);
+			auto outsize = sizeof(*dst) * static_cast<std::size_t>(dest_last - dst);
+			const auto error = iconv_step(cvt, &pinbuf, &insize, &poutbuf, &outsize);
+			src = segment_last - insize / sizeof(*src);
+			dst = dest_last - outsize / sizeof(*dst);
+			if (error != EINVAL || segment_last == last)
+			{
+				return error;
+			}
+			segment_last += std::min(static_cast<std::size_t>(last - segment_last), detail::ascii_block);
+		}
+	}
+
+	// Converts [src, last) into [dst, dest_last), advancing both. Runs of ASCII go through the
+	// UTF kernels and iconv only sees the text between them. `From` and `To` are the kernel codecs
+	// of the two sides, detail::utf8 standing in for narrow text. Returns 0 when done, E2BIG if
+	// the output buffer ran out first, or the error of an invalid input.
+	template <typename From, typename To>
+	static int iconv_runs(iconv_t cvt, const typename From::char_type *&src, const typename From::char_type *last, typename To::char_type *&dst, typename To::char_type *dest_last) noexcept
+	{
+		while (src != last)
+		{
+			const auto ascii_last = detail::ascii_prefix<From>(src, last);
+			const auto count = std::min(static_cast<std::size_t>(ascii_last - src), static_cast<std::size_t>(dest_last - dst));
+			dst = detail::copy_ascii<From, To>(src, src + count, dst);
+			src += count;
+			if (src != ascii_last)
+			{
+				return E2BIG;
+			}
+			if (src == last)
+			{
+				break;
+			}
+			auto segment_last = detail::find_ascii_block<From>(src + 1, last);
+			const auto error = iconv_segment<From, To>(cvt, src, segment_last, last, dst, dest_last);
+			if (error != 0)
+			{
+				return error;
+			}
+		}
+		return 0;
+	}
+
+	// Number of units the whole text converts to; stops counting at invalid input.
+	template <typename From, typename To>
+	static std::size_t iconv_length(iconv_t cvt, const typename From::char_type *src, const typename From::char_type *last) noexcept
+	{
+		typename To::char_type scratch[1024 / sizeof(typename To::char_type)];
+		std::size_t length = 0;
+		while (src != last)
+		{
+			const auto ascii_last = detail::ascii_prefix<From>(src, last);
+			length += static_cast<std::size_t>(ascii_last - src);
+			src = ascii_last;
+			if (src == last)
+			{
+				break;
+			}
+			auto segment_last = detail::find_ascii_block<From>(src + 1, last);
+			auto error = E2BIG;
+			while (error == E2BIG)
+			{
+				auto dst = scratch;
+				error = iconv_segment<From, To>(cvt, src, segment_last, last, dst, std::end(scratch));
+				length += static_cast<std::size_t>(dst - scratch);
+			}
+			if (error != 0)
+			{
+				break;
+			}
+		}
+		iconv(cvt, nullptr, nullptr, nullptr, nullptr);
+		return length;
+	}
+
+	// Appends the conversion of `text` to `str`, which is left unchanged if the text is invalid.
+	template <typename From, typename To, typename OutputCharType, typename Allocator, typename InputCharType>
+	static void iconv_append(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::basic_string_view<InputCharType> text, const char *tocode, const char *fromcode)
+	{
+		using input_type = typename From::char_type;
+		using output_type = typename To::char_type;
+		static_assert(sizeof(input_type) == sizeof(InputCharType) && sizeof(output_type) == sizeof(OutputCharType), "Codec does not match the character type.");
+
+		auto cvt = thread_iconv_cache().acquire(tocode, fromcode);
+
+		// Short results are converted once into the stack buffer and copied out. Longer ones are
+		// measured first, so the string grows at most once.
+		output_type scratch[1024 / sizeof(output_type)];
+		const auto first = reinterpret_cast<const input_type *>(text.data());
+		const auto last = first + text.size();
+		auto src = first;
+		auto dst = scratch;
+		const auto error = iconv_runs<From, To>(cvt, src, last, dst, std::end(scratch));
+		if (error == 0)
+		{
+			append_with(str, static_cast<std::size_t>(dst - scratch), [&](OutputCharType *data, std::size_t count) noexcept
+			{
+				std::memcpy(data, scratch, count * sizeof(output_type));
+				return count;
+			});
+			return;
+		}
+		if (error != E2BIG)
+		{
+			throw std::invalid_argument(std::strerror(error));
+		}
+
+		iconv(cvt, nullptr, nullptr, nullptr, nullptr);
+		const auto length = iconv_length<From, To>(cvt, first, last);
+		src = first;
+		const auto size = str.size();
+		auto status = 0;
+		append_with(str, length, [&](OutputCharType *data, std::size_t count) noexcept
+		{
+			auto dest = reinterpret_cast<output_type *>(data);
+			auto out = dest;
+			status = iconv_runs<From, To>(cvt, src, last, out, dest + count);
+			return static_cast<std::size_t>(out - dest);
+		});
+		if (status != 0)
+		{
+			str.resize(size);
+			throw std::invalid_argument(std::strerror(status == E2BIG ? EILSEQ : status));
+		}
+	}
+
+	// `From` and `To` are given in host byte order.
+	template <typename From, typename To, typename OutputCharType, typename Allocator, typename InputCharType>
+	static void iconv_append(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::basic_string_view<InputCharType> text, const char *tocode, const char *fromcode, bool swap_input, bool swap_output)
+	{
+		if (swap_input)
+		{
+			if (swap_output)
+			{
+				iconv_append<detail::swapped_t<From>, detail::swapped_t<To>>(str, text, tocode, fromcode);
+			}
+			else
+			{
+				iconv_append<detail::swapped_t<From>, To>(str, text, tocode, fromcode);
+			}
+		}
+		else if (swap_output)
+		{
+			iconv_append<From, detail::swapped_t<To>>(str, text, tocode, fromcode);
+		}
+		else
+		{
+			iconv_append<From, To>(str, text, tocode, fromcode);
+		}
+	}
+
+	// `From` is given in host byte order; the byte order of the output does not change its size.
+	template <typename From, typename To, typename InputCharType>
+	static std::size_t iconv_required_size(std::basic_string_view<InputCharType> text, const char *tocode, const char *fromcode, bool swap_input = false)
+	{
+		auto cvt = thread_iconv_cache().acquire(tocode, fromcode);
+		if (swap_input)
+		{
+			auto first = reinterpret_cast<const typename detail::swapped_t<From>::char_type *>(text.data());
+			return iconv_length<detail::swapped_t<From>, To>(cvt, first, first + text.size());
+		}
+		auto first = reinterpret_cast<const typename From::char_type *>(text.data());
+		return iconv_length<From, To>(cvt, first, first + text.size());
+	}
+
+	template <typename From, typename To, typename OutputCharType, typename InputCharType>
+	static convert_result iconvert_into(std::basic_string_view<InputCharType> text, std::span<OutputCharType> dest, const char *tocode, const char *fromcode)
+	{
+		auto cvt = thread_iconv_cache().acquire(tocode, fromcode);
+
+		const auto first = reinterpret_cast<const typename From::char_type *>(text.data());
+		const auto out = reinterpret_cast<typename To::char_type *>(dest.data());
+		auto src = first;
+		auto dst = out;
+		const auto error = iconv_runs<From, To>(cvt, src, first + text.size(), dst, out + dest.size());
+		const auto read = static_cast<std::size_t>(src - first);
+		const auto written = static_cast<std::size_t>(dst - out);
+		if (error == 0)
+		{
+			return { read, written, convert_status::ok };
+		}
+		return { read, written, error == E2BIG ? convert_status::output_full : convert_status::invalid_input };
+	}
+
+	// `From` and `To` are given in host byte order.
+	template <typename From, typename To, typename OutputCharType, typename InputCharType>
+	static convert_result iconvert_into(std::basic_string_view<InputCharType> text, std::span<OutputCharType> dest, const char *tocode, const char *fromcode, bool swap_input, bool swap_output)
+	{
+		if (swap_input)
+		{
+			if (swap_output)
+			{
+				return iconvert_into<detail::swapped_t<From>, detail::swapped_t<To>>(text, dest, tocode, fromcode);
+			}
+			return iconvert_into<detail::swapped_t<From>, To>(text, dest, tocode, fromcode);
+		}
+		if (swap_output)
+		{
+			return iconvert_into<From, detail::swapped_t<To>>(text, dest, tocode, fromcode);
+		}
+		return iconvert_into<From, To>(text, dest, tocode, fromcode);
+	}
+
+	// wchar_t holds UTF-16 where it is 16 bits wide and UTF-32 everywhere else.
+	using wide_codec = std::conditional_t<sizeof(wchar_t) == 2, detail::utf16<false>, detail::utf32<false>>;
+
+	template <typename CharType>
+	using unicode_char_t = std::conditional_t<std::is_same_v<CharType, wchar_t>, typename wide_codec::char_type, CharType>;
+
+	// Appends the conversion of `text` to `str`, with invalid input handled by `errors` if given.
+	// Otherwise the conversion stops there, `str` is left unchanged and the offset of the invalid
+	// sequence is returned; npos means success. The output is measured first, so the string
+	// grows at most once.
+	template <typename From, typename To, typename InputCharType, typename OutputCharType, typename Allocator>
+	static std::size_t try_transcode_append(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::basic_string_view<InputCharType> text, const detail::recovery *errors)
+	{
+		using input_type = unicode_char_t<InputCharType>;
+		using output_type = unicode_char_t<OutputCharType>;
+
+		auto first = reinterpret_cast<const input_type *>(text.data());
+		auto last = first + text.size();
+		const auto size = str.size();
+		detail::transcode_result rst{};
+		append_with(str, errors == nullptr ? kernels::length<From, To>(first, last) : kernels::length<From, To>(first, last, *errors), [&](OutputCharType *data, std::size_t count) noexcept
+		{
+			auto dest = reinterpret_cast<output_type *>(data);
+			rst = kernels::convert<From, To>(first, last, dest, dest + count, errors);
+			return rst.written;
+		});
+		if (rst.status != detail::transcode_status::ok)
+		{
+			str.resize(size);
+			return rst.read;
+		}
+		return std::string_view::npos;
+	}
+
+	// Appends the conversion of `text` to `str`, which is left unchanged if the text is invalid.
+	template <typename From, typename To, typename InputCharType, typename OutputCharType, typename Allocator>
+	static void transcode_append(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::basic_string_view<InputCharType> text)
+	{
+		if (try_transcode_append<From, To>(str, text, nullptr) != std::string_view::npos)
+		{
+			throw std::invalid_argument("The function encounters an invalid input character.");
+		}
+	}
+
+	// `From` and `To` are given in host byte order.
+	template <typename From, typename To, typename InputCharType, typename OutputCharType, typename Allocator>
+	static void transcode_append(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::basic_string_view<InputCharType> text, bool swap_input, bool swap_output)
+	{
+		if (swap_input)
+		{
+			if (swap_output)
+			{
+				transcode_append<detail::swapped_t<From>, detail::swapped_t<To>>(str, text);
+			}
+			else
+			{
+				transcode_append<detail::swapped_t<From>, To>(str, text);
+			}
+		}
+		else if (swap_output)
+		{
+			transcode_append<From, detail::swapped_t<To>>(str, text);
+		}
+		else
+		{
+			transcode_append<From, To>(str, text);
+		}
+	}
+
+	template <typename CharType>
+	using codec_t = std::conditional_t<std::is_same_v<CharType, char8_t>, detail::utf8,
+		std::conditional_t<std::is_same_v<CharType, char16_t>, detail::utf16<false>,
+		std::conditional_t<std::is_same_v<CharType, char32_t>, detail::utf32<false>, wide_codec>>>;
+
+	static detail::recovery recovery_for(const error_policy &policy) noexcept
+	{
+		const auto substitute = policy.substitute;
+		const auto valid = substitute <= 0x10FFFF && (substitute & 0xFFFFF800) != 0xD800;
+		return { valid ? substitute : char32_t{ 0xFFFD }, policy.action == error_action::skip };
+	}
+
+	// Conversion to host byte order with invalid input handled by `policy`; `From` is given in
+	// host byte order.
+	template <typename OutputCharType, typename From, typename InputCharType>
+	static conversion<OutputCharType> convert_with(std::basic_string_view<InputCharType> text, const error_policy &policy, bool swap_input)
+	{
+		using to_codec = codec_t<OutputCharType>;
+
+		const auto recovery = recovery_for(policy);
+		const auto errors = policy.action == error_action::raise ? nullptr : &recovery;
+		std::basic_string<OutputCharType> str;
+		const auto error = swap_input
+			? try_transcode_append<detail::swapped_t<From>, to_codec>(str, text, errors)
+			: try_transcode_append<From, to_codec>(str, text, errors);
+		if (error != std::string_view::npos)
+		{
+			return conversion<OutputCharType>(error);
+		}
+		return str;
+	}
+
+	// Runs task(0), ..., task(count - 1) on up to `threads` threads, the calling one included.
+	// If a thread cannot be started, the others take over its share.
+	template <typename Task>
+	static void run_parallel(std::size_t count, unsigned int threads, Task task) noexcept
+	{
+		std::atomic<std::size_t> next = 0;
+		auto work = [&]() noexcept
+		{
+			for (auto i = next++; i < count; i = next++)
+			{
+				task(i);
+			}
+		};
+		std::vector<std::thread> workers;
+		try
+		{
+			workers.reserve(threads - 1);
+			for (unsigned int i = 1; i < threads && i < count; ++i)
+			{
+				workers.emplace_back(work);
+			}
+		}
+		catch (...)
+		{
+		}
+		work();
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	// Piece i of a parallel conversion reads [input[i], input[i + 1]) and writes
+	// [output[i], output[i + 1]). Empty if the text is converted on the calling thread.
+	struct parallel_plan
+	{
+		std::vector<std::size_t> input;
+		std::vector<std::size_t> output;
+		unsigned int threads;
+	};
+
+	// Texts are only split into pieces of at least this many code units.
+	constexpr std::size_t parallel_piece_size = 1 << 16;
+
+	// Splits [first, first + size) at code point boundaries into a few pieces per thread, measures
+	// them concurrently and sums the sizes up into output offsets.
+	template <typename From, typename To>
+	static parallel_plan plan_parallel(const typename From::char_type *first, std::size_t size, unsigned int threads)
+	{
+		parallel_plan plan{};
+		if (threads == 0)
+		{
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		const auto pieces = std::min(std::size_t{ threads } * 4, size / parallel_piece_size);
+		if (threads == 1 || pieces < 2)
+		{
+			return plan;
+		}
+
+		plan.threads = threads;
+		plan.input.reserve(pieces + 1);
+		plan.input.push_back(0);
+		for (std::size_t i = 1; i < pieces; ++i)
+		{
+			// Sequences are at most four units long, anything longer is invalid wherever it is cut.
+			auto pos = size / pieces * i;
+			for (const auto last = pos + 3; pos != last && !From::starts_sequence(first + pos); ++pos)
+			{
+			}
+			plan.input.push_back(pos);
+		}
+		plan.input.push_back(size);
+
+		plan.output.resize(pieces + 1);
+		run_parallel(pieces, threads, [&](std::size_t i) noexcept
+		{
+			plan.output[i + 1] = kernels::length<From, To>(first + plan.input[i], first + plan.input[i + 1]);
+		});
+		for (std::size_t i = 1; i <= pieces; ++i)
+		{
+			plan.output[i] += plan.output[i - 1];
+		}
+		return plan;
+	}
+
+	// Converts every piece of `plan` straight into its place in `dest`. From the first piece that
+	// fails on, the text is converted again on the calling thread, so that the result is the same
+	// as that of a single detail::convert() call.
+	template <typename From, typename To>
+	static detail::transcode_result run_plan(const parallel_plan &plan, const typename From::char_type *first, typename To::char_type *dest) noexcept
+	{
+		const auto pieces = plan.input.size() - 1;
+		std::atomic<std::size_t> failed = pieces;
+		run_parallel(pieces, plan.threads, [&](std::size_t i) noexcept
+		{
+			const auto rst = kernels::convert<From, To>(first + plan.input[i], first + plan.input[i + 1], dest + plan.output[i], dest + plan.output[i + 1]);
+			if (rst.status != detail::transcode_status::ok)
+			{
+				auto current = failed.load();
+				while (i < current && !failed.compare_exchange_weak(current, i))
+				{
+				}
+			}
+		});
+
+		const std::size_t i = failed;
+		if (i == pieces)
+		{
+			return { detail::transcode_status::ok, plan.input.back(), plan.output.back() };
+		}
+		auto rst = kernels::convert<From, To>(first + plan.input[i], first + plan.input.back(), dest + plan.output[i], dest + plan.output.back());
+		rst.read += plan.input[i];
+		rst.written += plan.output[i];
+		return rst;
+	}
+
+	// transcode_append() on several threads for texts that are long enough.
+	template <typename From, typename To, typename InputCharType, typename OutputCharType>
+	static void parallel_append(std::basic_string<OutputCharType> &str, std::basic_string_view<InputCharType> text, unsigned int threads)
+	{
+		using input_type = unicode_char_t<InputCharType>;
+		using output_type = unicode_char_t<OutputCharType>;
+
+		auto first = reinterpret_cast<const input_type *>(text.data());
+		const auto plan = plan_parallel<From, To>(first, text.size(), threads);
+		if (plan.input.empty())
+		{
+			transcode_append<From, To>(str, text);
+			return;
+		}
+
+		const auto size = str.size();
+		auto status = detail::transcode_status::ok;
+		append_with(str, plan.output.back(), [&](OutputCharType *data, std::size_t) noexcept
+		{
+			const auto rst = run_plan<From, To>(plan, first, reinterpret_cast<output_type *>(data));
+			status = rst.status;
+			return rst.written;
+		});
+		if (status != detail::transcode_status::ok)
+		{
+			str.resize(size);
+			throw std::invalid_argument("The function encounters an invalid input character.");
+		}
+	}
+
+	template <typename From, typename To, typename InputCharType, typename OutputCharType>
+	static void parallel_append(std::basic_string<OutputCharType> &str, std::basic_string_view<InputCharType> text, bool swap_input, unsigned int threads)
+	{
+		if (swap_input)
+		{
+			parallel_append<detail::swapped_t<From>, To>(str, text, threads);
+		}
+		else
+		{
+			parallel_append<From, To>(str, text, threads);
+		}
+	}
+
+	// `From` is given in host byte order.
+	template <typename From, typename To, typename InputCharType>
+	static std::size_t measure(std::basic_string_view<InputCharType> text, bool swap_input) noexcept
+	{
+		auto first = reinterpret_cast<const unicode_char_t<InputCharType> *>(text.data());
+		if (swap_input)
+		{
+			return kernels::length<detail::swapped_t<From>, To>(first, first + text.size());
+		}
+		return kernels::length<From, To>(first, first + text.size());
+	}
+
+	template <typename From, typename To, typename InputCharType, typename OutputCharType>
+	static convert_result convert_span(std::basic_string_view<InputCharType> text, std::span<OutputCharType> dest) noexcept
+	{
+		auto first = reinterpret_cast<const unicode_char_t<InputCharType> *>(text.data());
+		auto out = reinterpret_cast<unicode_char_t<OutputCharType> *>(dest.data());
+		const auto rst = kernels::convert<From, To>(first, first + text.size(), out, out + dest.size());
+		switch (rst.status)
+		{
+		case detail::transcode_status::ok:
+			return { rst.read, rst.written, convert_status::ok };
+		case detail::transcode_status::output_full:
+			return { rst.read, rst.written, convert_status::output_full };
+		default:
+			return { rst.read, rst.written, convert_status::invalid_input };
+		}
+	}
+
+	// `From` and `To` are given in host byte order.
+	template <typename From, typename To, typename InputCharType, typename OutputCharType>
+	static convert_result convert_span(std::basic_string_view<InputCharType> text, std::span<OutputCharType> dest, bool swap_input, bool swap_output) noexcept
+	{
+		if (swap_input)
+		{
+			if (swap_output)
+			{
+				return convert_span<detail::swapped_t<From>, detail::swapped_t<To>>(text, dest);
+			}
+			return convert_span<detail::swapped_t<From>, To>(text, dest);
+		}
+		if (swap_output)
+		{
+			return convert_span<From, detail::swapped_t<To>>(text, dest);
+		}
+		return convert_span<From, To>(text, dest);
+	}
+
+	// Appends the conversion of `chunk` to `str`. `pending` holds the start of a sequence that the
+	// previous chunk was cut off in the middle of; on return it holds the cut-off tail of this one.
+	template <typename From, typename To, typename InputCharType, typename OutputCharType>
+	static void stream_append(std::basic_string<OutputCharType> &str, std::basic_string_view<InputCharType> chunk, InputCharType *pending, std::size_t &pending_size)
+	{
+		using input_type = unicode_char_t<InputCharType>;
+		using output_type = unicode_char_t<OutputCharType>;
+		constexpr std::size_t max_units = 4;
+
+		const auto size = str.size();
+		if (pending_size != 0)
+		{
+			input_type units[max_units];
+			const auto take = std::min(chunk.size(), max_units - pending_size);
+			std::memcpy(units, pending, pending_size * sizeof(input_type));
+			std::memcpy(units + pending_size, chunk.data(), take * sizeof(input_type));
+			const input_type *src = units;
+			char32_t cp;
+			const auto status = From::decode(src, units + pending_size + take, cp);
+			if (status == detail::transcode_status::incomplete)
+			{
+				std::memcpy(pending + pending_size, chunk.data(), take * sizeof(input_type));
+				pending_size += take;
+				return;
+			}
+			if (status != detail::transcode_status::ok)
+			{
+				pending_size = 0;
+				throw std::invalid_argument("The function encounters an invalid input character.");
+			}
+			output_type out[max_units];
+			str.append(reinterpret_cast<const OutputCharType *>(out), static_cast<std::size_t>(To::encode(cp, out) - out));
+			chunk.remove_prefix(static_cast<std::size_t>(src - units) - pending_size);
+			pending_size = 0;
+		}
+
+		auto first = reinterpret_cast<const input_type *>(chunk.data());
+		auto last = first + chunk.size();
+		detail::transcode_result rst{};
+		append_with(str, kernels::length<From, To>(first, last), [&](OutputCharType *data, std::size_t count) noexcept
+		{
+			auto dest = reinterpret_cast<output_type *>(data);
+			rst = kernels::convert<From, To>(first, last, dest, dest + count);
+			return rst.written;
+		});
+		if (rst.status == detail::transcode_status::incomplete)
+		{
+			pending_size = chunk.size() - rst.read;
+			std::memcpy(pending, chunk.data() + rst.read, pending_size * sizeof(input_type));
+		}
+		else if (rst.status != detail::transcode_status::ok)
+		{
+			str.resize(size);
+			throw std::invalid_argument("The function encounters an invalid input character.");
+		}
+	}
+
+	// Converts whole units of [first, first + size) into [dest, dest + capacity); `read` and
+	// `written` of the result are in bytes. With `errors`, a trailing partial unit is one more
+	// invalid sequence; without, it is left for the caller.
+	template <typename From, typename To>
+	static detail::transcode_result convert_bytes(const char *first, std::size_t size, char *dest, std::size_t capacity, const detail::recovery *errors) noexcept
+	{
+		using input_type = typename From::char_type;
+		using output_type = typename To::char_type;
+
+		auto src = reinterpret_cast<const input_type *>(first);
+		auto out = reinterpret_cast<output_type *>(dest);
+		const auto out_last = out + capacity / sizeof(output_type);
+		auto rst = kernels::convert<From, To>(src, src + size / sizeof(input_type), out, out_last, errors);
+		rst.read *= sizeof(input_type);
+		if (errors != nullptr && rst.status == detail::transcode_status::ok && rst.read != size)
+		{
+			if (!errors->skip)
+			{
+				const auto substitute = detail::substitute_for<To>(*errors);
+				if (static_cast<std::size_t>(out_last - out) - rst.written < To::length(substitute))
+				{
+					rst.status = detail::transcode_status::output_full;
+					rst.written *= sizeof(output_type);
+					return rst;
+				}
+				rst.written = static_cast<std::size_t>(To::encode(substitute, out + rst.written) - out);
+			}
+			rst.read = size;
+		}
+		rst.written *= sizeof(output_type);
+		return rst;
+	}
+
+	// Output size in bytes of the whole units of [first, first + size), or of what
+	// convert_bytes() writes with `errors`.
+	template <typename From, typename To>
+	static std::size_t length_bytes(const char *first, std::size_t size, const detail::recovery *errors) noexcept
+	{
+		using input_type = typename From::char_type;
+
+		auto src = reinterpret_cast<const input_type *>(first);
+		auto last = src + size / sizeof(input_type);
+		if (errors == nullptr)
+		{
+			return kernels::length<From, To>(src, last) * sizeof(typename To::char_type);
+		}
+		auto length = kernels::length<From, To>(src, last, *errors);
+		if (size % sizeof(input_type) != 0 && !errors->skip)
+		{
+			length += To::length(detail::substitute_for<To>(*errors));
+		}
+		return length * sizeof(typename To::char_type);
+	}
+
+	// convert_bytes() on several threads for inputs that are long enough and an output that
+	// holds all of it. Text in a table codec cannot be split without decoding it from the start,
+	// so it is converted on the calling thread.
+	template <typename From, typename To>
+	static detail::transcode_result parallel_convert_bytes(const char *first, std::size_t size, char *dest, std::size_t capacity, unsigned int threads)
+	{
+		using input_type = typename From::char_type;
+		using output_type = typename To::char_type;
+
+		if constexpr (detail::is_table_codec<From>)
+		{
+			return convert_bytes<From, To>(first, size, dest, capacity, nullptr);
+		}
+		else
+		{
+			auto src = reinterpret_cast<const input_type *>(first);
+			const auto plan = plan_parallel<From, To>(src, size / sizeof(input_type), threads);
+			if (plan.input.empty() || plan.output.back() > capacity / sizeof(output_type))
+			{
+				return convert_bytes<From, To>(first, size, dest, capacity, nullptr);
+			}
+			auto rst = run_plan<From, To>(plan, src, reinterpret_cast<output_type *>(dest));
+			rst.read *= sizeof(input_type);
+			rst.written *= sizeof(output_type);
+			return rst;
+		}
+	}
+
+	// Single-byte code pages convert through UTF-16 in host byte order, in chunks of this many
+	// units, with the converter between UTF-16 and the other side.
+	constexpr std::size_t pivot_units = 1024;
+
+	struct byte_converter
+	{
+		detail::transcode_result (*convert_kernel)(const char *, std::size_t, char *, std::size_t, const detail::recovery *) noexcept;
+		std::size_t (*length_kernel)(const char *, std::size_t, const detail::recovery *) noexcept;
+		detail::transcode_result (*parallel_kernel)(const char *, std::size_t, char *, std::size_t, unsigned int);
+		const detail::single_byte_table *from_table = nullptr;
+		const detail::single_byte_table *to_table = nullptr;
+
+		detail::transcode_result convert(const char *first, std::size_t size, char *dest, std::size_t capacity, const detail::recovery *errors) const noexcept;
+		std::size_t length(const char *first, std::size_t size, const detail::recovery *errors) const noexcept;
+		detail::transcode_result parallel_convert(const char *first, std::size_t size, char *dest, std::size_t capacity, unsigned int threads) const;
+
+	private:
+		template <bool Measure>
+		detail::transcode_result convert_pivot(const char *first, std::size_t size, char *dest, std::size_t capacity, const detail::recovery *errors) const noexcept;
+		detail::transcode_result encode_units(const char16_t *units, std::size_t count, char *dest, std::size_t capacity, const detail::recovery *errors) const noexcept;
+	};
+
+	template <typename From, typename To>
+	constexpr byte_converter byte_converter_for{ convert_bytes<From, To>, length_bytes<From, To>, parallel_convert_bytes<From, To> };
+
+	// The byte of `cp` in `table`, or -1.
+	static int single_byte_for(const detail::single_byte_table &table, char32_t cp) noexcept
+	{
+		if (cp < 0x80)
+		{
+			return static_cast<int>(cp);
+		}
+		if (cp > 0xFFFF)
+		{
+			return -1;
+		}
+		const auto &slot = table.slots[(static_cast<std::uint32_t>(cp) * table.multiplier) >> (32 - detail::single_byte_hash_bits)];
+		return slot.code_point == cp ? slot.byte : -1;
+	}
+
+	// Converts UTF-16 units, which hold whole code points, to the output side; `read` of the
+	// result is in units.
+	detail::transcode_result byte_converter::encode_units(const char16_t *units, std::size_t count, char *dest, std::size_t capacity, const detail::recovery *errors) const noexcept
+	{
+		if (to_table == nullptr)
+		{
+			auto rst = convert_kernel(reinterpret_cast<const char *>(units), count * sizeof(char16_t), dest, capacity, errors);
+			rst.read /= sizeof(char16_t);
+			return rst;
+		}
+		const auto out = reinterpret_cast<char8_t *>(dest);
+		std::size_t read = 0;
+		std::size_t written = 0;
+		while (read != count)
+		{
+			const auto size = std::min(count - read, capacity - written);
+			const auto encoded = kernels::encode_single_byte(units + read, units + read + size, *to_table, out + written);
+			read += encoded;
+			written += encoded;
+			if (read == count)
+			{
+				break;
+			}
+			if (encoded == size)
+			{
+				return { detail::transcode_status::output_full, read, written };
+			}
+			if (errors == nullptr)
+			{
+				return { detail::transcode_status::invalid, read, written };
+			}
+			if (!errors->skip)
+			{
+				if (written == capacity)
+				{
+					return { detail::transcode_status::output_full, read, written };
+				}
+				const auto byte = single_byte_for(*to_table, errors->substitute);
+				out[written++] = static_cast<char8_t>(byte < 0 ? '?' : byte);
+			}
+			read += (units[read] & 0xFC00) == 0xD800 && read + 1 != count && (units[read + 1] & 0xFC00) == 0xDC00 ? 2 : 1;
+		}
+		return { detail::transcode_status::ok, read, written };
+	}
+
+	// Decodes the input side into UTF-16 a chunk at a time and converts each chunk to the output
+	// side, or with `Measure` only counts the output, which is then `written`.
+	template <bool Measure>
+	detail::transcode_result byte_converter::convert_pivot(const char *first, std::size_t size, char *dest, std::size_t capacity, const detail::recovery *errors) const noexcept
+	{
+		char16_t units[pivot_units];
+		[[maybe_unused]] char scratch[pivot_units * 4];
+		std::size_t read = 0;
+		std::size_t written = 0;
+		while (read != size)
+		{
+			std::size_t count = 0;
+			std::size_t consumed = 0;
+			auto status = detail::transcode_status::output_full;
+			if (from_table != nullptr)
+			{
+				const auto src = reinterpret_cast<const char8_t *>(first + read);
+				count = consumed = kernels::decode_single_byte(src, src + std::min(size - read, pivot_units), *from_table, units);
+				if (count == 0)
+				{
+					if (errors == nullptr)
+					{
+						return { detail::transcode_status::invalid, read, written };
+					}
+					consumed = 1;
+					if (!errors->skip)
+					{
+						count = static_cast<std::size_t>(detail::utf16<false>::encode(errors->substitute, units) - units);
+					}
+				}
+			}
+			else
+			{
+				const auto rst = convert_kernel(first + read, size - read, reinterpret_cast<char *>(units), sizeof(units), errors);
+				count = rst.written / sizeof(char16_t);
+				consumed = rst.read;
+				status = rst.status;
+			}
+
+			std::size_t done = 0;
+			auto rst = detail::transcode_result{ detail::transcode_status::ok, 0, 0 };
+			if constexpr (Measure)
+			{
+				while (done != count)
+				{
+					rst = encode_units(units + done, count - done, scratch, sizeof(scratch), errors);
+					done += rst.read;
+					written += rst.written;
+					if (rst.status == detail::transcode_status::invalid)
+					{
+						return { rst.status, read, written };
+					}
+				}
+			}
+			else
+			{
+				rst = encode_units(units, count, dest + written, capacity - written, errors);
+				done = rst.read;
+				written += rst.written;
+			}
+			if (done != count)
+			{
+				// Where in the input the converted units end.
+				if (from_table != nullptr)
+				{
+					read += count == consumed ? done : 0;
+				}
+				else
+				{
+					read += convert_kernel(first + read, size - read, reinterpret_cast<char *>(units), done * sizeof(char16_t), errors).read;
+				}
+				return { rst.status, read, written };
+			}
+			read += consumed;
+			if (status != detail::transcode_status::output_full)
+			{
+				return { status, read, written };
+			}
+		}
+		return { detail::transcode_status::ok, read, written };
+	}
+
+	detail::transcode_result byte_converter::convert(const char *first, std::size_t size, char *dest, std::size_t capacity, const detail::recovery *errors) const noexcept
+	{
+		if (from_table == nullptr && to_table == nullptr)
+		{
+			return convert_kernel(first, size, dest, capacity, errors);
+		}
+
+		// Between a code page and UTF-16 in host byte order, text up to the first character
+		// without a counterpart converts in place, and the pivot takes over from there.
+		const bool utf16_host = convert_kernel == convert_bytes<detail::utf16<false>, detail::utf16<false>>;
+		std::size_t read = 0;
+		std::size_t written = 0;
+		if (utf16_host && to_table == nullptr)
+		{
+			const auto src = reinterpret_cast<const char8_t *>(first);
+			read = kernels::decode_single_byte(src, src + std::min(size, capacity / sizeof(char16_t)), *from_table, reinterpret_cast<char16_t *>(dest));
+			written = read * sizeof(char16_t);
+		}
+		else if (utf16_host && from_table == nullptr && size % sizeof(char16_t) == 0)
+		{
+			const auto src = reinterpret_cast<const char16_t *>(first);
+			written = kernels::encode_single_byte(src, src + std::min(size / sizeof(char16_t), capacity), *to_table, reinterpret_cast<char8_t *>(dest));
+			read = written * sizeof(char16_t);
+		}
+		if (read == size)
+		{
+			return { detail::transcode_status::ok, read, written };
+		}
+		auto rst = convert_pivot<false>(first + read, size - read, dest + written, capacity - written, errors);
+		rst.read += read;
+		rst.written += written;
+		return rst;
+	}
+
+	std::size_t byte_converter::length(const char *first, std::size_t size, const detail::recovery *errors) const noexcept
+	{
+		if (from_table == nullptr && to_table == nullptr)
+		{
+			return length_kernel(first, size, errors);
+		}
+		return convert_pivot<true>(first, size, nullptr, 0, errors).written;
+	}
+
+	detail::transcode_result byte_converter::parallel_convert(const char *first, std::size_t size, char *dest, std::size_t capacity, unsigned int threads) const
+	{
+		if (from_table == nullptr && to_table == nullptr)
+		{
+			return parallel_kernel(first, size, dest, capacity, threads);
+		}
+		return convert(first, size, dest, capacity, nullptr);
+	}
+
+	// Result of a conversion of `size` bytes, of which a trailing partial unit is invalid.
+	static convert_result byte_result(const detail::transcode_result &rst, std::size_t size) noexcept
+	{
+		switch (rst.status)
+		{
+		case detail::transcode_status::ok:
+			if (rst.read == size)
+			{
+				return { rst.read, rst.written, convert_status::ok };
+			}
+			return { rst.read, rst.written, convert_status::invalid_input };
+		case detail::transcode_status::output_full:
+			return { rst.read, rst.written, convert_status::output_full };
+		default:
+			return { rst.read, rst.written, convert_status::invalid_input };
+		}
+	}
+
+	template <typename From>
+	static byte_converter select_converter(encoding to) noexcept
+	{
+		switch (to)
+		{
+		case encoding::utf16le:
+			return byte_converter_for<From, detail::utf16_order<false>>;
+		case encoding::utf16be:
+			return byte_converter_for<From, detail::utf16_order<true>>;
+		case encoding::utf32le:
+			return byte_converter_for<From, detail::utf32_order<false>>;
+		case encoding::utf32be:
+			return byte_converter_for<From, detail::utf32_order<true>>;
+		case encoding::gb18030:
+			return byte_converter_for<From, detail::gb18030>;
+		case encoding::gbk:
+			return byte_converter_for<From, detail::gbk>;
+		case encoding::shift_jis:
+			return byte_converter_for<From, detail::shift_jis>;
+		case encoding::euc_jp:
+			return byte_converter_for<From, detail::euc_jp>;
+		case encoding::big5:
+			return byte_converter_for<From, detail::big5>;
+		case encoding::euc_kr:
+			return byte_converter_for<From, detail::euc_kr>;
+		default:
+			return byte_converter_for<From, detail::utf8>;
+		}
+	}
+
+	static byte_converter select_unit_converter(encoding from, encoding to) noexcept
+	{
+		switch (from)
+		{
+		case encoding::utf16le:
+			return select_converter<detail::utf16_order<false>>(to);
+		case encoding::utf16be:
+			return select_converter<detail::utf16_order<true>>(to);
+		case encoding::utf32le:
+			return select_converter<detail::utf32_order<false>>(to);
+		case encoding::utf32be:
+			return select_converter<detail::utf32_order<true>>(to);
+		case encoding::gb18030:
+			return select_converter<detail::gb18030>(to);
+		case encoding::gbk:
+			return select_converter<detail::gbk>(to);
+		case encoding::shift_jis:
+			return select_converter<detail::shift_jis>(to);
+		case encoding::euc_jp:
+			return select_converter<detail::euc_jp>(to);
+		case encoding::big5:
+			return select_converter<detail::big5>(to);
+		case encoding::euc_kr:
+			return select_converter<detail::euc_kr>(to);
+		default:
+			return select_converter<detail::utf8>(to);
+		}
+	}
+
+	// The table of a single-byte code page, or nullptr.
+	static const detail::single_byte_table *single_byte_table_for(encoding text_encoding) noexcept
+	{
+		const auto index = static_cast<std::size_t>(text_encoding) - static_cast<std::size_t>(encoding::latin1);
+		return index < detail::single_byte_table_count ? &detail::single_byte_tables[index] : nullptr;
+	}
+
+	static byte_converter select_converter(encoding from, encoding to) noexcept
+	{
+		constexpr auto utf16_host = is_big_endian() ? encoding::utf16be : encoding::utf16le;
+		const auto from_table = single_byte_table_for(from);
+		const auto to_table = single_byte_table_for(to);
+		auto converter = select_unit_converter(from_table != nullptr ? utf16_host : from, to_table != nullptr ? utf16_host : to);
+		converter.from_table = from_table;
+		converter.to_table = to_table;
+		return converter;
+	}
+
+	constexpr encoding utf16_encoding(bool is_utf16be) noexcept
+	{
+		return is_utf16be ? encoding::utf16be : encoding::utf16le;
+	}
+
+	constexpr encoding utf32_encoding(bool is_utf32be) noexcept
+	{
+		return is_utf32be ? encoding::utf32be : encoding::utf32le;
+	}
+
+	constexpr encoding wide_encoding = sizeof(wchar_t) == 2 ? utf16_encoding(is_big_endian()) : utf32_encoding(is_big_endian());
+
+	template <typename CharType>
+	static std::string_view as_bytes(std::basic_string_view<CharType> text) noexcept
+	{
+		return { reinterpret_cast<const char *>(text.data()), text.size() * sizeof(CharType) };
+	}
+
+	// Appends the conversion of the whole of `bytes` in one measuring and one converting pass;
+	// `str` is left unchanged if the text is invalid. UTF-8 to UTF-8 is validated and copied.
+	template <typename OutputCharType, typename Allocator>
+	static void append_bytes(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::string_view bytes, encoding from, encoding to)
+	{
+		if (from == encoding::utf8 && to == encoding::utf8)
+		{
+			if (validate(bytes, encoding::utf8) != bytes.size())
+			{
+				throw std::invalid_argument("The function encounters an invalid input character.");
+			}
+			append_with(str, bytes.size(), [&](OutputCharType *data, std::size_t count) noexcept
+			{
+				std::memcpy(data, bytes.data(), count);
+				return count;
+			});
+			return;
+		}
+
+		const auto converter = select_converter(from, to);
+		const auto size = str.size();
+		detail::transcode_result rst{};
+		append_with(str, converter.length(bytes.data(), bytes.size(), nullptr) / sizeof(OutputCharType), [&](OutputCharType *data, std::size_t count) noexcept
+		{
+			rst = converter.convert(bytes.data(), bytes.size(), reinterpret_cast<char *>(data), count * sizeof(OutputCharType), nullptr);
+			return rst.written / sizeof(OutputCharType);
+		});
+		if (byte_result(rst, bytes.size()).status != convert_status::ok)
+		{
+			str.resize(size);
+			throw std::invalid_argument("The function encounters an invalid input character.");
+		}
+	}
+
+	template <typename OutputCharType>
+	static std::basic_string<OutputCharType> convert_bytes_to(std::string_view bytes, encoding from, encoding to)
+	{
+		std::basic_string<OutputCharType> str;
+		append_bytes(str, bytes, from, to);
+		return str;
+	}
+
+#ifndef _MSC_VER
+	// The encoding of narrow strings, from the codeset of the C locale. It is looked up once and
+	// again only on refresh_locale(), rather than by iconv on every iconv_open().
+	struct narrow_charset
+	{
+		std::string codeset;
+		bool native;
+		encoding value;
+	};
+
+	// Codesets converted here rather than by iconv. The ASCII of the C locale only says that no
+	// locale was chosen and is taken as UTF-8. glibc composes combining marks in CP1255 and
+	// CP1258, which the tables here do not, so those stay with iconv.
+	constexpr std::pair<const char *, encoding> native_codesets[] =
+	{
+		{ "UTF-8", encoding::utf8 },
+		{ "ANSI_X3.4-1968", encoding::utf8 },
+		{ "ASCII", encoding::utf8 },
+		{ "GB18030", encoding::gb18030 },
+		{ "EUC-JP", encoding::euc_jp },
+		{ "ISO-8859-1", encoding::latin1 },
+		{ "ISO-8859-2", encoding::iso8859_2 },
+		{ "ISO-8859-3", encoding::iso8859_3 },
+		{ "ISO-8859-4", encoding::iso8859_4 },
+		{ "ISO-8859-5", encoding::iso8859_5 },
+		{ "ISO-8859-6", encoding::iso8859_6 },
+		{ "ISO-8859-7", encoding::iso8859_7 },
+		{ "ISO-8859-8", encoding::iso8859_8 },
+		{ "ISO-8859-9", encoding::iso8859_9 },
+		{ "ISO-8859-10", encoding::iso8859_10 },
+		{ "ISO-8859-11", encoding::iso8859_11 },
+		{ "ISO-8859-13", encoding::iso8859_13 },
+		{ "ISO-8859-14", encoding::iso8859_14 },
+		{ "ISO-8859-15", encoding::iso8859_15 },
+		{ "ISO-8859-16", encoding::iso8859_16 },
+		{ "CP1250", encoding::windows_1250 },
+		{ "CP1251", encoding::windows_1251 },
+		{ "CP1252", encoding::windows_1252 },
+		{ "CP1253", encoding::windows_1253 },
+		{ "CP1254", encoding::windows_1254 },
+		{ "CP1256", encoding::windows_1256 },
+		{ "CP1257", encoding::windows_1257 },
+		{ "KOI8-R", encoding::koi8_r },
+		{ "KOI8-U", encoding::koi8_u },
+	};
+
+	// Compares ignoring case, dashes and underscores, so that "utf8" matches "UTF-8".
+	static bool same_codeset(const char *lhs, const char *rhs) noexcept
+	{
+		for (;; ++lhs, ++rhs)
+		{
+			while (*lhs == '-' || *lhs == '_')
+			{
+				++lhs;
+			}
+			while (*rhs == '-' || *rhs == '_')
+			{
+				++rhs;
+			}
+			if (std::toupper(static_cast<unsigned char>(*lhs)) != std::toupper(static_cast<unsigned char>(*rhs)))
+			{
+				return false;
+			}
+			if (*lhs == '\0')
+			{
+				return true;
+			}
+		}
+	}
+
+	static std::atomic<const narrow_charset *> current_narrow{ nullptr };
+
+	static const narrow_charset &resolve_narrow(void)
+	{
+		// Every codeset seen stays for the life of the process: the iconv descriptors of all
+		// threads are keyed by its name.
+		static std::mutex mutex;
+		static std::list<narrow_charset> resolved;
+
+		const std::string codeset = nl_langinfo(CODESET);
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = std::find_if(resolved.begin(), resolved.end(), [&](const narrow_charset &item) { return item.codeset == codeset; });
+		if (it == resolved.end())
+		{
+			narrow_charset narrow{ codeset, false, encoding::utf8 };
+			for (auto &[name, value] : native_codesets)
+			{
+				if (same_codeset(name, codeset.c_str()))
+				{
+					narrow.native = true;
+					narrow.value = value;
+					break;
+				}
+			}
+			it = resolved.insert(resolved.end(), std::move(narrow));
+		}
+		current_narrow.store(&*it, std::memory_order_release);
+		return *it;
+	}
+
+	static const narrow_charset &locale_narrow_charset(void)
+	{
+		const auto narrow = current_narrow.load(std::memory_order_acquire);
+		return narrow != nullptr ? *narrow : resolve_narrow();
+	}
+
+	// Stands for the narrow encoding among the iconv code names below; compared by address.
+	static constexpr char narrow_code[] = "char";
+
+	static const char *iconv_code(const char *code, const narrow_charset &narrow) noexcept
+	{
+		return code == narrow_code ? narrow.codeset.c_str() : code;
+	}
+
+	static encoding code_encoding(const char *code, const narrow_charset &narrow) noexcept
+	{
+		static constexpr std::pair<const char *, encoding> codes[] =
+		{
+			{ "UTF-16LE", encoding::utf16le }, { "UTF-16BE", encoding::utf16be }, { "UTF-32LE", encoding::utf32le }, { "UTF-32BE", encoding::utf32be }, { "wchar_t", wide_encoding },
+		};
+		if (code == narrow_code)
+		{
+			return narrow.value;
+		}
+		for (auto &[name, value] : codes)
+		{
+			if (std::strcmp(code, name) == 0)
+			{
+				return value;
+			}
+		}
+		return encoding::utf8;
+	}
+
+	// The iconv functions for text with a narrow side, which convert natively where the locale's
+	// encoding has an engine here. `swaps` are passed on to iconv as they are; natively, the
+	// code names give the byte order.
+	template <typename From, typename To, typename OutputCharType, typename Allocator, typename InputCharType, typename... Swaps>
+	static void narrow_append(std::basic_string<OutputCharType, std::char_traits<OutputCharType>, Allocator> &str, std::basic_string_view<InputCharType> text, const char *tocode, const char *fromcode, Swaps... swaps)
+	{
+		const auto &narrow = locale_narrow_charset();
+		if (!narrow.native)
+		{
+			iconv_append<From, To>(str, text, iconv_code(tocode, narrow), iconv_code(fromcode, narrow), swaps...);
+			return;
+		}
+		append_bytes(str, as_bytes(text), code_encoding(fromcode, narrow), code_encoding(tocode, narrow));
+	}
+
+	template <typename From, typename To, typename InputCharType>
+	static std::size_t narrow_required_size(std::basic_string_view<InputCharType> text, const char *tocode, const char *fromcode, bool swap_input = false)
+	{
+		const auto &narrow = locale_narrow_charset();
+		if (!narrow.native)
+		{
+			return iconv_required_size<From, To>(text, iconv_code(tocode, narrow), iconv_code(fromcode, narrow), swap_input);
+		}
+		const auto bytes = as_bytes(text);
+		return select_converter(code_encoding(fromcode, narrow), code_encoding(tocode, narrow)).length(bytes.data(), bytes.size(), nullptr) / sizeof(typename To::char_type);
+	}
+
+	template <typename From, typename To, typename OutputCharType, typename InputCharType, typename... Swaps>
+	static convert_result narrow_convert_into(std::basic_string_view<InputCharType> text, std::span<OutputCharType> dest, const char *tocode, const char *fromcode, Swaps... swaps)
+	{
+		const auto &narrow = locale_narrow_charset();
+		if (!narrow.native)
+		{
+			return iconvert_into<From, To>(text, dest, iconv_code(tocode, narrow), iconv_code(fromcode, narrow), swaps...);
+		}
+		const auto bytes = as_bytes(text);
+		const auto converter = select_converter(code_encoding(fromcode, narrow), code_encoding(tocode, narrow));
+		auto rst = byte_result(converter.convert(bytes.data(), bytes.size(), reinterpret_cast<char *>(dest.data()), dest.size_bytes(), nullptr), bytes.size());
+		rst.read /= sizeof(InputCharType);
+		rst.written /= sizeof(OutputCharType);
+		return rst;
+	}
+#endif // _MSC_VER
+
+	// The conversion behind each to_, assign_ and append_ function, for strings of any allocator,
+	// so that the std::pmr overloads share it with the std::allocator ones.
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char8_t, std::char_traits<char8_t>, Allocator> &dst, std::string_view text)
+	{
+		auto tmp = to_widestring<wchar_t>(text.data(), text.size(), dst.get_allocator());
+		append_multistring(dst, tmp.data(), tmp.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char8_t, std::char_traits<char8_t>, Allocator> &dst, std::string_view text)
+	{
+		narrow_append<detail::utf8, detail::utf8>(dst, text, "UTF-8", narrow_code);
+	}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char8_t, std::char_traits<char8_t>, Allocator> &dst, std::wstring_view text)
+	{
+		append_multistring(dst, text.data(), text.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char8_t, std::char_traits<char8_t>, Allocator> &dst, std::wstring_view text)
+	{
+		transcode_append<wide_codec, detail::utf8>(dst, text);
+	}
+#endif // _MSC_VER
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char8_t, std::char_traits<char8_t>, Allocator> &dst, std::u16string_view text, bool is_utf16be)
+	{
+		transcode_append<detail::utf16<false>, detail::utf8>(dst, text, is_utf16be != is_big_endian(), false);
+	}
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char8_t, std::char_traits<char8_t>, Allocator> &dst, std::u32string_view text, bool is_utf32be)
+	{
+		transcode_append<detail::utf32<false>, detail::utf8>(dst, text, is_utf32be != is_big_endian(), false);
+	}
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char16_t, std::char_traits<char16_t>, Allocator> &dst, std::string_view text, bool is_utf16be)
+	{
+		if (is_utf16be != is_big_endian())
+		{
+			append_widestring<true>(dst, text.data(), text.size());
+		}
+		else
+		{
+			append_widestring(dst, text.data(), text.size());
+		}
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char16_t, std::char_traits<char16_t>, Allocator> &dst, std::string_view text, bool is_utf16be)
+	{
+		narrow_append<detail::utf8, detail::utf16<false>>(dst, text, is_utf16be ? "UTF-16BE" : "UTF-16LE", narrow_code, false, is_utf16be != is_big_endian());
+	}
+#endif // _MSC_VER
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char16_t, std::char_traits<char16_t>, Allocator> &dst, std::wstring_view text, bool is_utf16be)
+	{
+		transcode_append<wide_codec, detail::utf16<false>>(dst, text, false, is_utf16be != is_big_endian());
+	}
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char16_t, std::char_traits<char16_t>, Allocator> &dst, std::u8string_view text, bool is_utf16be)
+	{
+		transcode_append<detail::utf8, detail::utf16<false>>(dst, text, false, is_utf16be != is_big_endian());
+	}
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char16_t, std::char_traits<char16_t>, Allocator> &dst, std::u32string_view text, bool is_utf32be, bool is_utf16be)
+	{
+		transcode_append<detail::utf32<false>, detail::utf16<false>>(dst, text, is_utf32be != is_big_endian(), is_utf16be != is_big_endian());
+	}
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char32_t, std::char_traits<char32_t>, Allocator> &dst, std::string_view text, bool is_utf32be)
+	{
+		auto tmp = to_widestring<char16_t>(text.data(), text.size(), dst.get_allocator());
+		transcode_append<detail::utf16<false>, detail::utf32<false>>(dst, std::u16string_view(tmp), false, is_utf32be != is_big_endian());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char32_t, std::char_traits<char32_t>, Allocator> &dst, std::string_view text, bool is_utf32be)
+	{
+		narrow_append<detail::utf8, detail::utf32<false>>(dst, text, is_utf32be ? "UTF-32BE" : "UTF-32LE", narrow_code, false, is_utf32be != is_big_endian());
+	}
+#endif // _MSC_VER
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char32_t, std::char_traits<char32_t>, Allocator> &dst, std::wstring_view text, bool is_utf32be)
+	{
+		transcode_append<wide_codec, detail::utf32<false>>(dst, text, false, is_utf32be != is_big_endian());
+	}
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char32_t, std::char_traits<char32_t>, Allocator> &dst, std::u8string_view text, bool is_utf32be)
+	{
+		transcode_append<detail::utf8, detail::utf32<false>>(dst, text, false, is_utf32be != is_big_endian());
+	}
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char32_t, std::char_traits<char32_t>, Allocator> &dst, std::u16string_view text, bool is_utf16be, bool is_utf32be)
+	{
+		transcode_append<detail::utf16<false>, detail::utf32<false>>(dst, text, is_utf16be != is_big_endian(), is_utf32be != is_big_endian());
+	}
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::wstring_view text)
+	{
+		append_multistring(dst, text.data(), text.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::wstring_view text)
+	{
+		narrow_append<wide_codec, detail::utf8>(dst, text, narrow_code, "wchar_t");
+	}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::u8string_view text)
+	{
+		auto tmp = to_widestring<wchar_t>(text.data(), text.size(), dst.get_allocator());
+		append_multistring(dst, tmp.data(), tmp.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::u8string_view text)
+	{
+		narrow_append<detail::utf8, detail::utf8>(dst, text, narrow_code, "UTF-8");
+	}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::u16string_view text, bool is_utf16be)
+	{
+		if (is_utf16be != is_big_endian())
+		{
+			append_multistring<true>(dst, text.data(), text.size());
+		}
+		else
+		{
+			append_multistring(dst, text.data(), text.size());
+		}
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::u16string_view text, bool is_utf16be)
+	{
+		narrow_append<detail::utf16<false>, detail::utf8>(dst, text, narrow_code, is_utf16be ? "UTF-16BE" : "UTF-16LE", is_utf16be != is_big_endian(), false);
+	}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::u32string_view text, bool is_utf32be)
+	{
+		using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<wchar_t>;
+		std::basic_string<wchar_t, std::char_traits<wchar_t>, allocator_type> tmp(static_cast<allocator_type>(dst.get_allocator()));
+		transcode_append<detail::utf32<false>, wide_codec>(tmp, text, is_utf32be != is_big_endian(), false);
+		append_multistring(dst, tmp.data(), tmp.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<char, std::char_traits<char>, Allocator> &dst, std::u32string_view text, bool is_utf32be)
+	{
+		narrow_append<detail::utf32<false>, detail::utf8>(dst, text, narrow_code, is_utf32be ? "UTF-32BE" : "UTF-32LE", is_utf32be != is_big_endian(), false);
+	}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<wchar_t, std::char_traits<wchar_t>, Allocator> &dst, std::string_view text)
+	{
+		append_widestring(dst, text.data(), text.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<wchar_t, std::char_traits<wchar_t>, Allocator> &dst, std::string_view text)
+	{
+		narrow_append<detail::utf8, wide_codec>(dst, text, "wchar_t", narrow_code);
+	}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<wchar_t, std::char_traits<wchar_t>, Allocator> &dst, std::u8string_view text)
+	{
+		append_widestring(dst, text.data(), text.size());
+	}
+#else // _MSC_VER
+	template <typename Allocator>
+	static void append_converted(std::basic_string<wchar_t, std::char_traits<wchar_t>, Allocator> &dst, std::u8string_view text)
+	{
+		transcode_append<detail::utf8, wide_codec>(dst, text);
+	}
+#endif // _MSC_VER
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<wchar_t, std::char_traits<wchar_t>, Allocator> &dst, std::u16string_view text, bool is_utf16be)
+	{
+		transcode_append<detail::utf16<false>, wide_codec>(dst, text, is_utf16be != is_big_endian(), false);
+	}
+
+	template <typename Allocator>
+	static void append_converted(std::basic_string<wchar_t, std::char_traits<wchar_t>, Allocator> &dst, std::u32string_view text, bool is_utf32be)
+	{
+		transcode_append<detail::utf32<false>, wide_codec>(dst, text, is_utf32be != is_big_endian(), false);
+	}
+
+	template <typename String, typename... Args>
+	static String make_converted(String str, Args... args)
+	{
+		append_converted(str, args...);
+		return str;
+	}
+
+	template <typename String, typename... Args>
+	static void assign_converted(String &dst, Args... args)
+	{
+		dst.clear();
+		append_converted(dst, args...);
+	}
+}
+
 std::u8string simple_codecvt::to_utf8(std::string_view text)
 {
-	auto tmp = to_widestring<wchar_t>(text.data(), text.size());
-	return to_multistring<char8_t>(tmp.data(), tmp.size());
+	return make_converted(std::u8string(), text);
+}
+
+void simple_codecvt::assign_utf8(std::u8string &dst, std::string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_utf8(std::u8string &dst, std::string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::pmr::u8string simple_codecvt::to_utf8(std::string_view text, std::pmr::memory_resource *resource)
+{
+	return make_converted(std::pmr::u8string(resource), text);
+}
+
+void simple_codecvt::assign_utf8(std::pmr::u8string &dst, std::string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_utf8(std::pmr::u8string &dst, std::string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::u8string simple_codecvt::to_utf8(std::wstring_view text)
+{
+	return make_converted(std::u8string(), text);
+}
+
+void simple_codecvt::assign_utf8(std::u8string &dst, std::wstring_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_utf8(std::u8string &dst, std::wstring_view text)
+{
+	append_converted(dst, text);
+}
+
+std::pmr::u8string simple_codecvt::to_utf8(std::wstring_view text, std::pmr::memory_resource *resource)
+{
+	return make_converted(std::pmr::u8string(resource), text);
+}
+
+void simple_codecvt::assign_utf8(std::pmr::u8string &dst, std::wstring_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_utf8(std::pmr::u8string &dst, std::wstring_view text)
+{
+	append_converted(dst, text);
+}
+
+std::u8string simple_codecvt::to_utf8(std::u16string_view text, bool is_utf16be)
+{
+	return make_converted(std::u8string(), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf8(std::u8string &dst, std::u16string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf8(std::u8string &dst, std::u16string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::pmr::u8string simple_codecvt::to_utf8(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be)
+{
+	return make_converted(std::pmr::u8string(resource), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf8(std::pmr::u8string &dst, std::u16string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf8(std::pmr::u8string &dst, std::u16string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::u8string simple_codecvt::to_utf8(std::u32string_view text, bool is_utf32be)
+{
+	return make_converted(std::u8string(), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf8(std::u8string &dst, std::u32string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf8(std::u8string &dst, std::u32string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::pmr::u8string simple_codecvt::to_utf8(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be)
+{
+	return make_converted(std::pmr::u8string(resource), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf8(std::pmr::u8string &dst, std::u32string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf8(std::pmr::u8string &dst, std::u32string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::u16string simple_codecvt::to_utf16(std::string_view text, bool is_utf16be)
+{
+	return make_converted(std::u16string(), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::u16string &dst, std::string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::u16string &dst, std::string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::pmr::u16string simple_codecvt::to_utf16(std::string_view text, std::pmr::memory_resource *resource, bool is_utf16be)
+{
+	return make_converted(std::pmr::u16string(resource), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::pmr::u16string &dst, std::string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::pmr::u16string &dst, std::string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::u16string simple_codecvt::to_utf16(std::wstring_view text, bool is_utf16be)
+{
+	return make_converted(std::u16string(), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::u16string &dst, std::wstring_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::u16string &dst, std::wstring_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::pmr::u16string simple_codecvt::to_utf16(std::wstring_view text, std::pmr::memory_resource *resource, bool is_utf16be)
+{
+	return make_converted(std::pmr::u16string(resource), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::pmr::u16string &dst, std::wstring_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::pmr::u16string &dst, std::wstring_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::u16string simple_codecvt::to_utf16(std::u8string_view text, bool is_utf16be)
+{
+	return make_converted(std::u16string(), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::u16string &dst, std::u8string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::u16string &dst, std::u8string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::pmr::u16string simple_codecvt::to_utf16(std::u8string_view text, std::pmr::memory_resource *resource, bool is_utf16be)
+{
+	return make_converted(std::pmr::u16string(resource), text, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::pmr::u16string &dst, std::u8string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::pmr::u16string &dst, std::u8string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::u16string simple_codecvt::to_utf16(std::u32string_view text, bool is_utf32be, bool is_utf16be)
+{
+	return make_converted(std::u16string(), text, is_utf32be, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::u16string &dst, std::u32string_view text, bool is_utf32be, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf32be, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::u16string &dst, std::u32string_view text, bool is_utf32be, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf32be, is_utf16be);
+}
+
+std::pmr::u16string simple_codecvt::to_utf16(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be, bool is_utf16be)
+{
+	return make_converted(std::pmr::u16string(resource), text, is_utf32be, is_utf16be);
+}
+
+void simple_codecvt::assign_utf16(std::pmr::u16string &dst, std::u32string_view text, bool is_utf32be, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf32be, is_utf16be);
+}
+
+void simple_codecvt::append_utf16(std::pmr::u16string &dst, std::u32string_view text, bool is_utf32be, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf32be, is_utf16be);
+}
+
+std::u32string simple_codecvt::to_utf32(std::string_view text, bool is_utf32be)
+{
+	return make_converted(std::u32string(), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::u32string &dst, std::string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::u32string &dst, std::string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::pmr::u32string simple_codecvt::to_utf32(std::string_view text, std::pmr::memory_resource *resource, bool is_utf32be)
+{
+	return make_converted(std::pmr::u32string(resource), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::pmr::u32string &dst, std::string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::pmr::u32string &dst, std::string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::u32string simple_codecvt::to_utf32(std::wstring_view text, bool is_utf32be)
+{
+	return make_converted(std::u32string(), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::u32string &dst, std::wstring_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::u32string &dst, std::wstring_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::pmr::u32string simple_codecvt::to_utf32(std::wstring_view text, std::pmr::memory_resource *resource, bool is_utf32be)
+{
+	return make_converted(std::pmr::u32string(resource), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::pmr::u32string &dst, std::wstring_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::pmr::u32string &dst, std::wstring_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::u32string simple_codecvt::to_utf32(std::u8string_view text, bool is_utf32be)
+{
+	return make_converted(std::u32string(), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::u32string &dst, std::u8string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::u32string &dst, std::u8string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::pmr::u32string simple_codecvt::to_utf32(std::u8string_view text, std::pmr::memory_resource *resource, bool is_utf32be)
+{
+	return make_converted(std::pmr::u32string(resource), text, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::pmr::u32string &dst, std::u8string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::pmr::u32string &dst, std::u8string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::u32string simple_codecvt::to_utf32(std::u16string_view text, bool is_utf16be, bool is_utf32be)
+{
+	return make_converted(std::u32string(), text, is_utf16be, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::u32string &dst, std::u16string_view text, bool is_utf16be, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf16be, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::u32string &dst, std::u16string_view text, bool is_utf16be, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf16be, is_utf32be);
+}
+
+std::pmr::u32string simple_codecvt::to_utf32(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be, bool is_utf32be)
+{
+	return make_converted(std::pmr::u32string(resource), text, is_utf16be, is_utf32be);
+}
+
+void simple_codecvt::assign_utf32(std::pmr::u32string &dst, std::u16string_view text, bool is_utf16be, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf16be, is_utf32be);
+}
+
+void simple_codecvt::append_utf32(std::pmr::u32string &dst, std::u16string_view text, bool is_utf16be, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf16be, is_utf32be);
+}
+
+std::string simple_codecvt::to_string(std::wstring_view text)
+{
+	return make_converted(std::string(), text);
+}
+
+void simple_codecvt::assign_string(std::string &dst, std::wstring_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_string(std::string &dst, std::wstring_view text)
+{
+	append_converted(dst, text);
+}
+
+std::pmr::string simple_codecvt::to_string(std::wstring_view text, std::pmr::memory_resource *resource)
+{
+	return make_converted(std::pmr::string(resource), text);
+}
+
+void simple_codecvt::assign_string(std::pmr::string &dst, std::wstring_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_string(std::pmr::string &dst, std::wstring_view text)
+{
+	append_converted(dst, text);
+}
+
+std::string simple_codecvt::to_string(std::u8string_view text)
+{
+	return make_converted(std::string(), text);
+}
+
+void simple_codecvt::assign_string(std::string &dst, std::u8string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_string(std::string &dst, std::u8string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::pmr::string simple_codecvt::to_string(std::u8string_view text, std::pmr::memory_resource *resource)
+{
+	return make_converted(std::pmr::string(resource), text);
+}
+
+void simple_codecvt::assign_string(std::pmr::string &dst, std::u8string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_string(std::pmr::string &dst, std::u8string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::string simple_codecvt::to_string(std::u16string_view text, bool is_utf16be)
+{
+	return make_converted(std::string(), text, is_utf16be);
+}
+
+void simple_codecvt::assign_string(std::string &dst, std::u16string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_string(std::string &dst, std::u16string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::pmr::string simple_codecvt::to_string(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be)
+{
+	return make_converted(std::pmr::string(resource), text, is_utf16be);
+}
+
+void simple_codecvt::assign_string(std::pmr::string &dst, std::u16string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_string(std::pmr::string &dst, std::u16string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::string simple_codecvt::to_string(std::u32string_view text, bool is_utf32be)
+{
+	return make_converted(std::string(), text, is_utf32be);
+}
+
+void simple_codecvt::assign_string(std::string &dst, std::u32string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_string(std::string &dst, std::u32string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::pmr::string simple_codecvt::to_string(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be)
+{
+	return make_converted(std::pmr::string(resource), text, is_utf32be);
+}
+
+void simple_codecvt::assign_string(std::pmr::string &dst, std::u32string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_string(std::pmr::string &dst, std::u32string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::wstring simple_codecvt::to_wstring(std::string_view text)
+{
+	return make_converted(std::wstring(), text);
+}
+
+void simple_codecvt::assign_wstring(std::wstring &dst, std::string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_wstring(std::wstring &dst, std::string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::pmr::wstring simple_codecvt::to_wstring(std::string_view text, std::pmr::memory_resource *resource)
+{
+	return make_converted(std::pmr::wstring(resource), text);
+}
+
+void simple_codecvt::assign_wstring(std::pmr::wstring &dst, std::string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_wstring(std::pmr::wstring &dst, std::string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::wstring simple_codecvt::to_wstring(std::u8string_view text)
+{
+	return make_converted(std::wstring(), text);
+}
+
+void simple_codecvt::assign_wstring(std::wstring &dst, std::u8string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_wstring(std::wstring &dst, std::u8string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::pmr::wstring simple_codecvt::to_wstring(std::u8string_view text, std::pmr::memory_resource *resource)
+{
+	return make_converted(std::pmr::wstring(resource), text);
+}
+
+void simple_codecvt::assign_wstring(std::pmr::wstring &dst, std::u8string_view text)
+{
+	assign_converted(dst, text);
+}
+
+void simple_codecvt::append_wstring(std::pmr::wstring &dst, std::u8string_view text)
+{
+	append_converted(dst, text);
+}
+
+std::wstring simple_codecvt::to_wstring(std::u16string_view text, bool is_utf16be)
+{
+	return make_converted(std::wstring(), text, is_utf16be);
+}
+
+void simple_codecvt::assign_wstring(std::wstring &dst, std::u16string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_wstring(std::wstring &dst, std::u16string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::pmr::wstring simple_codecvt::to_wstring(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be)
+{
+	return make_converted(std::pmr::wstring(resource), text, is_utf16be);
+}
+
+void simple_codecvt::assign_wstring(std::pmr::wstring &dst, std::u16string_view text, bool is_utf16be)
+{
+	assign_converted(dst, text, is_utf16be);
+}
+
+void simple_codecvt::append_wstring(std::pmr::wstring &dst, std::u16string_view text, bool is_utf16be)
+{
+	append_converted(dst, text, is_utf16be);
+}
+
+std::wstring simple_codecvt::to_wstring(std::u32string_view text, bool is_utf32be)
+{
+	return make_converted(std::wstring(), text, is_utf32be);
+}
+
+void simple_codecvt::assign_wstring(std::wstring &dst, std::u32string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_wstring(std::wstring &dst, std::u32string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::pmr::wstring simple_codecvt::to_wstring(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be)
+{
+	return make_converted(std::pmr::wstring(resource), text, is_utf32be);
+}
+
+void simple_codecvt::assign_wstring(std::pmr::wstring &dst, std::u32string_view text, bool is_utf32be)
+{
+	assign_converted(dst, text, is_utf32be);
+}
+
+void simple_codecvt::append_wstring(std::pmr::wstring &dst, std::u32string_view text, bool is_utf32be)
+{
+	append_converted(dst, text, is_utf32be);
+}
+
+std::size_t simple_codecvt::validate_utf8(std::u8string_view text) noexcept
+{
+	return kernels::validate<detail::utf8>(text.data(), text.data() + text.size());
+}
+
+std::size_t simple_codecvt::validate_utf16(std::u16string_view text, bool is_utf16be) noexcept
+{
+	if (is_utf16be != is_big_endian())
+	{
+		return kernels::validate<detail::utf16<true>>(text.data(), text.data() + text.size());
+	}
+	return kernels::validate<detail::utf16<false>>(text.data(), text.data() + text.size());
+}
+
+std::size_t simple_codecvt::validate_utf32(std::u32string_view text, bool is_utf32be) noexcept
+{
+	if (is_utf32be != is_big_endian())
+	{
+		return kernels::validate<detail::utf32<true>>(text.data(), text.data() + text.size());
+	}
+	return kernels::validate<detail::utf32<false>>(text.data(), text.data() + text.size());
+}
+
+std::size_t simple_codecvt::count_code_points(std::wstring_view text) noexcept
+{
+	return measure<wide_codec, detail::utf32<false>>(text, false);
+}
+
+std::size_t simple_codecvt::count_code_points(std::u8string_view text) noexcept
+{
+	return measure<detail::utf8, detail::utf32<false>>(text, false);
+}
+
+std::size_t simple_codecvt::count_code_points(std::u16string_view text, bool is_utf16be) noexcept
+{
+	return measure<detail::utf16<false>, detail::utf32<false>>(text, is_utf16be != is_big_endian());
 }
+
+std::size_t simple_codecvt::count_code_points(std::u32string_view text) noexcept
+{
+	return text.size();
+}
+
+template <typename OutputCharType>
+std::size_t simple_codecvt::required_size(std::string_view text)
+{
+#ifdef _MSC_VER
+	if constexpr (std::is_same_v<OutputCharType, wchar_t>)
+	{
+		return static_cast<std::size_t>(::MultiByteToWideChar(CP_ACP, MB_ERR_INVALID_CHARS | MB_PRECOMPOSED, text.data(), static_cast<int>(text.size()), nullptr, 0));
+	}
+	else if constexpr (std::is_same_v<OutputCharType, char8_t>)
+	{
+		return widen_length<detail::utf8>(text);
+	}
+	else if constexpr (std::is_same_v<OutputCharType, char16_t>)
+	{
+		return required_size<wchar_t>(text);
+	}
+	else
+	{
+		return widen_length<detail::utf32<false>>(text);
+	}
 #else // _MSC_VER
-std::u8string simple_codecvt::to_utf8(std::string_view text)
+	if constexpr (std::is_same_v<OutputCharType, wchar_t>)
+	{
+		return narrow_required_size<detail::utf8, wide_codec>(text, "wchar_t", narrow_code);
+	}
+	else if constexpr (std::is_same_v<OutputCharType, char8_t>)
+	{
+		return narrow_required_size<detail::utf8, detail::utf8>(text, "UTF-8", narrow_code);
+	}
+	else if constexpr (std::is_same_v<OutputCharType, char16_t>)
+	{
+		return narrow_required_size<detail::utf8, detail::utf16<false>>(text, "UTF-16LE", narrow_code);
+	}
+	else
+	{
+		return narrow_required_size<detail::utf8, detail::utf32<false>>(text, "UTF-32LE", narrow_code);
+	}
+#endif // _MSC_VER
+}
+
+template <typename OutputCharType>
+std::size_t simple_codecvt::required_size(std::wstring_view text)
+{
+	if constexpr (std::is_same_v<OutputCharType, char>)
+	{
+#ifdef _MSC_VER
+		return static_cast<std::size_t>(::WideCharToMultiByte(CP_ACP, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr));
+#else // _MSC_VER
+		return narrow_required_size<wide_codec, detail::utf8>(text, narrow_code, "wchar_t");
+#endif // _MSC_VER
+	}
+	else
+	{
+		return measure<wide_codec, codec_t<OutputCharType>>(text, false);
+	}
+}
+
+template <typename OutputCharType>
+std::size_t simple_codecvt::required_size(std::u8string_view text)
 {
-	return iconvert<char8_t, char>(text, "UTF-8", "char");
+	if constexpr (std::is_same_v<OutputCharType, char>)
+	{
+#ifdef _MSC_VER
+		return narrow_length<detail::utf8>(text);
+#else // _MSC_VER
+		return narrow_required_size<detail::utf8, detail::utf8>(text, narrow_code, "UTF-8");
+#endif // _MSC_VER
+	}
+	else
+	{
+		return measure<detail::utf8, codec_t<OutputCharType>>(text, false);
+	}
 }
+
+template <typename OutputCharType>
+std::size_t simple_codecvt::required_size(std::u16string_view text, bool is_utf16be)
+{
+	if constexpr (std::is_same_v<OutputCharType, char>)
+	{
+#ifdef _MSC_VER
+		return is_utf16be != is_big_endian() ? narrow_length<detail::utf16<true>>(text) : narrow_length<detail::utf16<false>>(text);
+#else // _MSC_VER
+		return narrow_required_size<detail::utf16<false>, detail::utf8>(text, narrow_code, is_utf16be ? "UTF-16BE" : "UTF-16LE", is_utf16be != is_big_endian());
 #endif // _MSC_VER
+	}
+	else
+	{
+		return measure<detail::utf16<false>, codec_t<OutputCharType>>(text, is_utf16be != is_big_endian());
+	}
+}
 
+template <typename OutputCharType>
+std::size_t simple_codecvt::required_size(std::u32string_view text, bool is_utf32be)
+{
+	if constexpr (std::is_same_v<OutputCharType, char>)
+	{
 #ifdef _MSC_VER
-std::u8string simple_codecvt::to_utf8(std::wstring_view text)
+		return is_utf32be != is_big_endian() ? narrow_length<detail::utf32<true>>(text) : narrow_length<detail::utf32<false>>(text);
+#else // _MSC_VER
+		return narrow_required_size<detail::utf32<false>, detail::utf8>(text, narrow_code, is_utf32be ? "UTF-32BE" : "UTF-32LE", is_utf32be != is_big_endian());
+#endif // _MSC_VER
+	}
+	else
+	{
+		return measure<detail::utf32<false>, codec_t<OutputCharType>>(text, is_utf32be != is_big_endian());
+	}
+}
+
+template std::size_t simple_codecvt::required_size<wchar_t>(std::string_view text);
+template std::size_t simple_codecvt::required_size<char8_t>(std::string_view text);
+template std::size_t simple_codecvt::required_size<char16_t>(std::string_view text);
+template std::size_t simple_codecvt::required_size<char32_t>(std::string_view text);
+template std::size_t simple_codecvt::required_size<char>(std::wstring_view text);
+template std::size_t simple_codecvt::required_size<char8_t>(std::wstring_view text);
+template std::size_t simple_codecvt::required_size<char16_t>(std::wstring_view text);
+template std::size_t simple_codecvt::required_size<char32_t>(std::wstring_view text);
+template std::size_t simple_codecvt::required_size<char>(std::u8string_view text);
+template std::size_t simple_codecvt::required_size<wchar_t>(std::u8string_view text);
+template std::size_t simple_codecvt::required_size<char16_t>(std::u8string_view text);
+template std::size_t simple_codecvt::required_size<char32_t>(std::u8string_view text);
+template std::size_t simple_codecvt::required_size<char>(std::u16string_view text, bool is_utf16be);
+template std::size_t simple_codecvt::required_size<wchar_t>(std::u16string_view text, bool is_utf16be);
+template std::size_t simple_codecvt::required_size<char8_t>(std::u16string_view text, bool is_utf16be);
+template std::size_t simple_codecvt::required_size<char32_t>(std::u16string_view text, bool is_utf16be);
+template std::size_t simple_codecvt::required_size<char>(std::u32string_view text, bool is_utf32be);
+template std::size_t simple_codecvt::required_size<wchar_t>(std::u32string_view text, bool is_utf32be);
+template std::size_t simple_codecvt::required_size<char8_t>(std::u32string_view text, bool is_utf32be);
+template std::size_t simple_codecvt::required_size<char16_t>(std::u32string_view text, bool is_utf32be);
+
+#ifdef _MSC_VER
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<wchar_t> dest)
+{
+	return widen_into<detail::utf16<false>>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<char8_t> dest)
+{
+	return widen_into<detail::utf8>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<char16_t> dest, bool is_utf16be)
+{
+	if (is_utf16be != is_big_endian())
+	{
+		return widen_into<detail::utf16<true>>(text, dest);
+	}
+	return widen_into<detail::utf16<false>>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<char32_t> dest, bool is_utf32be)
+{
+	if (is_utf32be != is_big_endian())
+	{
+		return widen_into<detail::utf32<true>>(text, dest);
+	}
+	return widen_into<detail::utf32<false>>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::wstring_view text, std::span<char> dest)
+{
+	return narrow_into<detail::utf16<false>>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u8string_view text, std::span<char> dest)
+{
+	return narrow_into<detail::utf8>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u16string_view text, std::span<char> dest, bool is_utf16be)
+{
+	if (is_utf16be != is_big_endian())
+	{
+		return narrow_into<detail::utf16<true>>(text, dest);
+	}
+	return narrow_into<detail::utf16<false>>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u32string_view text, std::span<char> dest, bool is_utf32be)
 {
-	return to_multistring<char8_t>(text.data(), text.size());
+	if (is_utf32be != is_big_endian())
+	{
+		return narrow_into<detail::utf32<true>>(text, dest);
+	}
+	return narrow_into<detail::utf32<false>>(text, dest);
 }
 #else // _MSC_VER
-std::u8string simple_codecvt::to_utf8(std::wstring_view text)
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<wchar_t> dest)
+{
+	return narrow_convert_into<detail::utf8, wide_codec>(text, dest, "wchar_t", narrow_code);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<char8_t> dest)
+{
+	return narrow_convert_into<detail::utf8, detail::utf8>(text, dest, "UTF-8", narrow_code);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<char16_t> dest, bool is_utf16be)
+{
+	return narrow_convert_into<detail::utf8, detail::utf16<false>>(text, dest, is_utf16be ? "UTF-16BE" : "UTF-16LE", narrow_code, false, is_utf16be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view text, std::span<char32_t> dest, bool is_utf32be)
+{
+	return narrow_convert_into<detail::utf8, detail::utf32<false>>(text, dest, is_utf32be ? "UTF-32BE" : "UTF-32LE", narrow_code, false, is_utf32be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::wstring_view text, std::span<char> dest)
 {
-	return iconvert<char8_t, wchar_t>(text, "UTF-8", "wchar_t");
+	return narrow_convert_into<wide_codec, detail::utf8>(text, dest, narrow_code, "wchar_t");
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u8string_view text, std::span<char> dest)
+{
+	return narrow_convert_into<detail::utf8, detail::utf8>(text, dest, narrow_code, "UTF-8");
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u16string_view text, std::span<char> dest, bool is_utf16be)
+{
+	return narrow_convert_into<detail::utf16<false>, detail::utf8>(text, dest, narrow_code, is_utf16be ? "UTF-16BE" : "UTF-16LE", is_utf16be != is_big_endian(), false);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u32string_view text, std::span<char> dest, bool is_utf32be)
+{
+	return narrow_convert_into<detail::utf32<false>, detail::utf8>(text, dest, narrow_code, is_utf32be ? "UTF-32BE" : "UTF-32LE", is_utf32be != is_big_endian(), false);
 }
 #endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u8string simple_codecvt::to_utf8(std::u16string_view text, bool is_utf16be)
+simple_codecvt::convert_result simple_codecvt::convert_into(std::wstring_view text, std::span<char8_t> dest) noexcept
+{
+	return convert_span<wide_codec, detail::utf8>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::wstring_view text, std::span<char16_t> dest, bool is_utf16be) noexcept
+{
+	return convert_span<wide_codec, detail::utf16<false>>(text, dest, false, is_utf16be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::wstring_view text, std::span<char32_t> dest, bool is_utf32be) noexcept
+{
+	return convert_span<wide_codec, detail::utf32<false>>(text, dest, false, is_utf32be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u8string_view text, std::span<wchar_t> dest) noexcept
+{
+	return convert_span<detail::utf8, wide_codec>(text, dest);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u8string_view text, std::span<char16_t> dest, bool is_utf16be) noexcept
+{
+	return convert_span<detail::utf8, detail::utf16<false>>(text, dest, false, is_utf16be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u8string_view text, std::span<char32_t> dest, bool is_utf32be) noexcept
+{
+	return convert_span<detail::utf8, detail::utf32<false>>(text, dest, false, is_utf32be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u16string_view text, std::span<wchar_t> dest, bool is_utf16be) noexcept
+{
+	return convert_span<detail::utf16<false>, wide_codec>(text, dest, is_utf16be != is_big_endian(), false);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u16string_view text, std::span<char8_t> dest, bool is_utf16be) noexcept
+{
+	return convert_span<detail::utf16<false>, detail::utf8>(text, dest, is_utf16be != is_big_endian(), false);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u16string_view text, std::span<char32_t> dest, bool is_utf16be, bool is_utf32be) noexcept
+{
+	return convert_span<detail::utf16<false>, detail::utf32<false>>(text, dest, is_utf16be != is_big_endian(), is_utf32be != is_big_endian());
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u32string_view text, std::span<wchar_t> dest, bool is_utf32be) noexcept
+{
+	return convert_span<detail::utf32<false>, wide_codec>(text, dest, is_utf32be != is_big_endian(), false);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u32string_view text, std::span<char8_t> dest, bool is_utf32be) noexcept
+{
+	return convert_span<detail::utf32<false>, detail::utf8>(text, dest, is_utf32be != is_big_endian(), false);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::u32string_view text, std::span<char16_t> dest, bool is_utf32be, bool is_utf16be) noexcept
+{
+	return convert_span<detail::utf32<false>, detail::utf16<false>>(text, dest, is_utf32be != is_big_endian(), is_utf16be != is_big_endian());
+}
+
+std::size_t simple_codecvt::required_size(std::string_view bytes, encoding from, encoding to) noexcept
+{
+	return select_converter(from, to).length(bytes.data(), bytes.size(), nullptr);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view bytes, encoding from, std::span<char> dest, encoding to) noexcept
+{
+	return byte_result(select_converter(from, to).convert(bytes.data(), bytes.size(), dest.data(), dest.size(), nullptr), bytes.size());
+}
+
+std::size_t simple_codecvt::required_size(std::string_view bytes, encoding from, encoding to, error_policy policy) noexcept
+{
+	const auto recovery = recovery_for(policy);
+	return select_converter(from, to).length(bytes.data(), bytes.size(), policy.action == error_action::raise ? nullptr : &recovery);
+}
+
+simple_codecvt::convert_result simple_codecvt::convert_into(std::string_view bytes, encoding from, std::span<char> dest, encoding to, error_policy policy) noexcept
+{
+	const auto recovery = recovery_for(policy);
+	return byte_result(select_converter(from, to).convert(bytes.data(), bytes.size(), dest.data(), dest.size(), policy.action == error_action::raise ? nullptr : &recovery), bytes.size());
+}
+
+namespace simple_codecvt
+{
+	template <typename Codec>
+	static std::size_t validate_table(std::string_view bytes) noexcept
+	{
+		return kernels::validate<Codec>(reinterpret_cast<const char8_t *>(bytes.data()), reinterpret_cast<const char8_t *>(bytes.data() + bytes.size()));
+	}
+
+	// A single-byte code page has a character for every byte up to the first one without.
+	static std::size_t validate_single_byte(std::string_view bytes, const detail::single_byte_table &table) noexcept
+	{
+		char16_t units[pivot_units];
+		auto src = reinterpret_cast<const char8_t *>(bytes.data());
+		const auto last = src + bytes.size();
+		while (src != last)
+		{
+			const auto size = std::min(static_cast<std::size_t>(last - src), pivot_units);
+			const auto decoded = kernels::decode_single_byte(src, src + size, table, units);
+			src += decoded;
+			if (decoded != size)
+			{
+				break;
+			}
+		}
+		return static_cast<std::size_t>(src - reinterpret_cast<const char8_t *>(bytes.data()));
+	}
+
+	template <typename Codec>
+	static std::size_t count_table_code_points(std::string_view bytes) noexcept
+	{
+		return kernels::length<Codec, detail::utf32<false>>(reinterpret_cast<const char8_t *>(bytes.data()), reinterpret_cast<const char8_t *>(bytes.data() + bytes.size()));
+	}
+}
+
+std::size_t simple_codecvt::validate(std::string_view bytes, encoding text_encoding) noexcept
+{
+	switch (text_encoding)
+	{
+	case encoding::utf16le:
+	case encoding::utf16be:
+		return validate_utf16({ reinterpret_cast<const char16_t *>(bytes.data()), bytes.size() / 2 }, text_encoding == encoding::utf16be) * 2;
+	case encoding::utf32le:
+	case encoding::utf32be:
+		return validate_utf32({ reinterpret_cast<const char32_t *>(bytes.data()), bytes.size() / 4 }, text_encoding == encoding::utf32be) * 4;
+	case encoding::gb18030:
+		return validate_table<detail::gb18030>(bytes);
+	case encoding::gbk:
+		return validate_table<detail::gbk>(bytes);
+	case encoding::shift_jis:
+		return validate_table<detail::shift_jis>(bytes);
+	case encoding::euc_jp:
+		return validate_table<detail::euc_jp>(bytes);
+	case encoding::big5:
+		return validate_table<detail::big5>(bytes);
+	case encoding::euc_kr:
+		return validate_table<detail::euc_kr>(bytes);
+	default:
+		if (const auto table = single_byte_table_for(text_encoding))
+		{
+			return validate_single_byte(bytes, *table);
+		}
+		return validate_utf8({ reinterpret_cast<const char8_t *>(bytes.data()), bytes.size() });
+	}
+}
+
+std::size_t simple_codecvt::count_code_points(std::string_view bytes, encoding text_encoding) noexcept
 {
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
+	switch (text_encoding)
 	{
-		return to_multistring<char8_t>(text.data(), text.size());
+	case encoding::utf16le:
+	case encoding::utf16be:
+		return count_code_points(std::u16string_view{ reinterpret_cast<const char16_t *>(bytes.data()), bytes.size() / 2 }, text_encoding == encoding::utf16be);
+	case encoding::utf32le:
+	case encoding::utf32be:
+		return bytes.size() / 4;
+	case encoding::gb18030:
+		return count_table_code_points<detail::gb18030>(bytes);
+	case encoding::gbk:
+		return count_table_code_points<detail::gbk>(bytes);
+	case encoding::shift_jis:
+		return count_table_code_points<detail::shift_jis>(bytes);
+	case encoding::euc_jp:
+		return count_table_code_points<detail::euc_jp>(bytes);
+	case encoding::big5:
+		return count_table_code_points<detail::big5>(bytes);
+	case encoding::euc_kr:
+		return count_table_code_points<detail::euc_kr>(bytes);
+	default:
+		if (const auto table = single_byte_table_for(text_encoding))
+		{
+			return validate_single_byte(bytes, *table);
+		}
+		return count_code_points(std::u8string_view{ reinterpret_cast<const char8_t *>(bytes.data()), bytes.size() });
 	}
-	auto str = change_endian_copy(text);
-	return to_multistring<char8_t>(str.data(), str.size());
 }
-#else // _MSC_VER
-std::u8string simple_codecvt::to_utf8(std::u16string_view text, bool is_utf16be)
+
+std::wstring simple_codecvt::to_wstring(std::string_view bytes, encoding from)
 {
-	return iconvert<char8_t, char16_t>(text, "UTF-8", is_utf16be ? "UTF-16BE" : "UTF-16LE");
+	return convert_bytes_to<wchar_t>(bytes, from, wide_encoding);
 }
-#endif // _MSC_VER
 
-std::u8string simple_codecvt::to_utf8(std::u32string_view text, bool is_utf32be)
+std::u8string simple_codecvt::to_utf8(std::string_view bytes, encoding from)
 {
-	return iconvert<char8_t, char32_t>(text, "UTF-8", is_utf32be ? "UTF-32BE" : "UTF-32LE");
+	return convert_bytes_to<char8_t>(bytes, from, encoding::utf8);
 }
 
-#ifdef _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::string_view text, bool is_utf16be)
+std::u16string simple_codecvt::to_utf16(std::string_view bytes, encoding from, bool is_utf16be)
 {
-	auto str = to_widestring<char16_t>(text.data(), text.size());
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
-	{
-		return str;
-	}
-	change_endian(str);
-	return str;
+	return convert_bytes_to<char16_t>(bytes, from, utf16_encoding(is_utf16be));
 }
-#else // _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::string_view text, bool is_utf16be)
+
+std::u32string simple_codecvt::to_utf32(std::string_view bytes, encoding from, bool is_utf32be)
 {
-	return iconvert<char16_t, char>(text, is_utf16be ? "UTF-16BE" : "UTF-16LE", "char");
+	return convert_bytes_to<char32_t>(bytes, from, utf32_encoding(is_utf32be));
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::wstring_view text, bool is_utf16be)
+std::string simple_codecvt::to_string(std::wstring_view text, encoding to)
 {
-	auto str = std::u16string(text.begin(), text.end());
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
-	{
-		return str;
-	}
-	change_endian(str);
-	return str;
+	return convert_bytes_to<char>(as_bytes(text), wide_encoding, to);
 }
-#else // _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::wstring_view text, bool is_utf16be)
+
+std::string simple_codecvt::to_string(std::u8string_view text, encoding to)
 {
-	return iconvert<char16_t, wchar_t>(text, is_utf16be ? "UTF-16BE" : "UTF-16LE", "wchar_t");
+	return convert_bytes_to<char>(as_bytes(text), encoding::utf8, to);
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::u8string_view text, bool is_utf16be)
+std::string simple_codecvt::to_string(std::u16string_view text, encoding to, bool is_utf16be)
 {
-	auto str = to_widestring<char16_t>(text.data(), text.size());
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
-	{
-		return str;
-	}
-	change_endian(str);
-	return str;
+	return convert_bytes_to<char>(as_bytes(text), utf16_encoding(is_utf16be), to);
 }
-#else // _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::u8string_view text, bool is_utf16be)
+
+std::string simple_codecvt::to_string(std::u32string_view text, encoding to, bool is_utf32be)
 {
-	return iconvert<char16_t, char8_t>(text, is_utf16be ? "UTF-16BE" : "UTF-16LE", "UTF-8");
+	return convert_bytes_to<char>(as_bytes(text), utf32_encoding(is_utf32be), to);
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::u32string_view text, bool is_utf32be, bool is_utf16be)
+namespace simple_codecvt
 {
-	std::u16string str;
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
+	// Whether every string of the column starts with a whole code unit that does not continue
+	// a sequence. Converting the contiguous data then gives each string what converting it on
+	// its own would.
+	template <typename OffsetType>
+	static bool starts_code_points(std::span<const OffsetType> offsets, std::string_view data, encoding from) noexcept
 	{
-		str = to_utf16string<char16_t>(text.data(), text.size());
-		if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
+		const auto last = offsets.back();
+		for (auto offset : offsets)
 		{
-			return str;
+			const auto position = static_cast<std::size_t>(offset);
+			switch (from)
+			{
+			case encoding::utf16le:
+			case encoding::utf16be:
+				if (position % 2 != 0 || (offset != last && (static_cast<unsigned char>(data[position + (from == encoding::utf16le)]) & 0xFC) == 0xDC))
+				{
+					return false;
+				}
+				break;
+			case encoding::utf32le:
+			case encoding::utf32be:
+				if (position % 4 != 0)
+				{
+					return false;
+				}
+				break;
+			case encoding::gb18030:
+			case encoding::gbk:
+			case encoding::shift_jis:
+			case encoding::euc_jp:
+			case encoding::big5:
+			case encoding::euc_kr:
+				// A trail byte may look like the start of a character.
+				return false;
+			default:
+				if (single_byte_table_for(from) == nullptr && offset != last && (static_cast<unsigned char>(data[position]) & 0xC0) == 0x80)
+				{
+					return false;
+				}
+				break;
+			}
 		}
-		change_endian(str);
-		return str;
+		return true;
 	}
-	return iconvert<char16_t, char32_t>(text, is_utf16be ? "UTF-16BE" : "UTF-16LE", is_utf32be ? "UTF-32BE" : "UTF-32LE");
-}
-#else // _MSC_VER
-std::u16string simple_codecvt::to_utf16(std::u32string_view text, bool is_utf32be, bool is_utf16be)
-{
-	return iconvert<char16_t, char32_t>(text, is_utf16be ? "UTF-16BE" : "UTF-16LE", is_utf32be ? "UTF-32BE" : "UTF-32LE");
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::string_view text, bool is_utf32be)
+template <typename OffsetType>
+simple_codecvt::convert_result simple_codecvt::convert_column(std::span<const OffsetType> offsets, std::string_view data, encoding from, string_column<OffsetType> &dest, encoding to, error_policy policy)
 {
-	auto tmp = to_widestring<char16_t>(text.data(), text.size());
-	auto str = to_utf32string(tmp.data(), tmp.size());
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
+	const auto converter = select_converter(from, to);
+	const auto recovery = recovery_for(policy);
+	const auto errors = policy.action == error_action::raise ? nullptr : &recovery;
+	const std::size_t count = offsets.empty() ? 0 : offsets.size() - 1;
+
+	// Exact output sizes for valid input, and for invalid input handled by `errors`.
+	dest.offsets.resize(count + 1);
+	dest.offsets[0] = 0;
+	std::size_t size = 0;
+	for (std::size_t i = 0; i < count; ++i)
 	{
-		return str;
+		size += converter.length(data.data() + offsets[i], static_cast<std::size_t>(offsets[i + 1] - offsets[i]), errors);
+		if (size > static_cast<std::size_t>(std::numeric_limits<OffsetType>::max()))
+		{
+			throw std::length_error("The converted column does not fit its offset type.");
+		}
+		dest.offsets[i + 1] = static_cast<OffsetType>(size);
 	}
-	change_endian(str);
-	return str;
+
+	convert_result rst{ offsets.empty() ? 0 : static_cast<std::size_t>(offsets.back()), size, convert_status::ok };
+	std::size_t converted = count;
+	dest.data.clear();
+	append_with(dest.data, size, [&](char *out, std::size_t) noexcept
+	{
+		if (count != 0 && starts_code_points(offsets, data, from))
+		{
+			const auto first = static_cast<std::size_t>(offsets[0]);
+			const auto input_size = static_cast<std::size_t>(offsets[count]) - first;
+			const auto whole = converter.convert(data.data() + first, input_size, out, size, errors);
+			if (byte_result(whole, input_size).status == convert_status::ok && whole.written == size)
+			{
+				return size;
+			}
+		}
+
+		// Otherwise, and to find the invalid string, each one is converted on its own so that no
+		// sequence runs across two of them.
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const auto input_size = static_cast<std::size_t>(offsets[i + 1] - offsets[i]);
+			const auto output_size = static_cast<std::size_t>(dest.offsets[i + 1] - dest.offsets[i]);
+			const auto piece = converter.convert(data.data() + offsets[i], input_size, out + dest.offsets[i], output_size, errors);
+			if (byte_result(piece, input_size).status != convert_status::ok)
+			{
+				// The measured size of an invalid string is only an estimate, so the conversion
+				// may have stopped short of the invalid sequence.
+				const auto invalid = validate(data.substr(static_cast<std::size_t>(offsets[i]), input_size), from);
+				rst = { static_cast<std::size_t>(offsets[i]) + invalid, static_cast<std::size_t>(dest.offsets[i]), convert_status::invalid_input };
+				converted = i;
+				return rst.written;
+			}
+		}
+		return size;
+	});
+	dest.offsets.resize(converted + 1);
+	return rst;
 }
-#else // _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::string_view text, bool is_utf32be)
+
+template simple_codecvt::convert_result simple_codecvt::convert_column<std::int32_t>(std::span<const std::int32_t> offsets, std::string_view data, encoding from, string_column<std::int32_t> &dest, encoding to, error_policy policy);
+template simple_codecvt::convert_result simple_codecvt::convert_column<std::int64_t>(std::span<const std::int64_t> offsets, std::string_view data, encoding from, string_column<std::int64_t> &dest, encoding to, error_policy policy);
+
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::parallel_convert(std::wstring_view text, unsigned int threads)
 {
-	return iconvert<char32_t, char>(text, is_utf32be ? "UTF-32BE" : "UTF-32LE", "char");
+	std::basic_string<OutputCharType> str;
+	parallel_append<wide_codec, codec_t<OutputCharType>>(str, text, threads);
+	return str;
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::wstring_view text, bool is_utf32be)
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::parallel_convert(std::u8string_view text, unsigned int threads)
 {
-	auto str = to_utf32string(text.data(), text.size());
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
-	{
-		return str;
-	}
-	change_endian(str);
+	std::basic_string<OutputCharType> str;
+	parallel_append<detail::utf8, codec_t<OutputCharType>>(str, text, threads);
 	return str;
 }
-#else // _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::wstring_view text, bool is_utf32be)
+
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::parallel_convert(std::u16string_view text, bool is_utf16be, unsigned int threads)
 {
-	return iconvert<char32_t, wchar_t>(text, is_utf32be ? "UTF-32BE" : "UTF-32LE", "wchar_t");
+	std::basic_string<OutputCharType> str;
+	parallel_append<detail::utf16<false>, codec_t<OutputCharType>>(str, text, is_utf16be != is_big_endian(), threads);
+	return str;
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::u8string_view text, bool is_utf32be)
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::parallel_convert(std::u32string_view text, bool is_utf32be, unsigned int threads)
 {
-	auto tmp = to_widestring<wchar_t>(text.data(), text.size());
-	auto str = to_utf32string(tmp.data(), tmp.size());
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
-	{
-		return str;
-	}
-	change_endian(str);
+	std::basic_string<OutputCharType> str;
+	parallel_append<detail::utf32<false>, codec_t<OutputCharType>>(str, text, is_utf32be != is_big_endian(), threads);
 	return str;
 }
-#else // _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::u8string_view text, bool is_utf32be)
+
+template std::u8string simple_codecvt::parallel_convert<char8_t>(std::wstring_view text, unsigned int threads);
+template std::u16string simple_codecvt::parallel_convert<char16_t>(std::wstring_view text, unsigned int threads);
+template std::u32string simple_codecvt::parallel_convert<char32_t>(std::wstring_view text, unsigned int threads);
+template std::wstring simple_codecvt::parallel_convert<wchar_t>(std::u8string_view text, unsigned int threads);
+template std::u16string simple_codecvt::parallel_convert<char16_t>(std::u8string_view text, unsigned int threads);
+template std::u32string simple_codecvt::parallel_convert<char32_t>(std::u8string_view text, unsigned int threads);
+template std::wstring simple_codecvt::parallel_convert<wchar_t>(std::u16string_view text, bool is_utf16be, unsigned int threads);
+template std::u8string simple_codecvt::parallel_convert<char8_t>(std::u16string_view text, bool is_utf16be, unsigned int threads);
+template std::u32string simple_codecvt::parallel_convert<char32_t>(std::u16string_view text, bool is_utf16be, unsigned int threads);
+template std::wstring simple_codecvt::parallel_convert<wchar_t>(std::u32string_view text, bool is_utf32be, unsigned int threads);
+template std::u8string simple_codecvt::parallel_convert<char8_t>(std::u32string_view text, bool is_utf32be, unsigned int threads);
+template std::u16string simple_codecvt::parallel_convert<char16_t>(std::u32string_view text, bool is_utf32be, unsigned int threads);
+
+simple_codecvt::convert_result simple_codecvt::parallel_convert_into(std::string_view bytes, encoding from, std::span<char> dest, encoding to, unsigned int threads)
 {
-	return iconvert<char32_t, char8_t>(text, is_utf32be ? "UTF-32BE" : "UTF-32LE", "UTF-8");
+	return byte_result(select_converter(from, to).parallel_convert(bytes.data(), bytes.size(), dest.data(), dest.size(), threads), bytes.size());
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::u16string_view text, bool is_utf16be, bool is_utf32be)
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::convert(std::wstring_view text, error_policy policy)
 {
-	std::u32string str;
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
+	auto rst = convert_with<OutputCharType, wide_codec>(text, policy, false);
+	if (!rst)
 	{
-		str = to_utf32string(text.data(), text.size());
+		throw std::invalid_argument("The function encounters an invalid input character.");
 	}
-	else
+	return std::move(*rst);
+}
+
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::convert(std::u8string_view text, error_policy policy)
+{
+	auto rst = convert_with<OutputCharType, detail::utf8>(text, policy, false);
+	if (!rst)
 	{
-		auto tmp = change_endian_copy(text);
-		str = to_utf32string(tmp.data(), tmp.size());
+		throw std::invalid_argument("The function encounters an invalid input character.");
 	}
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
+	return std::move(*rst);
+}
+
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::convert(std::u16string_view text, error_policy policy, bool is_utf16be)
+{
+	auto rst = convert_with<OutputCharType, detail::utf16<false>>(text, policy, is_utf16be != is_big_endian());
+	if (!rst)
 	{
-		return str;
+		throw std::invalid_argument("The function encounters an invalid input character.");
 	}
-	change_endian(str);
-	return str;
+	return std::move(*rst);
 }
-#else // _MSC_VER
-std::u32string simple_codecvt::to_utf32(std::u16string_view text, bool is_utf16be, bool is_utf32be)
+
+template <typename OutputCharType>
+std::basic_string<OutputCharType> simple_codecvt::convert(std::u32string_view text, error_policy policy, bool is_utf32be)
 {
-	return iconvert<char32_t, char16_t>(text, is_utf32be ? "UTF-32BE" : "UTF-32LE", is_utf16be ? "UTF-16BE" : "UTF-16LE");
+	auto rst = convert_with<OutputCharType, detail::utf32<false>>(text, policy, is_utf32be != is_big_endian());
+	if (!rst)
+	{
+		throw std::invalid_argument("The function encounters an invalid input character.");
+	}
+	return std::move(*rst);
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::string simple_codecvt::to_string(std::wstring_view text)
+template <typename OutputCharType>
+simple_codecvt::conversion<OutputCharType> simple_codecvt::try_convert(std::wstring_view text, error_policy policy) noexcept
 {
-	return to_multistring<char>(text.data(), text.size());
+	return convert_with<OutputCharType, wide_codec>(text, policy, false);
 }
-#else // _MSC_VER
-std::string simple_codecvt::to_string(std::wstring_view text)
+
+template <typename OutputCharType>
+simple_codecvt::conversion<OutputCharType> simple_codecvt::try_convert(std::u8string_view text, error_policy policy) noexcept
 {
-	return iconvert<char, wchar_t>(text, "char", "wchar_t");
+	return convert_with<OutputCharType, detail::utf8>(text, policy, false);
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::string simple_codecvt::to_string(std::u8string_view text)
+template <typename OutputCharType>
+simple_codecvt::conversion<OutputCharType> simple_codecvt::try_convert(std::u16string_view text, error_policy policy, bool is_utf16be) noexcept
 {
-	auto str = to_widestring<wchar_t>(text.data(), text.size());
-	return to_multistring<char>(str.data(), str.size());
+	return convert_with<OutputCharType, detail::utf16<false>>(text, policy, is_utf16be != is_big_endian());
 }
-#else // _MSC_VER
-std::string simple_codecvt::to_string(std::u8string_view text)
+
+template <typename OutputCharType>
+simple_codecvt::conversion<OutputCharType> simple_codecvt::try_convert(std::u32string_view text, error_policy policy, bool is_utf32be) noexcept
 {
-	return iconvert<char, char8_t>(text, "char", "UTF-8");
+	return convert_with<OutputCharType, detail::utf32<false>>(text, policy, is_utf32be != is_big_endian());
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::string simple_codecvt::to_string(std::u16string_view text, bool is_utf16be)
+template std::wstring simple_codecvt::convert<wchar_t>(std::wstring_view text, error_policy policy);
+template std::u8string simple_codecvt::convert<char8_t>(std::wstring_view text, error_policy policy);
+template std::u16string simple_codecvt::convert<char16_t>(std::wstring_view text, error_policy policy);
+template std::u32string simple_codecvt::convert<char32_t>(std::wstring_view text, error_policy policy);
+template std::wstring simple_codecvt::convert<wchar_t>(std::u8string_view text, error_policy policy);
+template std::u8string simple_codecvt::convert<char8_t>(std::u8string_view text, error_policy policy);
+template std::u16string simple_codecvt::convert<char16_t>(std::u8string_view text, error_policy policy);
+template std::u32string simple_codecvt::convert<char32_t>(std::u8string_view text, error_policy policy);
+template std::wstring simple_codecvt::convert<wchar_t>(std::u16string_view text, error_policy policy, bool is_utf16be);
+template std::u8string simple_codecvt::convert<char8_t>(std::u16string_view text, error_policy policy, bool is_utf16be);
+template std::u16string simple_codecvt::convert<char16_t>(std::u16string_view text, error_policy policy, bool is_utf16be);
+template std::u32string simple_codecvt::convert<char32_t>(std::u16string_view text, error_policy policy, bool is_utf16be);
+template std::wstring simple_codecvt::convert<wchar_t>(std::u32string_view text, error_policy policy, bool is_utf32be);
+template std::u8string simple_codecvt::convert<char8_t>(std::u32string_view text, error_policy policy, bool is_utf32be);
+template std::u16string simple_codecvt::convert<char16_t>(std::u32string_view text, error_policy policy, bool is_utf32be);
+template std::u32string simple_codecvt::convert<char32_t>(std::u32string_view text, error_policy policy, bool is_utf32be);
+template simple_codecvt::conversion<wchar_t> simple_codecvt::try_convert<wchar_t>(std::wstring_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<char8_t> simple_codecvt::try_convert<char8_t>(std::wstring_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<char16_t> simple_codecvt::try_convert<char16_t>(std::wstring_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<char32_t> simple_codecvt::try_convert<char32_t>(std::wstring_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<wchar_t> simple_codecvt::try_convert<wchar_t>(std::u8string_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<char8_t> simple_codecvt::try_convert<char8_t>(std::u8string_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<char16_t> simple_codecvt::try_convert<char16_t>(std::u8string_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<char32_t> simple_codecvt::try_convert<char32_t>(std::u8string_view text, error_policy policy) noexcept;
+template simple_codecvt::conversion<wchar_t> simple_codecvt::try_convert<wchar_t>(std::u16string_view text, error_policy policy, bool is_utf16be) noexcept;
+template simple_codecvt::conversion<char8_t> simple_codecvt::try_convert<char8_t>(std::u16string_view text, error_policy policy, bool is_utf16be) noexcept;
+template simple_codecvt::conversion<char16_t> simple_codecvt::try_convert<char16_t>(std::u16string_view text, error_policy policy, bool is_utf16be) noexcept;
+template simple_codecvt::conversion<char32_t> simple_codecvt::try_convert<char32_t>(std::u16string_view text, error_policy policy, bool is_utf16be) noexcept;
+template simple_codecvt::conversion<wchar_t> simple_codecvt::try_convert<wchar_t>(std::u32string_view text, error_policy policy, bool is_utf32be) noexcept;
+template simple_codecvt::conversion<char8_t> simple_codecvt::try_convert<char8_t>(std::u32string_view text, error_policy policy, bool is_utf32be) noexcept;
+template simple_codecvt::conversion<char16_t> simple_codecvt::try_convert<char16_t>(std::u32string_view text, error_policy policy, bool is_utf32be) noexcept;
+template simple_codecvt::conversion<char32_t> simple_codecvt::try_convert<char32_t>(std::u32string_view text, error_policy policy, bool is_utf32be) noexcept;
+
+template <typename InputCharType, typename OutputCharType>
+void simple_codecvt::stream_converter<InputCharType, OutputCharType>::feed(std::basic_string_view<InputCharType> chunk, std::basic_string<OutputCharType> &dst)
 {
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
+	using from_codec = codec_t<InputCharType>;
+	using to_codec = codec_t<OutputCharType>;
+	constexpr bool has_input_order = std::is_same_v<InputCharType, char16_t> || std::is_same_v<InputCharType, char32_t>;
+	constexpr bool has_output_order = std::is_same_v<OutputCharType, char16_t> || std::is_same_v<OutputCharType, char32_t>;
+	const bool swap_input = has_input_order && is_input_be_ != is_big_endian();
+	const bool swap_output = has_output_order && is_output_be_ != is_big_endian();
+	if (swap_input)
 	{
-		return to_multistring<char>(text.data(), text.size());
+		if (swap_output)
+		{
+			stream_append<detail::swapped_t<from_codec>, detail::swapped_t<to_codec>>(dst, chunk, pending_, pending_size_);
+		}
+		else
+		{
+			stream_append<detail::swapped_t<from_codec>, to_codec>(dst, chunk, pending_, pending_size_);
+		}
 	}
-	auto str = change_endian_copy(text);
-	return to_multistring<char>(str.data(), str.size());
-}
-#else // _MSC_VER
-std::string simple_codecvt::to_string(std::u16string_view text, bool is_utf16be)
-{
-	return iconvert<char, char16_t>(text, "char", is_utf16be ? "UTF-16BE" : "UTF-16LE");
-}
-#endif // _MSC_VER
-
-#ifdef _MSC_VER
-std::string simple_codecvt::to_string(std::u32string_view text, bool is_utf32be)
-{
-	std::wstring str;
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
+	else if (swap_output)
 	{
-		str = to_utf16string<wchar_t>(text.data(), text.size());
+		stream_append<from_codec, detail::swapped_t<to_codec>>(dst, chunk, pending_, pending_size_);
 	}
 	else
 	{
-		auto tmp = change_endian_copy(text);
-		str = to_utf16string<wchar_t>(tmp.data(), tmp.size());
+		stream_append<from_codec, to_codec>(dst, chunk, pending_, pending_size_);
 	}
-	return to_multistring<char>(str.data(), str.size());
-}
-#else // _MSC_VER
-std::string simple_codecvt::to_string(std::u32string_view text, bool is_utf32be)
-{
-	return iconvert<char, char32_t>(text, "char", is_utf32be ? "UTF-32BE" : "UTF-32LE");
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::string_view text)
-{
-	return to_widestring<wchar_t>(text.data(), text.size());
-}
-#else // _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::string_view text)
+template <typename InputCharType, typename OutputCharType>
+void simple_codecvt::stream_converter<InputCharType, OutputCharType>::finish(void)
 {
-	return iconvert<wchar_t, char>(text, "wchar_t", "char");
+	if (pending_size_ != 0)
+	{
+		pending_size_ = 0;
+		throw std::invalid_argument("The function encounters an invalid input character.");
+	}
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::u8string_view text)
+template class simple_codecvt::stream_converter<char8_t, char16_t>;
+template class simple_codecvt::stream_converter<char8_t, char32_t>;
+template class simple_codecvt::stream_converter<char8_t, wchar_t>;
+template class simple_codecvt::stream_converter<char16_t, char8_t>;
+template class simple_codecvt::stream_converter<char16_t, char32_t>;
+template class simple_codecvt::stream_converter<char16_t, wchar_t>;
+template class simple_codecvt::stream_converter<char32_t, char8_t>;
+template class simple_codecvt::stream_converter<char32_t, char16_t>;
+template class simple_codecvt::stream_converter<char32_t, wchar_t>;
+template class simple_codecvt::stream_converter<wchar_t, char8_t>;
+template class simple_codecvt::stream_converter<wchar_t, char16_t>;
+template class simple_codecvt::stream_converter<wchar_t, char32_t>;
+
+simple_codecvt::transcoding_streambuf::transcoding_streambuf(std::streambuf *source, encoding external, encoding internal, std::size_t buffer_size)
+	: source_(source), external_(external), internal_(internal), buffer_size_(std::max<std::size_t>(buffer_size, 16) / 4 * 4),
+	external_buffer_(new char32_t[buffer_size_ / 4]), internal_buffer_(new char32_t[buffer_size_ / 4])
 {
-	return to_widestring<wchar_t>(text.data(), text.size());
 }
-#else // _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::u8string_view text)
+
+simple_codecvt::transcoding_streambuf::~transcoding_streambuf(void)
 {
-	return iconvert<wchar_t, char8_t>(text, "wchar_t", "UTF-8");
+	try
+	{
+		sync();
+	}
+	catch (...)
+	{
+	}
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::u16string_view text, bool is_utf16be)
+simple_codecvt::transcoding_streambuf::int_type simple_codecvt::transcoding_streambuf::underflow(void)
 {
-	if ((is_big_endian() && is_utf16be) || (!is_big_endian() && !is_utf16be))
+	if (gptr() < egptr())
 	{
-		return std::wstring(text.begin(), text.end());
+		return traits_type::to_int_type(*gptr());
+	}
+
+	const auto converter = select_converter(external_, internal_);
+	auto raw = reinterpret_cast<char *>(external_buffer_.get());
+	auto cooked = reinterpret_cast<char *>(internal_buffer_.get());
+	for (;;)
+	{
+		const auto rst = converter.convert(raw, external_size_, cooked, buffer_size_, nullptr);
+		external_size_ -= rst.read;
+		std::memmove(raw, raw + rst.read, external_size_);
+		if (rst.written != 0)
+		{
+			setg(cooked, cooked, cooked + rst.written);
+			return traits_type::to_int_type(*cooked);
+		}
+		if (rst.status == detail::transcode_status::invalid)
+		{
+			throw std::invalid_argument("The function encounters an invalid input character.");
+		}
+
+		// Either nothing is buffered or the buffer ends in the middle of a sequence.
+		const auto count = source_->sgetn(raw + external_size_, static_cast<std::streamsize>(buffer_size_ - external_size_));
+		if (count <= 0)
+		{
+			if (external_size_ != 0)
+			{
+				external_size_ = 0;
+				throw std::invalid_argument("The function encounters an invalid input character.");
+			}
+			return traits_type::eof();
+		}
+		external_size_ += static_cast<std::size_t>(count);
 	}
-	auto str = change_endian_copy(text);
-	return std::wstring(str.begin(), str.end());
 }
-#else // _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::u16string_view text, bool is_utf16be)
+
+simple_codecvt::transcoding_streambuf::int_type simple_codecvt::transcoding_streambuf::overflow(int_type ch)
 {
-	return iconvert<wchar_t, char16_t>(text, "wchar_t", is_utf16be ? "UTF-16BE" : "UTF-16LE");
+	if (pbase() == nullptr)
+	{
+		auto cooked = reinterpret_cast<char *>(internal_buffer_.get());
+		setp(cooked, cooked + buffer_size_);
+	}
+	else if (!write_pending())
+	{
+		return traits_type::eof();
+	}
+	if (!traits_type::eq_int_type(ch, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+	}
+	return traits_type::not_eof(ch);
 }
-#endif // _MSC_VER
 
-#ifdef _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::u32string_view text, bool is_utf32be)
+int simple_codecvt::transcoding_streambuf::sync(void)
 {
-	if ((is_big_endian() && is_utf32be) || (!is_big_endian() && !is_utf32be))
+	if (pbase() != nullptr && !write_pending())
 	{
-		return to_utf16string<wchar_t>(text.data(), text.size());
+		return -1;
 	}
-	auto str = change_endian_copy(text);
-	return to_utf16string<wchar_t>(str.data(), str.size());
+	return source_->pubsync();
 }
-#else // _MSC_VER
-std::wstring simple_codecvt::to_wstring(std::u32string_view text, bool is_utf32be)
+
+// Converts and writes everything in the put area except an incomplete trailing sequence,
+// which moves to the front.
+bool simple_codecvt::transcoding_streambuf::write_pending(void)
 {
-	return iconvert<wchar_t, char32_t>(text, "wchar_t", is_utf32be ? "UTF-32BE" : "UTF-32LE");
+	const auto converter = select_converter(internal_, external_);
+	auto raw = reinterpret_cast<char *>(external_buffer_.get());
+	const char *first = pbase();
+	auto size = static_cast<std::size_t>(pptr() - pbase());
+	for (;;)
+	{
+		const auto rst = converter.convert(first, size, raw, buffer_size_, nullptr);
+		if (rst.written != 0 && source_->sputn(raw, static_cast<std::streamsize>(rst.written)) != static_cast<std::streamsize>(rst.written))
+		{
+			return false;
+		}
+		first += rst.read;
+		size -= rst.read;
+		if (rst.status == detail::transcode_status::invalid)
+		{
+			setp(pbase(), epptr());
+			throw std::invalid_argument("The function encounters an invalid input character.");
+		}
+		if (rst.status != detail::transcode_status::output_full)
+		{
+			break;
+		}
+	}
+	auto cooked = pbase();
+	std::memmove(cooked, first, size);
+	setp(cooked, epptr());
+	pbump(static_cast<int>(size));
+	return true;
 }
-#endif // _MSC_VER
 
 std::u16string simple_codecvt::change_endian_copy(std::u16string_view text)
 {
 	std::u16string str;
-	str.reserve(text.size());
-	for (auto ch : text)
+	append_with(str, text.size(), [text](char16_t *dst, std::size_t) noexcept
 	{
-		str.push_back(static_cast<char16_t>((ch << 8) + (ch >> 8)));
-	}
+		kernels::byteswap_copy(text.data(), text.data() + text.size(), dst);
+		return text.size();
+	});
 	return str;
 }
 
 std::u32string simple_codecvt::change_endian_copy(std::u32string_view text)
 {
 	std::u32string str;
-	str.reserve(text.size());
-	for (auto ch : text)
+	append_with(str, text.size(), [text](char32_t *dst, std::size_t) noexcept
 	{
-		char32_t c1 = (ch & 0x000000FF) << 24;
-		char32_t c2 = (ch & 0x0000FF00) << 8;
-		char32_t c3 = (ch & 0x00FF0000) >> 8;
-		char32_t c4 = (ch & 0xFF000000) >> 24;
-		str.push_back(c1 + c2 + c3 + c4);
-	}
+		kernels::byteswap_copy(text.data(), text.data() + text.size(), dst);
+		return text.size();
+	});
 	return str;
 }
 
 void simple_codecvt::change_endian(std::u16string &text) noexcept
 {
-	for (auto &ch : text)
-	{
-		ch = static_cast<char16_t>((ch << 8) + (ch >> 8));
-	}
+	change_endian(text.data(), text.size());
 }
 
 void simple_codecvt::change_endian(std::u32string &text) noexcept
 {
-	for (auto &ch : text)
-	{
-		char32_t c1 = (ch & 0x000000FF) << 24;
-		char32_t c2 = (ch & 0x0000FF00) << 8;
-		char32_t c3 = (ch & 0x00FF0000) >> 8;
-		char32_t c4 = (ch & 0xFF000000) >> 24;
-		ch = c1 + c2 + c3 + c4;
-	}
+	change_endian(text.data(), text.size());
 }
 
 void simple_codecvt::change_endian(char16_t *text) noexcept
 {
-	for (; *text != u'\0'; ++text)
-	{
-		const auto ch = *text;
-		*text = static_cast<char16_t>((ch << 8) + (ch >> 8));
-	}
+	(void)detail::byteswap_until_null(text);
 }
 
 void simple_codecvt::change_endian(char32_t *text) noexcept
 {
-	for (; *text != U'\0'; ++text)
-	{
-		const auto ch = *text;
-		char32_t c1 = (ch & 0x000000FF) << 24;
-		char32_t c2 = (ch & 0x0000FF00) << 8;
-		char32_t c3 = (ch & 0x00FF0000) >> 8;
-		char32_t c4 = (ch & 0xFF000000) >> 24;
-		*text = c1 + c2 + c3 + c4;
-	}
+	(void)detail::byteswap_until_null(text);
 }
 
 void simple_codecvt::change_endian(char16_t *text, std::size_t n) noexcept
 {
-	for (std::size_t i = 0; i < n; ++i)
-	{
-		text[i] = static_cast<char16_t>((text[i] << 8) + (text[i] >> 8));
-	}
+	kernels::byteswap_copy(text, text + n, text);
 }
 
 void simple_codecvt::change_endian(char32_t *text, std::size_t n) noexcept
 {
-	for (std::size_t i = 0; i < n; ++i)
-	{
-		char32_t c1 = (text[i] & 0x000000FF) << 24;
-		char32_t c2 = (text[i] & 0x0000FF00) << 8;
-		char32_t c3 = (text[i] & 0x00FF0000) >> 8;
-		char32_t c4 = (text[i] & 0xFF000000) >> 24;
-		text[i] = c1 + c2 + c3 + c4;
-	}
+	kernels::byteswap_copy(text, text + n, text);
 }
 
 std::u16string simple_codecvt::to_big_endian_copy(std::u16string_view text)
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		return std::u16string(text.begin(), text.end());
 	}
@@ -628,7 +3918,7 @@ std::u16string simple_codecvt::to_big_endian_copy(std::u16string_view text)
 
 std::u32string simple_codecvt::to_big_endian_copy(std::u32string_view text)
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		return std::u32string(text.begin(), text.end());
 	}
@@ -637,7 +3927,7 @@ std::u32string simple_codecvt::to_big_endian_copy(std::u32string_view text)
 
 void simple_codecvt::to_big_endian(std::u16string &text) noexcept
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -645,7 +3935,7 @@ void simple_codecvt::to_big_endian(std::u16string &text) noexcept
 
 simple_codecvt_api void simple_codecvt::to_big_endian(std::u32string &text) noexcept
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -653,7 +3943,7 @@ simple_codecvt_api void simple_codecvt::to_big_endian(std::u32string &text) noex
 
 simple_codecvt_api void simple_codecvt::to_big_endian(char16_t *text) noexcept
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -661,7 +3951,7 @@ simple_codecvt_api void simple_codecvt::to_big_endian(char16_t *text) noexcept
 
 simple_codecvt_api void simple_codecvt::to_big_endian(char32_t *text) noexcept
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -669,7 +3959,7 @@ simple_codecvt_api void simple_codecvt::to_big_endian(char32_t *text) noexcept
 
 simple_codecvt_api void simple_codecvt::to_big_endian(char16_t *text, std::size_t n) noexcept
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		change_endian(text, n);
 	}
@@ -677,7 +3967,7 @@ simple_codecvt_api void simple_codecvt::to_big_endian(char16_t *text, std::size_
 
 simple_codecvt_api void simple_codecvt::to_big_endian(char32_t *text, std::size_t n) noexcept
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		change_endian(text, n);
 	}
@@ -685,7 +3975,7 @@ simple_codecvt_api void simple_codecvt::to_big_endian(char32_t *text, std::size_
 
 simple_codecvt_api std::u16string simple_codecvt::to_little_endian(std::u16string_view text)
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		return std::u16string(text.begin(), text.end());
 	}
@@ -694,7 +3984,7 @@ simple_codecvt_api std::u16string simple_codecvt::to_little_endian(std::u16strin
 
 simple_codecvt_api std::u32string simple_codecvt::to_little_endian(std::u32string_view text)
 {
-	if (!is_big_endian())
+	if constexpr (!is_big_endian())
 	{
 		return std::u32string(text.begin(), text.end());
 	}
@@ -703,7 +3993,7 @@ simple_codecvt_api std::u32string simple_codecvt::to_little_endian(std::u32strin
 
 simple_codecvt_api void simple_codecvt::to_little_endian(std::u16string &text) noexcept
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -711,7 +4001,7 @@ simple_codecvt_api void simple_codecvt::to_little_endian(std::u16string &text) n
 
 simple_codecvt_api void simple_codecvt::to_little_endian(std::u32string &text) noexcept
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -719,7 +4009,7 @@ simple_codecvt_api void simple_codecvt::to_little_endian(std::u32string &text) n
 
 simple_codecvt_api void simple_codecvt::to_little_endian(char16_t *text) noexcept
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -727,7 +4017,7 @@ simple_codecvt_api void simple_codecvt::to_little_endian(char16_t *text) noexcep
 
 simple_codecvt_api void simple_codecvt::to_little_endian(char32_t *text) noexcept
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		change_endian(text);
 	}
@@ -735,7 +4025,7 @@ simple_codecvt_api void simple_codecvt::to_little_endian(char32_t *text) noexcep
 
 simple_codecvt_api void simple_codecvt::to_little_endian(char16_t *text, std::size_t n) noexcept
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		change_endian(text, n);
 	}
@@ -743,19 +4033,65 @@ simple_codecvt_api void simple_codecvt::to_little_endian(char16_t *text, std::si
 
 simple_codecvt_api void simple_codecvt::to_little_endian(char32_t *text, std::size_t n) noexcept
 {
-	if (is_big_endian())
+	if constexpr (is_big_endian())
 	{
 		change_endian(text, n);
 	}
 }
 
-bool simple_codecvt::is_big_endian(void) noexcept
+#ifdef _MSC_VER
+void simple_codecvt::warm_up_converters(void)
+{
+}
+#else // _MSC_VER
+void simple_codecvt::warm_up_converters(void)
+{
+	static constexpr const char *codes[] = { "UTF-8", "UTF-16BE", "UTF-16LE", "UTF-32BE", "UTF-32LE", "wchar_t" };
+	const auto &narrow = locale_narrow_charset();
+	if (narrow.native)
+	{
+		return;
+	}
+	auto &cache = thread_iconv_cache();
+	for (auto code : codes)
+	{
+		// A pair the iconv implementation does not support is reported by the conversion itself.
+		cache.open(code, narrow.codeset.c_str());
+		cache.open(narrow.codeset.c_str(), code);
+	}
+}
+#endif // _MSC_VER
+
+#ifdef _MSC_VER
+void simple_codecvt::refresh_locale(void)
+{
+}
+#else // _MSC_VER
+void simple_codecvt::refresh_locale(void)
+{
+	(void)resolve_narrow();
+}
+#endif // _MSC_VER
+
+void simple_codecvt::flush_converters(void) noexcept
+{
+	thread_iconv_cache().flush();
+}
+
+simple_codecvt::kernel_tier simple_codecvt::active_kernel_tier(void) noexcept
 {
-	static union
+	(void)kernels::table();
+	return active_tier.load(std::memory_order_acquire);
+}
+
+bool simple_codecvt::set_kernel_tier(kernel_tier tier) noexcept
+{
+	const auto kernels = built_kernels(tier);
+	if (kernels == nullptr || !cpu_supports(tier))
 	{
-		unsigned char bytes[4];
-		std::uint32_t value;
-	} o32_host_order = { { 0, 1, 2, 3 } };
-	static auto ans = o32_host_order.value != 0x03020100ul;
-	return ans;
+		return false;
+	}
+	active_tier.store(tier, std::memory_order_release);
+	active_kernels.store(kernels, std::memory_order_release);
+	return true;
 }
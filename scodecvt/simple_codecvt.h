@@ -13,10 +13,19 @@
 #define simple_codecvt_api
 #endif // _MSC_VER
 
+#include <bit>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 #include <climits>
 #include <cstddef>
+#include <cstdint>
 
 #if CHAR_BIT != 8
 #error "unsupported char size"
@@ -24,7 +33,39 @@
 
 namespace simple_codecvt
 {
-	simple_codecvt_api bool is_big_endian(void) noexcept;
+	static_assert(std::endian::native == std::endian::big || std::endian::native == std::endian::little, "unsupported byte order");
+
+	constexpr bool is_big_endian(void) noexcept
+	{
+		return std::endian::native == std::endian::big;
+	}
+
+	// The std::string overloads convert from and to the encoding of the C locale, looked up on
+	// first use and kept; refresh_locale() looks it up again, e.g. after setlocale(). UTF-8 and
+	// the encodings of the `encoding` enumeration convert here, others through iconv. On Windows
+	// they use the active code page, which needs no refreshing.
+	simple_codecvt_api void refresh_locale(void);
+
+	// Conversions that go through iconv keep their descriptors open per thread.
+	// warm_up_converters() opens all of them for the calling thread ahead of time,
+	// flush_converters() closes them, e.g. after refresh_locale() has moved to another encoding.
+	simple_codecvt_api void warm_up_converters(void);
+	simple_codecvt_api void flush_converters(void) noexcept;
+
+	// Instruction sets the conversion kernels are built for. The best one the processor has is
+	// picked when the library is loaded, unless the SIMPLE_CODECVT_KERNELS environment variable
+	// names another one (scalar, sse2, ssse3 or avx2). set_kernel_tier() switches later, e.g. in
+	// tests; it returns false and changes nothing where the processor or the build lacks `tier`.
+	enum class kernel_tier
+	{
+		scalar,
+		sse2,
+		ssse3,
+		avx2,
+	};
+
+	simple_codecvt_api [[nodiscard]] kernel_tier active_kernel_tier(void) noexcept;
+	simple_codecvt_api bool set_kernel_tier(kernel_tier tier) noexcept;
 
 	simple_codecvt_api [[nodiscard]] std::u8string to_utf8(std::string_view text);
 	simple_codecvt_api [[nodiscard]] std::u8string to_utf8(std::wstring_view text);
@@ -51,6 +92,502 @@ namespace simple_codecvt
 	simple_codecvt_api [[nodiscard]] std::wstring to_wstring(std::u16string_view text, bool is_utf16be = is_big_endian());
 	simple_codecvt_api [[nodiscard]] std::wstring to_wstring(std::u32string_view text, bool is_utf32be = is_big_endian());
 
+	// append_ converts onto the end of `dst` and leaves it unchanged if the text is invalid,
+	// assign_ replaces its contents. Both reuse the capacity of `dst` and grow it geometrically.
+	simple_codecvt_api void append_utf8(std::u8string &dst, std::string_view text);
+	simple_codecvt_api void append_utf8(std::u8string &dst, std::wstring_view text);
+	simple_codecvt_api void append_utf8(std::u8string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf8(std::u8string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_utf16(std::u16string &dst, std::string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf16(std::u16string &dst, std::wstring_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf16(std::u16string &dst, std::u8string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf16(std::u16string &dst, std::u32string_view text, bool is_utf32be = is_big_endian(), bool is_utf16be = is_big_endian());
+
+	simple_codecvt_api void append_utf32(std::u32string &dst, std::string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void append_utf32(std::u32string &dst, std::wstring_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void append_utf32(std::u32string &dst, std::u8string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void append_utf32(std::u32string &dst, std::u16string_view text, bool is_utf16be = is_big_endian(), bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_string(std::string &dst, std::wstring_view text);
+	simple_codecvt_api void append_string(std::string &dst, std::u8string_view text);
+	simple_codecvt_api void append_string(std::string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_string(std::string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_wstring(std::wstring &dst, std::string_view text);
+	simple_codecvt_api void append_wstring(std::wstring &dst, std::u8string_view text);
+	simple_codecvt_api void append_wstring(std::wstring &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_wstring(std::wstring &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_utf8(std::u8string &dst, std::string_view text);
+	simple_codecvt_api void assign_utf8(std::u8string &dst, std::wstring_view text);
+	simple_codecvt_api void assign_utf8(std::u8string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf8(std::u8string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_utf16(std::u16string &dst, std::string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf16(std::u16string &dst, std::wstring_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf16(std::u16string &dst, std::u8string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf16(std::u16string &dst, std::u32string_view text, bool is_utf32be = is_big_endian(), bool is_utf16be = is_big_endian());
+
+	simple_codecvt_api void assign_utf32(std::u32string &dst, std::string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void assign_utf32(std::u32string &dst, std::wstring_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void assign_utf32(std::u32string &dst, std::u8string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void assign_utf32(std::u32string &dst, std::u16string_view text, bool is_utf16be = is_big_endian(), bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_string(std::string &dst, std::wstring_view text);
+	simple_codecvt_api void assign_string(std::string &dst, std::u8string_view text);
+	simple_codecvt_api void assign_string(std::string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_string(std::string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_wstring(std::wstring &dst, std::string_view text);
+	simple_codecvt_api void assign_wstring(std::wstring &dst, std::u8string_view text);
+	simple_codecvt_api void assign_wstring(std::wstring &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_wstring(std::wstring &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	// The same conversions into strings that allocate from a memory resource, such as a
+	// std::pmr::monotonic_buffer_resource. Temporaries that a conversion needs on the way come
+	// from the same resource.
+	simple_codecvt_api [[nodiscard]] std::pmr::u8string to_utf8(std::string_view text, std::pmr::memory_resource *resource);
+	simple_codecvt_api [[nodiscard]] std::pmr::u8string to_utf8(std::wstring_view text, std::pmr::memory_resource *resource);
+	simple_codecvt_api [[nodiscard]] std::pmr::u8string to_utf8(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u8string to_utf8(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api [[nodiscard]] std::pmr::u16string to_utf16(std::string_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u16string to_utf16(std::wstring_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u16string to_utf16(std::u8string_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u16string to_utf16(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian(), bool is_utf16be = is_big_endian());
+
+	simple_codecvt_api [[nodiscard]] std::pmr::u32string to_utf32(std::string_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u32string to_utf32(std::wstring_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u32string to_utf32(std::u8string_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::u32string to_utf32(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian(), bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api [[nodiscard]] std::pmr::string to_string(std::wstring_view text, std::pmr::memory_resource *resource);
+	simple_codecvt_api [[nodiscard]] std::pmr::string to_string(std::u8string_view text, std::pmr::memory_resource *resource);
+	simple_codecvt_api [[nodiscard]] std::pmr::string to_string(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::string to_string(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api [[nodiscard]] std::pmr::wstring to_wstring(std::string_view text, std::pmr::memory_resource *resource);
+	simple_codecvt_api [[nodiscard]] std::pmr::wstring to_wstring(std::u8string_view text, std::pmr::memory_resource *resource);
+	simple_codecvt_api [[nodiscard]] std::pmr::wstring to_wstring(std::u16string_view text, std::pmr::memory_resource *resource, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::pmr::wstring to_wstring(std::u32string_view text, std::pmr::memory_resource *resource, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_utf8(std::pmr::u8string &dst, std::string_view text);
+	simple_codecvt_api void append_utf8(std::pmr::u8string &dst, std::wstring_view text);
+	simple_codecvt_api void append_utf8(std::pmr::u8string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf8(std::pmr::u8string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_utf16(std::pmr::u16string &dst, std::string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf16(std::pmr::u16string &dst, std::wstring_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf16(std::pmr::u16string &dst, std::u8string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_utf16(std::pmr::u16string &dst, std::u32string_view text, bool is_utf32be = is_big_endian(), bool is_utf16be = is_big_endian());
+
+	simple_codecvt_api void append_utf32(std::pmr::u32string &dst, std::string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void append_utf32(std::pmr::u32string &dst, std::wstring_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void append_utf32(std::pmr::u32string &dst, std::u8string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void append_utf32(std::pmr::u32string &dst, std::u16string_view text, bool is_utf16be = is_big_endian(), bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_string(std::pmr::string &dst, std::wstring_view text);
+	simple_codecvt_api void append_string(std::pmr::string &dst, std::u8string_view text);
+	simple_codecvt_api void append_string(std::pmr::string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_string(std::pmr::string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void append_wstring(std::pmr::wstring &dst, std::string_view text);
+	simple_codecvt_api void append_wstring(std::pmr::wstring &dst, std::u8string_view text);
+	simple_codecvt_api void append_wstring(std::pmr::wstring &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void append_wstring(std::pmr::wstring &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_utf8(std::pmr::u8string &dst, std::string_view text);
+	simple_codecvt_api void assign_utf8(std::pmr::u8string &dst, std::wstring_view text);
+	simple_codecvt_api void assign_utf8(std::pmr::u8string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf8(std::pmr::u8string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_utf16(std::pmr::u16string &dst, std::string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf16(std::pmr::u16string &dst, std::wstring_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf16(std::pmr::u16string &dst, std::u8string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_utf16(std::pmr::u16string &dst, std::u32string_view text, bool is_utf32be = is_big_endian(), bool is_utf16be = is_big_endian());
+
+	simple_codecvt_api void assign_utf32(std::pmr::u32string &dst, std::string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void assign_utf32(std::pmr::u32string &dst, std::wstring_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void assign_utf32(std::pmr::u32string &dst, std::u8string_view text, bool is_utf32be = is_big_endian());
+	simple_codecvt_api void assign_utf32(std::pmr::u32string &dst, std::u16string_view text, bool is_utf16be = is_big_endian(), bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_string(std::pmr::string &dst, std::wstring_view text);
+	simple_codecvt_api void assign_string(std::pmr::string &dst, std::u8string_view text);
+	simple_codecvt_api void assign_string(std::pmr::string &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_string(std::pmr::string &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api void assign_wstring(std::pmr::wstring &dst, std::string_view text);
+	simple_codecvt_api void assign_wstring(std::pmr::wstring &dst, std::u8string_view text);
+	simple_codecvt_api void assign_wstring(std::pmr::wstring &dst, std::u16string_view text, bool is_utf16be = is_big_endian());
+	simple_codecvt_api void assign_wstring(std::pmr::wstring &dst, std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	// Offset of the first invalid or incomplete sequence, or text.size() if the whole text is
+	// valid. Nothing is converted or allocated.
+	simple_codecvt_api [[nodiscard]] std::size_t validate_utf8(std::u8string_view text) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t validate_utf16(std::u16string_view text, bool is_utf16be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t validate_utf32(std::u32string_view text, bool is_utf32be = is_big_endian()) noexcept;
+
+	// Number of code points in the text, counted in one pass without converting or allocating.
+	// Exact for valid input, an estimate otherwise. How long the text becomes in another
+	// encoding is required_size().
+	simple_codecvt_api [[nodiscard]] std::size_t count_code_points(std::wstring_view text) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t count_code_points(std::u8string_view text) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t count_code_points(std::u16string_view text, bool is_utf16be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t count_code_points(std::u32string_view text) noexcept;
+
+	enum class convert_status
+	{
+		ok,
+		output_full,
+		invalid_input,
+	};
+
+	// `read` and `written` count code units. Everything before `read` has been converted; on
+	// invalid_input it is the offset of the offending sequence.
+	struct convert_result
+	{
+		std::size_t read;
+		std::size_t written;
+		convert_status status;
+	};
+
+	// Number of OutputCharType units the matching convert_into() writes for the whole text.
+	// Exact for valid input, an estimate otherwise.
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::string_view text);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::wstring_view text);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::u8string_view text);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::u16string_view text, bool is_utf16be = is_big_endian());
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::u32string_view text, bool is_utf32be = is_big_endian());
+
+	// Convert as much as fits into `dest` without allocating and never throw on invalid input.
+	// Where the locale's encoding has no engine here, conversions from and to std::string open
+	// an iconv descriptor for the thread on first use.
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::string_view text, std::span<wchar_t> dest);
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::string_view text, std::span<char8_t> dest);
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::string_view text, std::span<char16_t> dest, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::string_view text, std::span<char32_t> dest, bool is_utf32be = is_big_endian());
+
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::wstring_view text, std::span<char> dest);
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::wstring_view text, std::span<char8_t> dest) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::wstring_view text, std::span<char16_t> dest, bool is_utf16be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::wstring_view text, std::span<char32_t> dest, bool is_utf32be = is_big_endian()) noexcept;
+
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u8string_view text, std::span<char> dest);
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u8string_view text, std::span<wchar_t> dest) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u8string_view text, std::span<char16_t> dest, bool is_utf16be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u8string_view text, std::span<char32_t> dest, bool is_utf32be = is_big_endian()) noexcept;
+
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u16string_view text, std::span<char> dest, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u16string_view text, std::span<wchar_t> dest, bool is_utf16be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u16string_view text, std::span<char8_t> dest, bool is_utf16be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u16string_view text, std::span<char32_t> dest, bool is_utf16be = is_big_endian(), bool is_utf32be = is_big_endian()) noexcept;
+
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u32string_view text, std::span<char> dest, bool is_utf32be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u32string_view text, std::span<wchar_t> dest, bool is_utf32be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u32string_view text, std::span<char8_t> dest, bool is_utf32be = is_big_endian()) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::u32string_view text, std::span<char16_t> dest, bool is_utf32be = is_big_endian(), bool is_utf16be = is_big_endian()) noexcept;
+
+	enum class error_action
+	{
+		raise,
+		replace,
+		skip,
+	};
+
+	// What convert(), try_convert() and the byte buffer convert_into() do with invalid input:
+	// report it (raise), write `substitute` in place of each invalid sequence (replace), or drop
+	// it (skip). An invalid sequence is the maximal subpart of one, so a truncated sequence
+	// counts once. A substitute that is not a Unicode scalar value is taken as U+FFFD.
+	struct error_policy
+	{
+		error_action action = error_action::raise;
+		char32_t substitute = 0xFFFD;
+	};
+
+	// Expected-style result of try_convert(): the converted text, or the offset in input code
+	// units of the first invalid sequence.
+	template <typename CharType>
+	class conversion
+	{
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		conversion(std::basic_string<CharType> text) noexcept : text_(std::move(text)) {}
+		explicit conversion(std::size_t error) noexcept : error_(error) {}
+
+		[[nodiscard]] bool has_value(void) const noexcept
+		{
+			return error_ == npos;
+		}
+
+		explicit operator bool(void) const noexcept
+		{
+			return has_value();
+		}
+
+		// Offset of the first invalid sequence, npos if there is a value.
+		[[nodiscard]] std::size_t error(void) const noexcept
+		{
+			return error_;
+		}
+
+		[[nodiscard]] const std::basic_string<CharType> &value(void) const &
+		{
+			check();
+			return text_;
+		}
+
+		[[nodiscard]] std::basic_string<CharType> &value(void) &
+		{
+			check();
+			return text_;
+		}
+
+		[[nodiscard]] std::basic_string<CharType> &&value(void) &&
+		{
+			check();
+			return std::move(text_);
+		}
+
+		const std::basic_string<CharType> &operator*(void) const & noexcept
+		{
+			return text_;
+		}
+
+		std::basic_string<CharType> &operator*(void) & noexcept
+		{
+			return text_;
+		}
+
+		const std::basic_string<CharType> *operator->(void) const noexcept
+		{
+			return &text_;
+		}
+
+	private:
+		void check(void) const
+		{
+			if (!has_value())
+			{
+				throw std::invalid_argument("The function encounters an invalid input character.");
+			}
+		}
+
+		std::basic_string<CharType> text_;
+		std::size_t error_ = npos;
+	};
+
+	// Conversions between char8_t, char16_t, char32_t and wchar_t with invalid input handled by
+	// `policy`; output is in host byte order. convert() throws std::invalid_argument where the
+	// policy is raise, try_convert() returns the offset instead. try_convert() throws nothing,
+	// running out of memory terminates.
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> convert(std::wstring_view text, error_policy policy);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> convert(std::u8string_view text, error_policy policy);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> convert(std::u16string_view text, error_policy policy, bool is_utf16be = is_big_endian());
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> convert(std::u32string_view text, error_policy policy, bool is_utf32be = is_big_endian());
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] conversion<OutputCharType> try_convert(std::wstring_view text, error_policy policy = {}) noexcept;
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] conversion<OutputCharType> try_convert(std::u8string_view text, error_policy policy = {}) noexcept;
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] conversion<OutputCharType> try_convert(std::u16string_view text, error_policy policy = {}, bool is_utf16be = is_big_endian()) noexcept;
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] conversion<OutputCharType> try_convert(std::u32string_view text, error_policy policy = {}, bool is_utf32be = is_big_endian()) noexcept;
+
+	// Converts a text that arrives in chunks, e.g. from a file or a socket. feed() converts each
+	// chunk and keeps a sequence that is cut off at its end for the next call, so chunks may be
+	// split anywhere. finish() rejects a sequence that never completed and resets the converter.
+	// Byte orders apply to char16_t and char32_t only. Instantiated for every pair of char8_t,
+	// char16_t, char32_t and wchar_t.
+	template <typename InputCharType, typename OutputCharType>
+	class stream_converter
+	{
+	public:
+		explicit stream_converter(bool is_input_be = is_big_endian(), bool is_output_be = is_big_endian()) noexcept
+			: is_input_be_(is_input_be), is_output_be_(is_output_be)
+		{
+		}
+
+		// Appends the conversion of `chunk` to `dst`, which is left unchanged if the chunk is invalid.
+		void feed(std::basic_string_view<InputCharType> chunk, std::basic_string<OutputCharType> &dst);
+
+		[[nodiscard]] std::basic_string<OutputCharType> feed(std::basic_string_view<InputCharType> chunk)
+		{
+			std::basic_string<OutputCharType> str;
+			feed(chunk, str);
+			return str;
+		}
+
+		void finish(void);
+
+		void reset(void) noexcept
+		{
+			pending_size_ = 0;
+		}
+
+	private:
+		InputCharType pending_[4] = {};
+		std::size_t pending_size_ = 0;
+		bool is_input_be_;
+		bool is_output_be_;
+	};
+
+	extern template class simple_codecvt_api stream_converter<char8_t, char16_t>;
+	extern template class simple_codecvt_api stream_converter<char8_t, char32_t>;
+	extern template class simple_codecvt_api stream_converter<char8_t, wchar_t>;
+	extern template class simple_codecvt_api stream_converter<char16_t, char8_t>;
+	extern template class simple_codecvt_api stream_converter<char16_t, char32_t>;
+	extern template class simple_codecvt_api stream_converter<char16_t, wchar_t>;
+	extern template class simple_codecvt_api stream_converter<char32_t, char8_t>;
+	extern template class simple_codecvt_api stream_converter<char32_t, char16_t>;
+	extern template class simple_codecvt_api stream_converter<char32_t, wchar_t>;
+	extern template class simple_codecvt_api stream_converter<wchar_t, char8_t>;
+	extern template class simple_codecvt_api stream_converter<wchar_t, char16_t>;
+	extern template class simple_codecvt_api stream_converter<wchar_t, char32_t>;
+
+	enum class encoding
+	{
+		utf8,
+		utf16le,
+		utf16be,
+		utf32le,
+		utf32be,
+		// GB18030-2022, and its GBK subset as in Windows code page 936: one- and two-byte codes
+		// only, with 0x80 for the euro sign.
+		gb18030,
+		gbk,
+		// The double-byte character sets, as the Windows code pages 932, 950 and 949 have them
+		// for Shift_JIS, Big5 and EUC-KR. EUC-JP includes JIS X 0212.
+		shift_jis,
+		euc_jp,
+		big5,
+		euc_kr,
+		// Single-byte code pages. Windows-1255 and 1258 convert byte for byte, leaving combining
+		// marks as they are.
+		latin1,
+		iso8859_2,
+		iso8859_3,
+		iso8859_4,
+		iso8859_5,
+		iso8859_6,
+		iso8859_7,
+		iso8859_8,
+		iso8859_9,
+		iso8859_10,
+		iso8859_11,
+		iso8859_13,
+		iso8859_14,
+		iso8859_15,
+		iso8859_16,
+		windows_1250,
+		windows_1251,
+		windows_1252,
+		windows_1253,
+		windows_1254,
+		windows_1255,
+		windows_1256,
+		windows_1257,
+		windows_1258,
+		koi8_r,
+		koi8_u,
+	};
+
+	// The same conversions between byte buffers in explicitly named encodings; `read` and
+	// `written` count bytes, and a truncated code unit at the end is invalid input. Both buffers
+	// must be aligned for their code units.
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::string_view bytes, encoding from, encoding to) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::string_view bytes, encoding from, std::span<char> dest, encoding to) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t required_size(std::string_view bytes, encoding from, encoding to, error_policy policy) noexcept;
+	simple_codecvt_api [[nodiscard]] convert_result convert_into(std::string_view bytes, encoding from, std::span<char> dest, encoding to, error_policy policy) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t validate(std::string_view bytes, encoding text_encoding) noexcept;
+	simple_codecvt_api [[nodiscard]] std::size_t count_code_points(std::string_view bytes, encoding text_encoding) noexcept;
+
+	// Conversions between text in a named encoding and Unicode strings, which do not depend on
+	// the locale. `bytes` is as for convert_into(). Invalid input, including characters that
+	// `to` cannot encode, throws std::invalid_argument.
+	simple_codecvt_api [[nodiscard]] std::wstring to_wstring(std::string_view bytes, encoding from);
+	simple_codecvt_api [[nodiscard]] std::u8string to_utf8(std::string_view bytes, encoding from);
+	simple_codecvt_api [[nodiscard]] std::u16string to_utf16(std::string_view bytes, encoding from, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::u32string to_utf32(std::string_view bytes, encoding from, bool is_utf32be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::string to_string(std::wstring_view text, encoding to);
+	simple_codecvt_api [[nodiscard]] std::string to_string(std::u8string_view text, encoding to);
+	simple_codecvt_api [[nodiscard]] std::string to_string(std::u16string_view text, encoding to, bool is_utf16be = is_big_endian());
+	simple_codecvt_api [[nodiscard]] std::string to_string(std::u32string_view text, encoding to, bool is_utf32be = is_big_endian());
+
+	// Conversions of large texts on up to `threads` threads, 0 meaning one per hardware thread.
+	// The text is split at code point boundaries, the pieces are measured concurrently, and each
+	// is converted straight into its place in a single output. Short texts are converted on the
+	// calling thread. Output is in host byte order; otherwise these behave like to_*() and
+	// convert_into().
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> parallel_convert(std::wstring_view text, unsigned int threads = 0);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> parallel_convert(std::u8string_view text, unsigned int threads = 0);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> parallel_convert(std::u16string_view text, bool is_utf16be = is_big_endian(), unsigned int threads = 0);
+	template <typename OutputCharType>
+	simple_codecvt_api [[nodiscard]] std::basic_string<OutputCharType> parallel_convert(std::u32string_view text, bool is_utf32be = is_big_endian(), unsigned int threads = 0);
+	simple_codecvt_api [[nodiscard]] convert_result parallel_convert_into(std::string_view bytes, encoding from, std::span<char> dest, encoding to, unsigned int threads = 0);
+
+	// A column of strings stored back to back, as in an Apache Arrow string column: string i is
+	// data[offsets[i], offsets[i + 1]), so there is one more offset than there are strings.
+	template <typename OffsetType>
+	struct string_column
+	{
+		std::vector<OffsetType> offsets;
+		std::string data;
+	};
+
+	// Converts a whole column with one measuring pass, one allocation of `dest.data` and one
+	// conversion pass over the contiguous data, without any per-string call into the platform
+	// converter. `dest` is replaced by the converted column, with offsets starting at 0. On
+	// invalid input `read` is the offset in `data` of the invalid sequence, `written` the size
+	// of `dest.data`, and `dest` holds the strings before the invalid one. Strings must be
+	// aligned for their code units. Throws std::length_error if the output does not fit
+	// OffsetType. Instantiated for std::int32_t and std::int64_t.
+	template <typename OffsetType>
+	simple_codecvt_api [[nodiscard]] convert_result convert_column(std::span<const OffsetType> offsets, std::string_view data, encoding from, string_column<OffsetType> &dest, encoding to, error_policy policy = {});
+
+	// A stream buffer that transcodes between the bytes of another stream buffer (`external`)
+	// and what the program reads or writes through it (`internal`), in two fixed buffers of
+	// `buffer_size` bytes. Use one for either input or output. Invalid input throws
+	// std::invalid_argument, which iostreams report through badbit; on output a sequence that
+	// is still incomplete when the buffer is destroyed is dropped.
+	class simple_codecvt_api transcoding_streambuf final : public std::streambuf
+	{
+	public:
+		transcoding_streambuf(std::streambuf *source, encoding external, encoding internal, std::size_t buffer_size = 4096);
+		transcoding_streambuf(const transcoding_streambuf &) = delete;
+		transcoding_streambuf &operator=(const transcoding_streambuf &) = delete;
+		~transcoding_streambuf(void) override;
+
+	protected:
+		int_type underflow(void) override;
+		int_type overflow(int_type ch) override;
+		int sync(void) override;
+
+	private:
+		bool write_pending(void);
+
+		std::streambuf *source_;
+		encoding external_;
+		encoding internal_;
+		std::size_t buffer_size_;
+		std::unique_ptr<char32_t[]> external_buffer_;
+		std::unique_ptr<char32_t[]> internal_buffer_;
+		std::size_t external_size_ = 0;
+	};
+
 	simple_codecvt_api [[nodiscard]] std::u16string change_endian_copy(std::u16string_view text);
 	simple_codecvt_api [[nodiscard]] std::u32string change_endian_copy(std::u32string_view text);
 	simple_codecvt_api void change_endian(std::u16string &text) noexcept;
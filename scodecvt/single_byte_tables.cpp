@@ -0,0 +1,2299 @@
+﻿// Generated by scodecvt/tables/generate_tables.py from the ISO-8859, CP125x and KOI8 mapping
+// files, which hold the single-byte converters of glibc 2.36.
+// Do not edit by hand: change the mapping files and run python3 scodecvt/tables/generate_tables.py.
+#include "table_codecs.h"
+
+namespace simple_codecvt::detail
+{
+	const single_byte_table single_byte_tables[single_byte_table_count] =
+	{
+		// ISO-8859-1
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+				0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BF, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00AA, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00CC, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00DE, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F0, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D0, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00BA, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FE, 0xFE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-2
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0104, 0x02D8, 0x0141, 0x00A4, 0x013D, 0x015A, 0x00A7, 0x00A8, 0x0160, 0x015E, 0x0164, 0x0179, 0x00AD, 0x017D, 0x017B,
+				0x00B0, 0x0105, 0x02DB, 0x0142, 0x00B4, 0x013E, 0x015B, 0x02C7, 0x00B8, 0x0161, 0x015F, 0x0165, 0x017A, 0x02DD, 0x017E, 0x017C,
+				0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7, 0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+				0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7, 0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+				0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7, 0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+				0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7, 0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0142, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x02DD, 0xBD }, { 0x0164, 0xAB }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0118, 0xCA }, { 0x0088, 0x88 }, { 0x0171, 0xFB }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x013A, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0103, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x017E, 0xBE }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0147, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0110, 0xD0 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0154, 0xC0 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0161, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x016E, 0xD9 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0159, 0xF8 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x017B, 0xAF }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0144, 0xF1 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x010D, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0151, 0xF5 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x011A, 0xCC }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0105, 0xB1 }, { 0x0000, 0x00 }, { 0x015E, 0xAA },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0141, 0xA3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0163, 0xFE }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x02C7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0170, 0xDB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0139, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0102, 0xC3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015B, 0xB6 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x017D, 0xAE }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x010F, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x013E, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0107, 0xE6 }, { 0x0000, 0x00 }, { 0x02D9, 0xFF },
+				{ 0x0160, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0158, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x017A, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0143, 0xD1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010C, 0xC8 }, { 0x0000, 0x00 }, { 0x0165, 0xBB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0150, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0119, 0xEA }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0104, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0148, 0xF2 }, { 0x00B8, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0111, 0xF0 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0155, 0xE0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x02DB, 0xB2 }, { 0x0162, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x016F, 0xF9 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015A, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x017C, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010E, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x011B, 0xEC }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013D, 0xA5 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0106, 0xC6 }, { 0x0000, 0x00 }, { 0x02D8, 0xA2 }, { 0x015F, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0179, 0xAC },
+			},
+		},
+		// ISO-8859-3
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0126, 0x02D8, 0x00A3, 0x00A4, 0x0000, 0x0124, 0x00A7, 0x00A8, 0x0130, 0x015E, 0x011E, 0x0134, 0x00AD, 0x0000, 0x017B,
+				0x00B0, 0x0127, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x0125, 0x00B7, 0x00B8, 0x0131, 0x015F, 0x011F, 0x0135, 0x00BD, 0x0000, 0x017C,
+				0x00C0, 0x00C1, 0x00C2, 0x0000, 0x00C4, 0x010A, 0x0108, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x0000, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x0120, 0x00D6, 0x00D7, 0x011C, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x016C, 0x015C, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x0000, 0x00E4, 0x010B, 0x0109, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x0000, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x0121, 0x00F6, 0x00F7, 0x011D, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x016D, 0x015D, 0x02D9,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x010B, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015C, 0xDE }, { 0x0000, 0x00 },
+				{ 0x00CC, 0xCC }, { 0x0000, 0x00 }, { 0x0125, 0xB6 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x011D, 0xF8 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0108, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x017B, 0xAF }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015E, 0xAA },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0127, 0xB1 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0134, 0xAC }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x011F, 0xBB }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010A, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0124, 0xA6 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0131, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x011C, 0xD8 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02D9, 0xFF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x016D, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0121, 0xF5 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015D, 0xFE }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0126, 0xA1 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x011E, 0xAB }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0109, 0xE6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x017C, 0xBF }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0130, 0xA9 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02D8, 0xA2 }, { 0x015F, 0xBA }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x016C, 0xDD }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0135, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0120, 0xD5 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-4
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0104, 0x0138, 0x0156, 0x00A4, 0x0128, 0x013B, 0x00A7, 0x00A8, 0x0160, 0x0112, 0x0122, 0x0166, 0x00AD, 0x017D, 0x00AF,
+				0x00B0, 0x0105, 0x02DB, 0x0157, 0x00B4, 0x0129, 0x013C, 0x02C7, 0x00B8, 0x0161, 0x0113, 0x0123, 0x0167, 0x014A, 0x017E, 0x014B,
+				0x0100, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x012E, 0x010C, 0x00C9, 0x0118, 0x00CB, 0x0116, 0x00CD, 0x00CE, 0x012A,
+				0x0110, 0x0145, 0x014C, 0x0136, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x0172, 0x00DA, 0x00DB, 0x00DC, 0x0168, 0x016A, 0x00DF,
+				0x0101, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x012F, 0x010D, 0x00E9, 0x0119, 0x00EB, 0x0117, 0x00ED, 0x00EE, 0x012B,
+				0x0111, 0x0146, 0x014D, 0x0137, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x0173, 0x00FA, 0x00FB, 0x00FC, 0x0169, 0x016B, 0x02D9,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0118, 0xCA }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x017E, 0xBE }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0110, 0xD0 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0169, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0161, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x012A, 0xCF }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014C, 0xD2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0137, 0xF3 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0100, 0xC0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0122, 0xAB }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x010D, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0166, 0xAC }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012F, 0xE7 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0173, 0xF9 }, { 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x013C, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0105, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0112, 0xAA }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x016B, 0xFE }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0156, 0xA3 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x02C7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0117, 0xEC }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x017D, 0xAE }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0146, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0168, 0xDD }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02D9, 0xFF },
+				{ 0x0160, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0129, 0xB5 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014B, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0136, 0xD3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010C, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x012E, 0xC7 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0119, 0xEA }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0172, 0xD9 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013B, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0104, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0111, 0xF0 }, { 0x0081, 0x81 }, { 0x016A, 0xDE }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x02DB, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012B, 0xEF }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014D, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0116, 0xCC }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0138, 0xA2 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0101, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0123, 0xBB }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0145, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0167, 0xBC },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0128, 0xA5 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014A, 0xBD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0113, 0xBA }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0157, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-5
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0401, 0x0402, 0x0403, 0x0404, 0x0405, 0x0406, 0x0407, 0x0408, 0x0409, 0x040A, 0x040B, 0x040C, 0x00AD, 0x040E, 0x040F,
+				0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+				0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427, 0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+				0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+				0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447, 0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+				0x2116, 0x0451, 0x0452, 0x0453, 0x0454, 0x0455, 0x0456, 0x0457, 0x0458, 0x0459, 0x045A, 0x045B, 0x045C, 0x00A7, 0x045E, 0x045F,
+			},
+			0x63F5642B,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0403, 0xA3 }, { 0x0092, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042C, 0xCC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0455, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0415, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043E, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0427, 0xC7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0410, 0xB0 }, { 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0439, 0xD9 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0422, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044B, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040B, 0xAB }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0434, 0xD4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041D, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0446, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0406, 0xA6 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042F, 0xCF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0458, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0418, 0xB8 }, { 0x00A7, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0441, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2116, 0xF0 }, { 0x0401, 0xA1 }, { 0x0090, 0x90 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042A, 0xCA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0453, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0413, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043C, 0xDC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0425, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044E, 0xEE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x040E, 0xAE }, { 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0437, 0xD7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0420, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0449, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0409, 0xA9 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0432, 0xD2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045B, 0xFB }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041B, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0444, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0404, 0xA4 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042D, 0xCD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0456, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0416, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043F, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0428, 0xC8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0451, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0411, 0xB1 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043A, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0423, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044C, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040C, 0xAC }, { 0x009B, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0435, 0xD5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045E, 0xFE }, { 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041E, 0xBE }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0447, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0407, 0xA7 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0430, 0xD0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0459, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0419, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0442, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0402, 0xA2 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042B, 0xCB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0454, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0414, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043D, 0xDD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0426, 0xC6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044F, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x040F, 0xAF }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0438, 0xD8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0421, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044A, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040A, 0xAA }, { 0x0099, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0433, 0xD3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045C, 0xFC }, { 0x0000, 0x00 }, { 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041C, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0445, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0405, 0xA5 }, { 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042E, 0xCE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0457, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0417, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0440, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0429, 0xC9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0452, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0412, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043B, 0xDB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0424, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044D, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0436, 0xD6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045F, 0xFF }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041F, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0448, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0408, 0xA8 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0431, 0xD1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045A, 0xFA }, { 0x0000, 0x00 }, { 0x0080, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041A, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0443, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-6
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0000, 0x0000, 0x0000, 0x00A4, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x060C, 0x00AD, 0x0000, 0x0000,
+				0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x061B, 0x0000, 0x0000, 0x0000, 0x061F,
+				0x0000, 0x0621, 0x0622, 0x0623, 0x0624, 0x0625, 0x0626, 0x0627, 0x0628, 0x0629, 0x062A, 0x062B, 0x062C, 0x062D, 0x062E, 0x062F,
+				0x0630, 0x0631, 0x0632, 0x0633, 0x0634, 0x0635, 0x0636, 0x0637, 0x0638, 0x0639, 0x063A, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x0640, 0x0641, 0x0642, 0x0643, 0x0644, 0x0645, 0x0646, 0x0647, 0x0648, 0x0649, 0x064A, 0x064B, 0x064C, 0x064D, 0x064E, 0x064F,
+				0x0650, 0x0651, 0x0652, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+			},
+			0x9E3779B1,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0628, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x064A, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0635, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0642, 0xE2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x062D, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x064F, 0xEF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x063A, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0625, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0647, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0632, 0xD2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x062A, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x064C, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0637, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0622, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0644, 0xE4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x062F, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0651, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0627, 0xC7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0649, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0634, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x061F, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0641, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x062C, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x064E, 0xEE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0639, 0xD9 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0624, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0646, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0631, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0629, 0xC9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x064B, 0xEB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x0636, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0621, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0643, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x060C, 0xAC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x062E, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0650, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0626, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0648, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0633, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0640, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x062B, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x064D, 0xED },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0638, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0623, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0645, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0630, 0xD0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0652, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x061B, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-7
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x2018, 0x2019, 0x00A3, 0x20AC, 0x20AF, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x037A, 0x00AB, 0x00AC, 0x00AD, 0x0000, 0x2015,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x0384, 0x0385, 0x0386, 0x00B7, 0x0388, 0x0389, 0x038A, 0x00BB, 0x038C, 0x00BD, 0x038E, 0x038F,
+				0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397, 0x0398, 0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F,
+				0x03A0, 0x03A1, 0x0000, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7, 0x03A8, 0x03A9, 0x03AA, 0x03AB, 0x03AC, 0x03AD, 0x03AE, 0x03AF,
+				0x03B0, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7, 0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+				0x03C0, 0x03C1, 0x03C2, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7, 0x03C8, 0x03C9, 0x03CA, 0x03CB, 0x03CC, 0x03CD, 0x03CE, 0x0000,
+			},
+			0x9E3779B1,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A4, 0xD4 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x038F, 0xBF }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x037A, 0xAA }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x039C, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x20AF, 0xA5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A9, 0xD9 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x03CB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0394, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x038C, 0xBC }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03AE, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0399, 0xC9 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03BB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0384, 0xB4 }, { 0x0092, 0x92 },
+				{ 0x20AC, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0391, 0xC1 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x039E, 0xCE }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03C0, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0389, 0xB9 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x03CD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0396, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0xA2 }, { 0x0000, 0x00 }, { 0x03A3, 0xD3 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x038E, 0xBE }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03B0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x039B, 0xCB }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BD, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0386, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03CA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0393, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A0, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03C2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AD, 0xDD }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0398, 0xC8 }, { 0x00A6, 0xA6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03A5, 0xD5 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0390, 0xC0 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03B2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x039D, 0xCD }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0388, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x03CC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0395, 0xC5 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03B7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2018, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03C4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AF, 0xDF }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x039A, 0xCA },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0385, 0xB5 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03A7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0392, 0xC2 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2015, 0xAF }, { 0x0000, 0x00 }, { 0x039F, 0xCF }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x038A, 0xBA }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x03CE, 0xFE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0397, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03B9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-8
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0000, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00D7, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00F7, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x0000,
+				0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x2017,
+				0x05D0, 0x05D1, 0x05D2, 0x05D3, 0x05D4, 0x05D5, 0x05D6, 0x05D7, 0x05D8, 0x05D9, 0x05DA, 0x05DB, 0x05DC, 0x05DD, 0x05DE, 0x05DF,
+				0x05E0, 0x05E1, 0x05E2, 0x05E3, 0x05E4, 0x05E5, 0x05E6, 0x05E7, 0x05E8, 0x05E9, 0x05EA, 0x0000, 0x0000, 0x200E, 0x200F, 0x0000,
+			},
+			0x190C8C13,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x200F, 0xFE }, { 0x00D7, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E9, 0xF9 }, { 0x0000, 0x00 },
+				{ 0x00A4, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x05DF, 0xEF }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D5, 0xE5 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05EA, 0xFA }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E0, 0xF0 }, { 0x0000, 0x00 }, { 0x009B, 0x9B }, { 0x00F7, 0xBA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D6, 0xE6 }, { 0x0000, 0x00 },
+				{ 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E1, 0xF1 }, { 0x0000, 0x00 }, { 0x009C, 0x9C },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05D7, 0xE7 }, { 0x0000, 0x00 }, { 0x0092, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E2, 0xF2 },
+				{ 0x0000, 0x00 }, { 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D8, 0xE8 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x05E3, 0xF3 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D9, 0xE9 }, { 0x0000, 0x00 }, { 0x0094, 0x94 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B3, 0xB3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E4, 0xF4 }, { 0x0000, 0x00 }, { 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05DA, 0xEA }, { 0x0000, 0x00 },
+				{ 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x05D0, 0xE0 }, { 0x0000, 0x00 }, { 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E5, 0xF5 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05DB, 0xEB }, { 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D1, 0xE1 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05E6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05DC, 0xEC }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D2, 0xE2 }, { 0x008D, 0x8D },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x2017, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E7, 0xF7 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05DD, 0xED }, { 0x0098, 0x98 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05D3, 0xE3 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x200E, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E8, 0xF8 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05DE, 0xEE },
+				{ 0x0099, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D4, 0xE4 }, { 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-9
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+				0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x011E, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x0130, 0x015E, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x011F, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x0131, 0x015F, 0x00FF,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BF, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00AA, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00CC, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015E, 0xDE },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x011F, 0xF0 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0131, 0xFD }, { 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x011E, 0xD0 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0130, 0xDD }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015F, 0xFE }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00BA, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-10
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0104, 0x0112, 0x0122, 0x012A, 0x0128, 0x0136, 0x00A7, 0x013B, 0x0110, 0x0160, 0x0166, 0x017D, 0x00AD, 0x016A, 0x014A,
+				0x00B0, 0x0105, 0x0113, 0x0123, 0x012B, 0x0129, 0x0137, 0x00B7, 0x013C, 0x0111, 0x0161, 0x0167, 0x017E, 0x2015, 0x016B, 0x014B,
+				0x0100, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x012E, 0x010C, 0x00C9, 0x0118, 0x00CB, 0x0116, 0x00CD, 0x00CE, 0x00CF,
+				0x00D0, 0x0145, 0x014C, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x0168, 0x00D8, 0x0172, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+				0x0101, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x012F, 0x010D, 0x00E9, 0x0119, 0x00EB, 0x0117, 0x00ED, 0x00EE, 0x00EF,
+				0x00F0, 0x0146, 0x014D, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x0169, 0x00F8, 0x0173, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x0138,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0118, 0xCA }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x017E, 0xBC }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0110, 0xA9 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0169, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0161, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x012A, 0xA4 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x014C, 0xD2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00DE, 0xDE }, { 0x0000, 0x00 }, { 0x0137, 0xB6 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0100, 0xC0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0122, 0xA3 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x010D, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0166, 0xAB }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012F, 0xE7 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0173, 0xF9 }, { 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x013C, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0105, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F0, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0112, 0xA2 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x016B, 0xBE }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0117, 0xEC }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x017D, 0xAC }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0146, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0168, 0xD7 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0160, 0xAA }, { 0x0000, 0x00 }, { 0x00D0, 0xD0 }, { 0x0000, 0x00 }, { 0x0129, 0xB5 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014B, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0136, 0xA6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010C, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x012E, 0xC7 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0119, 0xEA }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0172, 0xD9 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013B, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0104, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0111, 0xB9 }, { 0x0081, 0x81 }, { 0x016A, 0xAE }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012B, 0xB4 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014D, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0116, 0xCC }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0138, 0xFF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0101, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0123, 0xB3 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0145, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0167, 0xBB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x2015, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0128, 0xA5 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014A, 0xAF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0113, 0xB2 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FE, 0xFE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-11
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0E01, 0x0E02, 0x0E03, 0x0E04, 0x0E05, 0x0E06, 0x0E07, 0x0E08, 0x0E09, 0x0E0A, 0x0E0B, 0x0E0C, 0x0E0D, 0x0E0E, 0x0E0F,
+				0x0E10, 0x0E11, 0x0E12, 0x0E13, 0x0E14, 0x0E15, 0x0E16, 0x0E17, 0x0E18, 0x0E19, 0x0E1A, 0x0E1B, 0x0E1C, 0x0E1D, 0x0E1E, 0x0E1F,
+				0x0E20, 0x0E21, 0x0E22, 0x0E23, 0x0E24, 0x0E25, 0x0E26, 0x0E27, 0x0E28, 0x0E29, 0x0E2A, 0x0E2B, 0x0E2C, 0x0E2D, 0x0E2E, 0x0E2F,
+				0x0E30, 0x0E31, 0x0E32, 0x0E33, 0x0E34, 0x0E35, 0x0E36, 0x0E37, 0x0E38, 0x0E39, 0x0E3A, 0x0000, 0x0000, 0x0000, 0x0000, 0x0E3F,
+				0x0E40, 0x0E41, 0x0E42, 0x0E43, 0x0E44, 0x0E45, 0x0E46, 0x0E47, 0x0E48, 0x0E49, 0x0E4A, 0x0E4B, 0x0E4C, 0x0E4D, 0x0E4E, 0x0E4F,
+				0x0E50, 0x0E51, 0x0E52, 0x0E53, 0x0E54, 0x0E55, 0x0E56, 0x0E57, 0x0E58, 0x0E59, 0x0E5A, 0x0E5B, 0x0000, 0x0000, 0x0000, 0x0000,
+			},
+			0x9E3779B1,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E4C, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E15, 0xB5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E37, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E59, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E22, 0xC2 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E44, 0xE4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E0D, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E2F, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E51, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E1A, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E05, 0xA5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E27, 0xC7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E49, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E12, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E34, 0xD4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E56, 0xF6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E1F, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E41, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E0A, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E2C, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E4E, 0xEE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E17, 0xB7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E39, 0xD9 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0E02, 0xA2 }, { 0x0000, 0x00 }, { 0x0E5B, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E24, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E46, 0xE6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E0F, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E31, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E53, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E1C, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E07, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E29, 0xC9 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E4B, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E14, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E36, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E58, 0xF8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E21, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E43, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E0C, 0xAC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E2E, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E50, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E19, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E04, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E26, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E48, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E11, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E33, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E55, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E1E, 0xBE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E40, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E09, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E2B, 0xCB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E4D, 0xED }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E16, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E38, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0E01, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E5A, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E23, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E45, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E0E, 0xAE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E30, 0xD0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E52, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E1B, 0xBB }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E06, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E28, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E4A, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E13, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E35, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E57, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E20, 0xC0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E42, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E0B, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E2D, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E4F, 0xEF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E18, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E3A, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0E03, 0xA3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E25, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E47, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E10, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E32, 0xD2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E54, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0E1D, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0E3F, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E08, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0E2A, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-13
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x201D, 0x00A2, 0x00A3, 0x00A4, 0x201E, 0x00A6, 0x00A7, 0x00D8, 0x00A9, 0x0156, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00C6,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x201C, 0x00B5, 0x00B6, 0x00B7, 0x00F8, 0x00B9, 0x0157, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00E6,
+				0x0104, 0x012E, 0x0100, 0x0106, 0x00C4, 0x00C5, 0x0118, 0x0112, 0x010C, 0x00C9, 0x0179, 0x0116, 0x0122, 0x0136, 0x012A, 0x013B,
+				0x0160, 0x0143, 0x0145, 0x00D3, 0x014C, 0x00D5, 0x00D6, 0x00D7, 0x0172, 0x0141, 0x015A, 0x016A, 0x00DC, 0x017B, 0x017D, 0x00DF,
+				0x0105, 0x012F, 0x0101, 0x0107, 0x00E4, 0x00E5, 0x0119, 0x0113, 0x010D, 0x00E9, 0x017A, 0x0117, 0x0123, 0x0137, 0x012B, 0x013C,
+				0x0161, 0x0144, 0x0146, 0x00F3, 0x014D, 0x00F5, 0x00F6, 0x00F7, 0x0173, 0x0142, 0x015B, 0x016B, 0x00FC, 0x017C, 0x017E, 0x2019,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0142, 0xF9 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0118, 0xC6 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x017E, 0xFE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x00E6, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0161, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x012A, 0xCE }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x014C, 0xD4 },
+				{ 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0137, 0xED }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0100, 0xC2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0122, 0xCC }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x017B, 0xDD }, { 0x0000, 0x00 }, { 0x201C, 0xB4 }, { 0x0000, 0x00 }, { 0x0144, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x010D, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012F, 0xE1 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0173, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x013C, 0xEF }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0105, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0112, 0xC7 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x016B, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0156, 0xAA }, { 0x00C6, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0xFF }, { 0x0000, 0x00 }, { 0x0141, 0xD9 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0117, 0xEB }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015B, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x017D, 0xDE }, { 0x0000, 0x00 }, { 0x201E, 0xA5 }, { 0x0000, 0x00 }, { 0x0146, 0xF2 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0107, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0160, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0136, 0xCD }, { 0x00A6, 0xA6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x017A, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0143, 0xD1 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010C, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x012E, 0xC1 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0119, 0xE6 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0172, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013B, 0xCF }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0104, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x016A, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012B, 0xEE }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014D, 0xF4 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0116, 0xCB }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0101, 0xE2 }, { 0x0000, 0x00 }, { 0x015A, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0123, 0xEC }, { 0x0093, 0x93 }, { 0x017C, 0xFD }, { 0x0000, 0x00 }, { 0x201D, 0xA1 }, { 0x0000, 0x00 },
+				{ 0x0145, 0xD2 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0106, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0113, 0xE7 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0157, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0179, 0xCA },
+			},
+		},
+		// ISO-8859-14
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x1E02, 0x1E03, 0x00A3, 0x010A, 0x010B, 0x1E0A, 0x00A7, 0x1E80, 0x00A9, 0x1E82, 0x1E0B, 0x1EF2, 0x00AD, 0x00AE, 0x0178,
+				0x1E1E, 0x1E1F, 0x0120, 0x0121, 0x1E40, 0x1E41, 0x00B6, 0x1E56, 0x1E81, 0x1E57, 0x1E83, 0x1E60, 0x1EF3, 0x1E84, 0x1E85, 0x1E61,
+				0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x0174, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x1E6A, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x0176, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x0175, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x1E6B, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x0177, 0x00FF,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x1E6A, 0xD7 }, { 0x010B, 0xA5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x1E1E, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x1E40, 0xB4 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x1EF2, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00CC, 0xCC }, { 0x1E84, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0176, 0xDE }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x1E81, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x1E57, 0xB9 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x1E0B, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x1E03, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0178, 0xAF }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010A, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x1E61, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x1E83, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x0000, 0x00 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0175, 0xF0 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x1E80, 0xA8 },
+				{ 0x0000, 0x00 }, { 0x0121, 0xB3 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x1E6B, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x1E56, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x1E1F, 0xB1 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x1E41, 0xB5 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x1E0A, 0xA6 }, { 0x1EF3, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x1E85, 0xBE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x1E02, 0xA1 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0177, 0xFE }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x1E60, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA },
+				{ 0x1E82, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0174, 0xD0 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0120, 0xB2 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-15
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x20AC, 0x00A5, 0x0160, 0x00A7, 0x0161, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x017D, 0x00B5, 0x00B6, 0x00B7, 0x017E, 0x00B9, 0x00BA, 0x00BB, 0x0152, 0x0153, 0x0178, 0x00BF,
+				0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF,
+			},
+			0x9E3779B1,
+			{
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009D, 0x9D }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BF, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00AA, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00CC, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x017E, 0xB8 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0080, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 },
+				{ 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0161, 0xA8 }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00DE, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0092, 0x92 },
+				{ 0x20AC, 0xA4 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0097, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F0, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0082, 0x82 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0178, 0xBE }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0094, 0x94 }, { 0x017D, 0xB4 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0153, 0xBD }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0160, 0xA6 }, { 0x0000, 0x00 }, { 0x00D0, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 },
+				{ 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B },
+				{ 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0086, 0x86 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0093, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0152, 0xBC }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008B, 0x8B }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00BA, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FE, 0xFE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0090, 0x90 }, { 0x0000, 0x00 },
+			},
+		},
+		// ISO-8859-16
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087, 0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+				0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097, 0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+				0x00A0, 0x0104, 0x0105, 0x0141, 0x20AC, 0x201E, 0x0160, 0x00A7, 0x0161, 0x00A9, 0x0218, 0x00AB, 0x0179, 0x00AD, 0x017A, 0x017B,
+				0x00B0, 0x00B1, 0x010C, 0x0142, 0x017D, 0x201D, 0x00B6, 0x00B7, 0x017E, 0x010D, 0x0219, 0x00BB, 0x0152, 0x0153, 0x0178, 0x017C,
+				0x00C0, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0106, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x0110, 0x0143, 0x00D2, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x015A, 0x0170, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x0118, 0x021A, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x0107, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x0111, 0x0144, 0x00F2, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x015B, 0x0171, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x0119, 0x021B, 0x00FF,
+			},
+			0xF131D9C1,
+			{
+				{ 0x0218, 0xAA }, { 0x0000, 0x00 }, { 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x008A, 0x8A }, { 0x0103, 0xE3 }, { 0x017C, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009B, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E0, 0xE0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0089, 0x89 },
+				{ 0x0102, 0xC3 }, { 0x017B, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009A, 0x9A },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0088, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017A, 0xAE },
+				{ 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0099, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0087, 0x87 }, { 0x0000, 0x00 }, { 0x0179, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CC, 0xCC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0098, 0x98 }, { 0x0111, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00EE, 0xEE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0086, 0x86 }, { 0x00FF, 0xFF }, { 0x0178, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0144, 0xF1 }, { 0x0000, 0x00 },
+				{ 0x0097, 0x97 }, { 0x0110, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x20AC, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00ED, 0xED }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0085, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA }, { 0x0143, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0096, 0x96 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0084, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C9, 0xC9 }, { 0x0142, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0095, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00DA, 0xDA }, { 0x0000, 0x00 }, { 0x0153, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0083, 0x83 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 }, { 0x0141, 0xA3 },
+				{ 0x0000, 0x00 }, { 0x0094, 0x94 }, { 0x010D, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0152, 0xBC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0082, 0x82 }, { 0x00FB, 0xFB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201E, 0xA5 }, { 0x0093, 0x93 },
+				{ 0x010C, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0151, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0081, 0x81 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x201D, 0xB5 }, { 0x0092, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0150, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0161, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0080, 0x80 }, { 0x00F9, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0091, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E7, 0xE7 },
+				{ 0x0000, 0x00 }, { 0x0160, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0171, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0090, 0x90 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0170, 0xD8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0119, 0xFD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008E, 0x8E }, { 0x0107, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D3, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009F, 0x9F }, { 0x0000, 0x00 }, { 0x0118, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x021B, 0xFE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x008D, 0x8D }, { 0x0000, 0x00 }, { 0x0106, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x009E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x021A, 0xDE }, { 0x0000, 0x00 }, { 0x00F4, 0xF4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008C, 0x8C }, { 0x0105, 0xA2 },
+				{ 0x017E, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009D, 0x9D },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x015B, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0219, 0xBA }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x008B, 0x8B }, { 0x0104, 0xA1 }, { 0x017D, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x009C, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x015A, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1250
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0000, 0x201E, 0x2026, 0x2020, 0x2021, 0x0000, 0x2030, 0x0160, 0x2039, 0x015A, 0x0164, 0x017D, 0x0179,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x0000, 0x2122, 0x0161, 0x203A, 0x015B, 0x0165, 0x017E, 0x017A,
+				0x00A0, 0x02C7, 0x02D8, 0x0141, 0x00A4, 0x0104, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x015E, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x017B,
+				0x00B0, 0x00B1, 0x02DB, 0x0142, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x0105, 0x015F, 0x00BB, 0x013D, 0x02DD, 0x013E, 0x017C,
+				0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7, 0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+				0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7, 0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+				0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7, 0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+				0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7, 0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9,
+			},
+			0x11BB60A7,
+			{
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0104, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013E, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x015B, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x2026, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0105, 0xB9 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x2018, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0179, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E9, 0xE9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0106, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017A, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0107, 0xE6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201A, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0141, 0xA3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC }, { 0x0000, 0x00 }, { 0x015E, 0xAA }, { 0x0000, 0x00 }, { 0x02C7, 0xA1 }, { 0x0000, 0x00 },
+				{ 0x017B, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0150, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0142, 0xB3 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x015F, 0xBA },
+				{ 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017C, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AC, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0151, 0xF5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x016E, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A4, 0xA4 }, { 0x201C, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 }, { 0x2039, 0x8B }, { 0x0143, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0160, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017D, 0x8E },
+				{ 0x0000, 0x00 }, { 0x0118, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x016F, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x02D8, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 },
+				{ 0x0000, 0x00 }, { 0x203A, 0x9B }, { 0x0144, 0xF1 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0161, 0x9A }, { 0x0000, 0x00 },
+				{ 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017E, 0x9E }, { 0x0000, 0x00 }, { 0x0119, 0xEA }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00EE, 0xEE }, { 0x0000, 0x00 }, { 0x0170, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02D9, 0xFF }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 },
+				{ 0x201E, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2122, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0162, 0xDE }, { 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x011A, 0xCC }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0154, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0171, 0xFB }, { 0x0000, 0x00 },
+				{ 0x010C, 0xC8 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x0163, 0xFE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x011B, 0xEC }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0155, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010D, 0xE8 }, { 0x02DB, 0xB2 }, { 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x2020, 0x86 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0147, 0xD2 }, { 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0164, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0139, 0xC5 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010E, 0xCF },
+				{ 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x2021, 0x87 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0148, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0165, 0x9D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2013, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 }, { 0x2030, 0x89 }, { 0x013A, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x010F, 0xEF }, { 0x02DD, 0xBD }, { 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2014, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0158, 0xD8 },
+				{ 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0110, 0xD0 }, { 0x0000, 0x00 },
+				{ 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0102, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0159, 0xF8 }, { 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0111, 0xF0 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0103, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013D, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015A, 0x8C }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1251
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021, 0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+				0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x0000, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+				0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7, 0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+				0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7, 0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+				0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+				0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427, 0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+				0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+				0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447, 0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+			},
+			0x64C7A611,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0451, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0430, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040F, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044C, 0xFC }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x042B, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040A, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0447, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0426, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0405, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0442, 0xF2 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0421, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2122, 0x99 }, { 0x0000, 0x00 }, { 0x045E, 0xA2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043D, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041C, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0459, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0438, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0417, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0454, 0xBA }, { 0x0000, 0x00 }, { 0x201A, 0x82 }, { 0x0000, 0x00 }, { 0x0433, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0491, 0xB4 },
+				{ 0x0000, 0x00 }, { 0x0412, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x044F, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042E, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x044A, 0xFA }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0429, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0408, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0445, 0xF5 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0424, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0403, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0440, 0xF0 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041F, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045C, 0x9D }, { 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x043B, 0xEB }, { 0x00A6, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041A, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0457, 0xBF }, { 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0436, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0415, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2039, 0x8B }, { 0x2116, 0xB9 }, { 0x0000, 0x00 }, { 0x0452, 0x90 }, { 0x2018, 0x91 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0431, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0410, 0xC0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044D, 0xFD }, { 0x0000, 0x00 }, { 0x2013, 0x96 },
+				{ 0x0000, 0x00 }, { 0x042C, 0xDC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040B, 0x8E }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0448, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0427, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0406, 0xB2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0443, 0xF3 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0422, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0401, 0xA8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x045F, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043E, 0xEE }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041D, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x045A, 0x9C }, { 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0439, 0xE9 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0418, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0455, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0434, 0xE4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0413, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042F, 0xDF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040E, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044B, 0xFB }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042A, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0409, 0x8A }, { 0x0000, 0x00 }, { 0x20AC, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0446, 0xF6 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0425, 0xD5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0404, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0441, 0xF1 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0420, 0xD0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043C, 0xEC }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041B, 0xCB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0458, 0xBC }, { 0x0000, 0x00 },
+				{ 0x201E, 0x84 }, { 0x0000, 0x00 }, { 0x0437, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0416, 0xC6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x203A, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0453, 0x83 }, { 0x0000, 0x00 },
+				{ 0x2019, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0432, 0xE2 }, { 0x0000, 0x00 }, { 0x0490, 0xA5 }, { 0x0000, 0x00 }, { 0x0411, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044E, 0xFE }, { 0x0000, 0x00 },
+				{ 0x2014, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042D, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x040C, 0x8D },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2030, 0x89 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0449, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0428, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0407, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0444, 0xF4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0423, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0402, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2026, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043F, 0xEF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041E, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x045B, 0x9E }, { 0x2021, 0x87 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043A, 0xEA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0419, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0456, 0xB3 }, { 0x0000, 0x00 }, { 0x201C, 0x93 }, { 0x0000, 0x00 }, { 0x0435, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0414, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1252
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x0000, 0x017D, 0x0000,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x0000, 0x017E, 0x0178,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+				0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF,
+			},
+			0xC90FC207,
+			{
+				{ 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x00BF, 0xBF }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x017E, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AC, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00F2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 },
+				{ 0x00C8, 0xC8 }, { 0x0000, 0x00 }, { 0x00BA, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00ED, 0xED },
+				{ 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C3, 0xC3 }, { 0x0000, 0x00 },
+				{ 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CC, 0xCC }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 },
+				{ 0x017D, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0161, 0x9A }, { 0x0000, 0x00 }, { 0x0153, 0x9C },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 },
+				{ 0x0000, 0x00 }, { 0x00E3, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 },
+				{ 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0178, 0x9F }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 }, { 0x00DE, 0xDE },
+				{ 0x0000, 0x00 }, { 0x00D0, 0xD0 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x00A6, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201A, 0x82 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F5, 0xF5 }, { 0x0000, 0x00 }, { 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x00AF, 0xAF }, { 0x0000, 0x00 }, { 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0160, 0x8A }, { 0x0000, 0x00 }, { 0x0152, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FE, 0xFE }, { 0x0000, 0x00 }, { 0x00F0, 0xF0 }, { 0x0000, 0x00 }, { 0x00E2, 0xE2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 }, { 0x0000, 0x00 },
+				{ 0x00AA, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x203A, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x201E, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F9, 0xF9 }, { 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DD, 0xDD }, { 0x0000, 0x00 }, { 0x00CF, 0xCF },
+				{ 0x0000, 0x00 }, { 0x00C1, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02C6, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 },
+				{ 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BC, 0xBC },
+				{ 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2030, 0x89 }, { 0x0000, 0x00 },
+				{ 0x2022, 0x95 }, { 0x0000, 0x00 }, { 0x2014, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00FD, 0xFD }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0192, 0x83 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 },
+				{ 0x2122, 0x99 }, { 0x2039, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 },
+				{ 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC }, { 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 },
+				{ 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2026, 0x85 }, { 0x0000, 0x00 }, { 0x2018, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 }, { 0x0000, 0x00 },
+				{ 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x00AD, 0xAD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2021, 0x87 }, { 0x0000, 0x00 },
+				{ 0x2013, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02DC, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC },
+				{ 0x0000, 0x00 }, { 0x00EE, 0xEE }, { 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201C, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 }, { 0x0000, 0x00 }, { 0x00E9, 0xE9 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1253
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x0000, 0x2030, 0x0000, 0x2039, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x0000, 0x2122, 0x0000, 0x203A, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x00A0, 0x0385, 0x0386, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x0000, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x2015,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x0384, 0x00B5, 0x00B6, 0x00B7, 0x0388, 0x0389, 0x038A, 0x00BB, 0x038C, 0x00BD, 0x038E, 0x038F,
+				0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397, 0x0398, 0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F,
+				0x03A0, 0x03A1, 0x0000, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7, 0x03A8, 0x03A9, 0x03AA, 0x03AB, 0x03AC, 0x03AD, 0x03AE, 0x03AF,
+				0x03B0, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7, 0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+				0x03C0, 0x03C1, 0x03C2, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7, 0x03C8, 0x03C9, 0x03CA, 0x03CB, 0x03CC, 0x03CD, 0x03CE, 0x0000,
+			},
+			0x9E3779B1,
+			{
+				{ 0x0000, 0x00 }, { 0x201A, 0x82 }, { 0x0000, 0x00 }, { 0x03A4, 0xD4 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x038F, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x039C, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A9, 0xD9 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03CB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0394, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A1, 0xD1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2039, 0x8B }, { 0x2122, 0x99 }, { 0x03C3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x038C, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03AE, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0399, 0xC9 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03BB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0384, 0xB4 }, { 0x0000, 0x00 },
+				{ 0x20AC, 0x80 }, { 0x0000, 0x00 }, { 0x201C, 0x93 }, { 0x0000, 0x00 }, { 0x03A6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0391, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2014, 0x97 },
+				{ 0x0000, 0x00 }, { 0x039E, 0xCE }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03C0, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0389, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2021, 0x87 }, { 0x0000, 0x00 }, { 0x03AB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03CD, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0396, 0xC6 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 }, { 0x0000, 0x00 }, { 0x03A3, 0xD3 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C5, 0xF5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x038E, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2026, 0x85 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03B0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x039B, 0xCB }, { 0x00A9, 0xA9 }, { 0x0192, 0x83 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BD, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0386, 0xA2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201E, 0x84 }, { 0x0000, 0x00 }, { 0x03A8, 0xD8 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03CA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0393, 0xC3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B5, 0xE5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03A0, 0xD0 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03C2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AD, 0xDD }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0398, 0xC8 }, { 0x00A6, 0xA6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2030, 0x89 }, { 0x0000, 0x00 }, { 0x03BA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03A5, 0xD5 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C7, 0xF7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0390, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03B2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2013, 0x96 }, { 0x0000, 0x00 }, { 0x039D, 0xCD }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0388, 0xB8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x0000, 0x00 }, { 0x03AA, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03CC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0395, 0xC5 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x03B7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2018, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x203A, 0x9B },
+				{ 0x0000, 0x00 }, { 0x03C4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03AF, 0xDF }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x039A, 0xCA },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03BC, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0385, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03A7, 0xD7 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C9, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0392, 0xC2 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03B4, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2015, 0xAF }, { 0x0000, 0x00 }, { 0x039F, 0xCF }, { 0x00AD, 0xAD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03C1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x038A, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x0000, 0x00 }, { 0x03AC, 0xDC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x03CE, 0xFE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0397, 0xC7 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x03B9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1254
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x0000, 0x0000, 0x0000,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x0000, 0x0000, 0x0178,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+				0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+				0x011E, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x0130, 0x015E, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+				0x011F, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x0131, 0x015F, 0x00FF,
+			},
+			0x561D0773,
+			{
+				{ 0x0000, 0x00 }, { 0x00DC, 0xDC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2013, 0x96 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E5, 0xE5 },
+				{ 0x0153, 0x9C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 }, { 0x00E8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x201C, 0x93 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x00F1, 0xF1 }, { 0x015F, 0xFE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F4, 0xF4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x203A, 0x9B },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x2122, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AA, 0xAA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 },
+				{ 0x011E, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0192, 0x83 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x02DC, 0x98 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BF, 0xBF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0130, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C5, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2014, 0x97 }, { 0x00E3, 0xE3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201A, 0x82 },
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x00EC, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F2, 0xF2 }, { 0x0160, 0x8A },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2026, 0x85 }, { 0x00F5, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0178, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x20AC, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A8, 0xA8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x011F, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B4, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BA, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C3, 0xC3 }, { 0x0131, 0xFD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CC, 0xCC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D2, 0xD2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D5, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E1, 0xE1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0152, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2018, 0x91 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x201E, 0x84 }, { 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2021, 0x87 }, { 0x0000, 0x00 }, { 0x015E, 0xDE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0161, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2030, 0x89 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2039, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A3, 0xA3 }, { 0x02C6, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B8, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CA, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1255
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0000, 0x2039, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0000, 0x203A, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x20AA, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00D7, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00F7, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+				0x05B0, 0x05B1, 0x05B2, 0x05B3, 0x05B4, 0x05B5, 0x05B6, 0x05B7, 0x05B8, 0x05B9, 0x0000, 0x05BB, 0x05BC, 0x05BD, 0x05BE, 0x05BF,
+				0x05C0, 0x05C1, 0x05C2, 0x05C3, 0x05F0, 0x05F1, 0x05F2, 0x05F3, 0x05F4, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+				0x05D0, 0x05D1, 0x05D2, 0x05D3, 0x05D4, 0x05D5, 0x05D6, 0x05D7, 0x05D8, 0x05D9, 0x05DA, 0x05DB, 0x05DC, 0x05DD, 0x05DE, 0x05DF,
+				0x05E0, 0x05E1, 0x05E2, 0x05E3, 0x05E4, 0x05E5, 0x05E6, 0x05E7, 0x05E8, 0x05E9, 0x05EA, 0x0000, 0x0000, 0x200E, 0x200F, 0x0000,
+			},
+			0x2C684585,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05F2, 0xD6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05DB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x05E1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B3, 0xC3 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 },
+				{ 0x203A, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E7, 0xF7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x05B9, 0xC9 }, { 0x0000, 0x00 }, { 0x00BF, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x05D6, 0xE6 }, { 0x02C6, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05BF, 0xCF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05F3, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2018, 0x91 }, { 0x05DC, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x201E, 0x84 }, { 0x05E2, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E8, 0xF8 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D1, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D7, 0xAA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2013, 0x96 }, { 0x05D7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2122, 0x99 }, { 0x0000, 0x00 }, { 0x05C0, 0xD0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AF, 0xAF }, { 0x0000, 0x00 },
+				{ 0x2030, 0x89 }, { 0x05F4, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 }, { 0x05DD, 0xED }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05E3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B5, 0xC5 }, { 0x0000, 0x00 },
+				{ 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05E9, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x200E, 0xFD }, { 0x05D2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05BB, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2014, 0x97 }, { 0x05D8, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05C1, 0xD1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AA, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201A, 0x82 }, { 0x05DE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B0, 0xC0 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x05E4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B6, 0xC6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0000, 0x00 },
+				{ 0x2026, 0x85 }, { 0x05EA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x200F, 0xFE }, { 0x05D3, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05BC, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05F0, 0xD4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05C2, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05DF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0192, 0x83 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B1, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x2021, 0x87 }, { 0x05E5, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B7, 0xC7 },
+				{ 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05D4, 0xE4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05BD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05F1, 0xD5 },
+				{ 0x0000, 0x00 }, { 0x00F7, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05DA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x05C3, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AC, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x201C, 0x93 }, { 0x05E0, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05B2, 0xC2 }, { 0x0000, 0x00 }, { 0x00B8, 0xB8 }, { 0x0000, 0x00 }, { 0x2039, 0x8B },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x05E6, 0xF6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05B8, 0xC8 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02DC, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x05D5, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x05BE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1256
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x067E, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0679, 0x2039, 0x0152, 0x0686, 0x0698, 0x0688,
+				0x06AF, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x06A9, 0x2122, 0x0691, 0x203A, 0x0153, 0x200C, 0x200D, 0x06BA,
+				0x00A0, 0x060C, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x06BE, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x061B, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x061F,
+				0x06C1, 0x0621, 0x0622, 0x0623, 0x0624, 0x0625, 0x0626, 0x0627, 0x0628, 0x0629, 0x062A, 0x062B, 0x062C, 0x062D, 0x062E, 0x062F,
+				0x0630, 0x0631, 0x0632, 0x0633, 0x0634, 0x0635, 0x0636, 0x00D7, 0x0637, 0x0638, 0x0639, 0x063A, 0x0640, 0x0641, 0x0642, 0x0643,
+				0x00E0, 0x0644, 0x00E2, 0x0645, 0x0646, 0x0647, 0x0648, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x0649, 0x064A, 0x00EE, 0x00EF,
+				0x064B, 0x064C, 0x064D, 0x064E, 0x00F4, 0x064F, 0x0650, 0x00F7, 0x0651, 0x00F9, 0x0652, 0x00FB, 0x00FC, 0x200E, 0x200F, 0x06D2,
+			},
+			0xD5701B6B,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0688, 0x8F }, { 0x200C, 0x9D }, { 0x0000, 0x00 }, { 0x2018, 0x91 }, { 0x0000, 0x00 }, { 0x201E, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2030, 0x89 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x06BE, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 }, { 0x00A8, 0xA8 }, { 0x00AE, 0xAE }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x061B, 0xBA }, { 0x0000, 0x00 },
+				{ 0x0621, 0xC1 }, { 0x0627, 0xC7 }, { 0x062D, 0xCD }, { 0x0633, 0xD3 }, { 0x0000, 0x00 }, { 0x0639, 0xDA }, { 0x0000, 0x00 }, { 0x0645, 0xE3 },
+				{ 0x064B, 0xF0 }, { 0x0000, 0x00 }, { 0x0651, 0xF8 }, { 0x0000, 0x00 }, { 0x0192, 0x83 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201D, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A7, 0xA7 }, { 0x00AD, 0xAD }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E9, 0xE9 }, { 0x00EF, 0xEF },
+				{ 0x0000, 0x00 }, { 0x00FB, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0626, 0xC6 }, { 0x062C, 0xCC },
+				{ 0x0000, 0x00 }, { 0x0632, 0xD2 }, { 0x0638, 0xD9 }, { 0x0000, 0x00 }, { 0x0644, 0xE1 }, { 0x0000, 0x00 }, { 0x064A, 0xED }, { 0x0650, 0xF6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0686, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0698, 0x8E }, { 0x201C, 0x93 },
+				{ 0x2022, 0x95 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x203A, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x00A6, 0xA6 }, { 0x00AC, 0xAC }, { 0x00B2, 0xB2 },
+				{ 0x0000, 0x00 }, { 0x00B8, 0xB8 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AC, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x00EE, 0xEE }, { 0x00F4, 0xF4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x061F, 0xBF }, { 0x0625, 0xC5 }, { 0x062B, 0xCB }, { 0x0000, 0x00 }, { 0x0631, 0xD1 }, { 0x0637, 0xD8 },
+				{ 0x0000, 0x00 }, { 0x0643, 0xDF }, { 0x0000, 0x00 }, { 0x0649, 0xEC }, { 0x064F, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0679, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x200F, 0xFE }, { 0x0691, 0x9A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2021, 0x87 }, { 0x0000, 0x00 }, { 0x06A9, 0x98 },
+				{ 0x06AF, 0x90 }, { 0x0000, 0x00 }, { 0x2039, 0x8B }, { 0x0000, 0x00 }, { 0x06C1, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x00B7, 0xB7 }, { 0x00BD, 0xBD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E7, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x060C, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0153, 0x9C }, { 0x0000, 0x00 },
+				{ 0x0624, 0xC4 }, { 0x0000, 0x00 }, { 0x062A, 0xCA }, { 0x0630, 0xD0 }, { 0x0636, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0642, 0xDE },
+				{ 0x0648, 0xE6 }, { 0x064E, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x067E, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x200E, 0xFD },
+				{ 0x2014, 0x97 }, { 0x201A, 0x82 }, { 0x2020, 0x86 }, { 0x0000, 0x00 }, { 0x2026, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x06BA, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x06D2, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 }, { 0x00B6, 0xB6 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E0, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2122, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0152, 0x8C }, { 0x0623, 0xC3 }, { 0x0000, 0x00 }, { 0x0629, 0xC9 },
+				{ 0x062F, 0xCF }, { 0x0635, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0641, 0xDD }, { 0x0647, 0xE5 }, { 0x064D, 0xF2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x200D, 0x9E }, { 0x2013, 0x96 }, { 0x2019, 0x92 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x00A9, 0xA9 }, { 0x00AF, 0xAF },
+				{ 0x00B5, 0xB5 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x02C6, 0x88 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0622, 0xC2 }, { 0x0628, 0xC8 }, { 0x062E, 0xCE }, { 0x0634, 0xD4 }, { 0x0000, 0x00 },
+				{ 0x063A, 0xDB }, { 0x0640, 0xDC }, { 0x0646, 0xE4 }, { 0x064C, 0xF1 }, { 0x0000, 0x00 }, { 0x0652, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1257
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0000, 0x201E, 0x2026, 0x2020, 0x2021, 0x0000, 0x2030, 0x0000, 0x2039, 0x0000, 0x00A8, 0x02C7, 0x00B8,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x0000, 0x2122, 0x0000, 0x203A, 0x0000, 0x00AF, 0x02DB, 0x0000,
+				0x00A0, 0x0000, 0x00A2, 0x00A3, 0x00A4, 0x0000, 0x00A6, 0x00A7, 0x00D8, 0x00A9, 0x0156, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00C6,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00F8, 0x00B9, 0x0157, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00E6,
+				0x0104, 0x012E, 0x0100, 0x0106, 0x00C4, 0x00C5, 0x0118, 0x0112, 0x010C, 0x00C9, 0x0179, 0x0116, 0x0122, 0x0136, 0x012A, 0x013B,
+				0x0160, 0x0143, 0x0145, 0x00D3, 0x014C, 0x00D5, 0x00D6, 0x00D7, 0x0172, 0x0141, 0x015A, 0x016A, 0x00DC, 0x017B, 0x017D, 0x00DF,
+				0x0105, 0x012F, 0x0101, 0x0107, 0x00E4, 0x00E5, 0x0119, 0x0113, 0x010D, 0x00E9, 0x017A, 0x0117, 0x0123, 0x0137, 0x012B, 0x013C,
+				0x0161, 0x0144, 0x0146, 0x00F3, 0x014D, 0x00F5, 0x00F6, 0x00F7, 0x0173, 0x0142, 0x015B, 0x016B, 0x00FC, 0x017C, 0x017E, 0x02D9,
+			},
+			0x0B05A081,
+			{
+				{ 0x0000, 0x00 }, { 0x012E, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0117, 0xEB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A3, 0xA3 }, { 0x0000, 0x00 }, { 0x0100, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0146, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012F, 0xE1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0118, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 },
+				{ 0x0000, 0x00 }, { 0x0101, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0119, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AC, 0x80 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2021, 0x87 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BD, 0xBD }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0160, 0xD0 },
+				{ 0x2039, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x0000, 0x00 }, { 0x00D5, 0xD5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2122, 0x99 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0104, 0xC0 }, { 0x0000, 0x00 }, { 0x0161, 0xF0 }, { 0x203A, 0x9B }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0179, 0xCA }, { 0x00A8, 0x8D },
+				{ 0x0000, 0x00 }, { 0x0105, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017A, 0xEA }, { 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0106, 0xC3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014C, 0xD4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017B, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0107, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x014D, 0xF4 }, { 0x2026, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0136, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x017C, 0xFD }, { 0x00AB, 0xAB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02D9, 0xFF }, { 0x0137, 0xED },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017D, 0xDE }, { 0x00AC, 0xAC },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x017E, 0xFE }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00DC, 0xDC }, { 0x02DB, 0x9E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C5, 0xC5 }, { 0x0000, 0x00 },
+				{ 0x0122, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2013, 0x96 }, { 0x0000, 0x00 }, { 0x00C6, 0xAF }, { 0x0000, 0x00 }, { 0x0123, 0xEC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00AF, 0x9D }, { 0x0000, 0x00 }, { 0x010C, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00F5, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x013B, 0xCF },
+				{ 0x0000, 0x00 }, { 0x2014, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0xB0 },
+				{ 0x0000, 0x00 }, { 0x010D, 0xE8 }, { 0x0000, 0x00 }, { 0x016A, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x013C, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x02C7, 0x8E }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x016B, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xB8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0156, 0xAA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2018, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0157, 0xBA }, { 0x2030, 0x89 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0112, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x0141, 0xD9 }, { 0x201A, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x012A, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0113, 0xE7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00E5, 0xE5 }, { 0x0000, 0x00 }, { 0x0142, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x012B, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x015A, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E6, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0143, 0xD1 }, { 0x201C, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B8, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0172, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x015B, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0144, 0xF1 }, { 0x201D, 0x94 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 },
+				{ 0x0116, 0xCB }, { 0x0000, 0x00 }, { 0x0173, 0xF8 }, { 0x00A2, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0145, 0xD2 }, { 0x201E, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+			},
+		},
+		// CP1258
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0000, 0x2039, 0x0152, 0x0000, 0x0000, 0x0000,
+				0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0000, 0x203A, 0x0153, 0x0000, 0x0000, 0x0178,
+				0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+				0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+				0x00C0, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x0300, 0x00CD, 0x00CE, 0x00CF,
+				0x0110, 0x00D1, 0x0309, 0x00D3, 0x00D4, 0x01A0, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x01AF, 0x0303, 0x00DF,
+				0x00E0, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x0301, 0x00ED, 0x00EE, 0x00EF,
+				0x0111, 0x00F1, 0x0323, 0x00F3, 0x00F4, 0x01A1, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x01B0, 0x20AB, 0x00FF,
+			},
+			0xBF68E5AF,
+			{
+				{ 0x2030, 0x89 }, { 0x0000, 0x00 }, { 0x01B0, 0xFD }, { 0x00D6, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CE, 0xCE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00CA, 0xCA }, { 0x0000, 0x00 }, { 0x2020, 0x86 }, { 0x01A0, 0xD5 }, { 0x0000, 0x00 }, { 0x00C6, 0xC6 }, { 0x0000, 0x00 },
+				{ 0x201C, 0x93 }, { 0x0000, 0x00 }, { 0x00C2, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2018, 0x91 }, { 0x0000, 0x00 }, { 0x00BE, 0xBE },
+				{ 0x0000, 0x00 }, { 0x2014, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BA, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00B6, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0xB2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AE, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AA, 0xAA },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A6, 0xA6 }, { 0x0111, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A2, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0178, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F9, 0xF9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F1, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00ED, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E9, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00E5, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0300, 0xCC }, { 0x00E1, 0xE1 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D9, 0xD9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x01AF, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D1, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CD, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C9, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C5, 0xC5 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C1, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x02DC, 0x98 },
+				{ 0x00BD, 0xBD }, { 0x0000, 0x00 }, { 0x2013, 0x96 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B9, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B5, 0xB5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B1, 0xB1 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AD, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00A9, 0xA9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A5, 0xA5 }, { 0x0110, 0xD0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A1, 0xA1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0323, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FC, 0xFC }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F8, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F4, 0xF4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E8, 0xE8 }, { 0x0153, 0x9C },
+				{ 0x0000, 0x00 }, { 0x0303, 0xDE }, { 0x00E4, 0xE4 }, { 0x0000, 0x00 }, { 0x203A, 0x9B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00E0, 0xE0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DC, 0xDC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00D8, 0xD8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D4, 0xD4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2026, 0x85 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2022, 0x95 }, { 0x0000, 0x00 }, { 0x00C8, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x201E, 0x84 }, { 0x0000, 0x00 },
+				{ 0x00C4, 0xC4 }, { 0x0000, 0x00 }, { 0x201A, 0x82 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00C0, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BC, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0192, 0x83 }, { 0x00B8, 0xB8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B4, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00B0, 0xB0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AC, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00A8, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A4, 0xA4 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A0, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0103, 0xE3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FF, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00FB, 0xFB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00F3, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EF, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EB, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AC, 0x80 }, { 0x00E7, 0xE7 },
+				{ 0x0152, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2039, 0x8B }, { 0x0000, 0x00 },
+				{ 0x00DF, 0xDF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DB, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D7, 0xD7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00D3, 0xD3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00CF, 0xCF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00CB, 0xCB }, { 0x0000, 0x00 }, { 0x2021, 0x87 }, { 0x01A1, 0xF5 }, { 0x0000, 0x00 }, { 0x00C7, 0xC7 }, { 0x0000, 0x00 }, { 0x201D, 0x94 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2019, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BF, 0xBF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00BB, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0xB7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B3, 0xB3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x00AF, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00AB, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x02C6, 0x88 }, { 0x00A7, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A3, 0xA3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0102, 0xC3 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x00FA, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F6, 0xF6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2122, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00EE, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0309, 0xD2 }, { 0x00EA, 0xEA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x20AB, 0xFE },
+				{ 0x00E6, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0301, 0xEC }, { 0x00E2, 0xE2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00DA, 0xDA }, { 0x0000, 0x00 },
+			},
+		},
+		// KOI8-R
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524, 0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+				0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248, 0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+				0x2550, 0x2551, 0x2552, 0x0451, 0x2553, 0x2554, 0x2555, 0x2556, 0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x255C, 0x255D, 0x255E,
+				0x255F, 0x2560, 0x2561, 0x0401, 0x2562, 0x2563, 0x2564, 0x2565, 0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x256B, 0x256C, 0x00A9,
+				0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433, 0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+				0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432, 0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+				0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413, 0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+				0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412, 0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A,
+			},
+			0x15D053C9,
+			{
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042C, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2551, 0xA1 }, { 0x0000, 0x00 },
+				{ 0x2580, 0x8B }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0438, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x255D, 0xAE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x258C, 0x8E }, { 0x0000, 0x00 }, { 0x0415, 0xE5 }, { 0x0000, 0x00 },
+				{ 0x00F7, 0x9F }, { 0x0444, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2569, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0421, 0xF3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042D, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2552, 0xA2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2500, 0x80 }, { 0x0439, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x255E, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0416, 0xF6 }, { 0x250C, 0x82 }, { 0x0445, 0xC8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x256A, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0422, 0xF4 }, { 0x0000, 0x00 }, { 0x2518, 0x85 },
+				{ 0x0451, 0xA3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B2, 0x9D }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x042E, 0xE0 }, { 0x2524, 0x87 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2553, 0xA4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2264, 0x98 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043A, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x255F, 0xB0 }, { 0x0000, 0x00 }, { 0x2320, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0417, 0xFA }, { 0x0000, 0x00 },
+				{ 0x0446, 0xC3 }, { 0x253C, 0x8A }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x256B, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0423, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042F, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2554, 0xA5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2265, 0x99 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2502, 0x81 },
+				{ 0x043B, 0xCC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2560, 0xB1 }, { 0x0000, 0x00 }, { 0x2321, 0x9B }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0418, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0447, 0xDE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x256C, 0xBE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0424, 0xE6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0401, 0xB3 }, { 0x0000, 0x00 },
+				{ 0x0430, 0xC1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2555, 0xA6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2584, 0x8C },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043C, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2561, 0xB2 }, { 0x0000, 0x00 }, { 0x2590, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0419, 0xEA }, { 0x0000, 0x00 }, { 0x0448, 0xDB },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00A9, 0xBF }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0425, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0431, 0xC2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2556, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043D, 0xCE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2562, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2591, 0x90 }, { 0x0000, 0x00 },
+				{ 0x041A, 0xEB }, { 0x0000, 0x00 }, { 0x2510, 0x83 }, { 0x0449, 0xDD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0426, 0xE3 }, { 0x251C, 0x86 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0432, 0xD7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2557, 0xA8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043E, 0xCF }, { 0x2534, 0x89 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2563, 0xB5 },
+				{ 0x0000, 0x00 }, { 0x2592, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041B, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044A, 0xDF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0427, 0xFE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B7, 0x9E },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0433, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2558, 0xA9 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0410, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043F, 0xD0 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2564, 0xB6 }, { 0x0000, 0x00 }, { 0x00A0, 0x9A }, { 0x2593, 0x92 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041C, 0xED }, { 0x0000, 0x00 }, { 0x044B, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0428, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0434, 0xC4 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2559, 0xAA }, { 0x0000, 0x00 }, { 0x2588, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0411, 0xE2 }, { 0x0000, 0x00 }, { 0x0440, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2565, 0xB7 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041D, 0xEE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044C, 0xD8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x25A0, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0429, 0xFD },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0435, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x255A, 0xAB }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0412, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0441, 0xD3 }, { 0x0000, 0x00 },
+				{ 0x2219, 0x95 }, { 0x0000, 0x00 }, { 0x2566, 0xB8 }, { 0x2248, 0x97 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041E, 0xEF },
+				{ 0x2514, 0x84 }, { 0x044D, 0xDC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042A, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0436, 0xD6 }, { 0x252C, 0x88 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x255B, 0xAC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0413, 0xE7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0442, 0xD4 }, { 0x0000, 0x00 }, { 0x221A, 0x96 }, { 0x2567, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041F, 0xF0 }, { 0x0000, 0x00 }, { 0x044E, 0xC0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042B, 0xF9 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2550, 0xA0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0437, 0xDA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x255C, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0414, 0xE4 }, { 0x0000, 0x00 }, { 0x0443, 0xD5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2568, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0420, 0xF2 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x044F, 0xD1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00B0, 0x9C }, { 0x0000, 0x00 },
+			},
+		},
+		// KOI8-U
+		{
+			{
+				0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+				0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+				0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+				0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+				0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+				0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+				0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+				0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+				0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524, 0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+				0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248, 0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+				0x2550, 0x2551, 0x2552, 0x0451, 0x0454, 0x2554, 0x0456, 0x0457, 0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x0491, 0x255D, 0x255E,
+				0x255F, 0x2560, 0x2561, 0x0401, 0x0404, 0x2563, 0x0406, 0x0407, 0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x0490, 0x256C, 0x00A9,
+				0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433, 0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+				0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432, 0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+				0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413, 0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+				0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412, 0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A,
+			},
+			0xFE4E2B45,
+			{
+				{ 0x0000, 0x00 }, { 0x0421, 0xF3 }, { 0x0000, 0x00 }, { 0x252C, 0x88 }, { 0x0420, 0xF2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x041F, 0xF0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041E, 0xEF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041D, 0xEE },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041C, 0xED }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x041B, 0xEC }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x041A, 0xEB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0419, 0xEA }, { 0x0000, 0x00 }, { 0x2524, 0x87 }, { 0x0000, 0x00 },
+				{ 0x0418, 0xE9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0417, 0xFA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0416, 0xF6 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0415, 0xE5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0414, 0xE4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0413, 0xE7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0412, 0xF7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0411, 0xE2 },
+				{ 0x0000, 0x00 }, { 0x251C, 0x86 }, { 0x0000, 0x00 }, { 0x0410, 0xE1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2518, 0x85 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2514, 0x84 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0407, 0xB7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0406, 0xB6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2510, 0x83 }, { 0x0404, 0xB4 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x221A, 0x96 }, { 0x0000, 0x00 }, { 0x0401, 0xB3 }, { 0x2219, 0x95 }, { 0x250C, 0x82 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x25A0, 0x94 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0491, 0xAD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0490, 0xBD }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2502, 0x81 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2500, 0x80 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2593, 0x92 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2592, 0x91 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2591, 0x90 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2590, 0x8F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x00F7, 0x9F }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x258C, 0x8E }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2588, 0x8D }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x2584, 0x8C }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2580, 0x8B }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2321, 0x9B },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2320, 0x93 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x256C, 0xBE }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x256A, 0xBC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2569, 0xBB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2568, 0xBA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2567, 0xB9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2566, 0xB8 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x2563, 0xB5 }, { 0x0000, 0x00 }, { 0x0457, 0xA7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0456, 0xA6 }, { 0x0000, 0x00 }, { 0x2561, 0xB2 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x2560, 0xB1 }, { 0x0454, 0xA4 }, { 0x0000, 0x00 }, { 0x255F, 0xB0 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x255E, 0xAF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x255D, 0xAE }, { 0x0451, 0xA3 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x255B, 0xAC }, { 0x044F, 0xD1 }, { 0x0000, 0x00 }, { 0x255A, 0xAB },
+				{ 0x044E, 0xC0 }, { 0x0000, 0x00 }, { 0x2559, 0xAA }, { 0x0000, 0x00 }, { 0x044D, 0xDC }, { 0x2265, 0x99 }, { 0x2558, 0xA9 }, { 0x044C, 0xD8 },
+				{ 0x2264, 0x98 }, { 0x2557, 0xA8 }, { 0x0000, 0x00 }, { 0x044B, 0xD9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x044A, 0xDF }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0449, 0xDD }, { 0x0000, 0x00 }, { 0x2554, 0xA5 }, { 0x0000, 0x00 }, { 0x0448, 0xDB }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0447, 0xDE }, { 0x0000, 0x00 }, { 0x2552, 0xA2 }, { 0x0000, 0x00 }, { 0x0446, 0xC3 }, { 0x2551, 0xA1 }, { 0x0000, 0x00 }, { 0x0445, 0xC8 },
+				{ 0x0000, 0x00 }, { 0x2550, 0xA0 }, { 0x0444, 0xC6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0443, 0xD5 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0442, 0xD4 }, { 0x0000, 0x00 }, { 0x00B7, 0x9E }, { 0x0000, 0x00 }, { 0x0441, 0xD3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0440, 0xD2 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043F, 0xD0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043E, 0xCF },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x043D, 0xCE }, { 0x0000, 0x00 }, { 0x00B2, 0x9D }, { 0x043C, 0xCD }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x043B, 0xCC }, { 0x0000, 0x00 }, { 0x00B0, 0x9C }, { 0x043A, 0xCB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0439, 0xCA }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0438, 0xC9 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0437, 0xDA }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0436, 0xD6 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0435, 0xC5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0000, 0x00 }, { 0x0434, 0xC4 }, { 0x0000, 0x00 }, { 0x00A9, 0xBF }, { 0x0433, 0xC7 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0432, 0xD7 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0431, 0xC2 }, { 0x0000, 0x00 }, { 0x253C, 0x8A }, { 0x0430, 0xC1 }, { 0x2248, 0x97 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042F, 0xF1 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042E, 0xE0 }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x042D, 0xFC }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042C, 0xF8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x042B, 0xF9 },
+				{ 0x0000, 0x00 }, { 0x00A0, 0x9A }, { 0x0000, 0x00 }, { 0x042A, 0xFF }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0429, 0xFD }, { 0x0000, 0x00 },
+				{ 0x2534, 0x89 }, { 0x0428, 0xFB }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0427, 0xFE }, { 0x0000, 0x00 }, { 0x0000, 0x00 },
+				{ 0x0426, 0xE3 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0425, 0xE8 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0424, 0xE6 },
+				{ 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0423, 0xF5 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0000, 0x00 }, { 0x0422, 0xF4 }, { 0x0000, 0x00 },
+			},
+		},
+	};
+}
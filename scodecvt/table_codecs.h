@@ -0,0 +1,476 @@
+﻿#ifndef __SIMPLE_CODECVT_TABLE_CODECS_H__
+#define __SIMPLE_CODECVT_TABLE_CODECS_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "dbcs_tables.h"
+#include "utf_kernels.h"
+
+// Codecs for legacy encodings that are driven by lookup tables, and the conversion loop that
+// runs them. They follow the codec traits of utf_kernels.h, except that a table codec may not
+// be able to encode every code point, in which case its length() is 0, and that it has no
+// starts_sequence(): a trail byte cannot be told from a character without decoding from the
+// start. Every table codec is a superset of ASCII with one-byte units.
+namespace simple_codecvt::detail
+{
+	// The linear index of the GB18030 four-byte code b0 b1 b2 b3 is
+	// ((b0 - 0x81) * 10 + b1 - 0x30) * 1260 + (b2 - 0x81) * 10 + b3 - 0x30.
+	constexpr std::size_t gb18030_two_byte_count = 126 * 190;
+	constexpr std::size_t gb18030_code_block_count = 131;
+	constexpr std::size_t gb18030_linear_page_count = 308;
+	constexpr std::size_t gb18030_linear_block_count = 55;
+	constexpr std::uint32_t gb18030_bmp_linear_count = 39420;
+	constexpr std::uint32_t gb18030_supplementary_linear = 189000;
+	constexpr std::uint16_t gb18030_min_two_byte_code = 0x8140;
+
+	// Code points of the two-byte codes, at (lead - 0x81) * 190 + the index of the trail byte
+	// in 0x40-0x7E, 0x80-0xFE.
+	extern const char16_t gb18030_two_byte[gb18030_two_byte_count];
+
+	// Codes of the BMP by page of 256 code points: gb18030_code_blocks[gb18030_code_pages[cp >> 8]]
+	// [cp & 0xFF] is the two-byte code of cp if it is at least gb18030_min_two_byte_code, and
+	// otherwise the linear index of its four-byte code less gb18030_code_bases[cp >> 8]. Block 0
+	// holds 0, 1, 2... and is shared by the pages that are a single run of four-byte codes.
+	extern const std::uint8_t gb18030_code_pages[256];
+	extern const std::uint16_t gb18030_code_bases[256];
+	extern const std::uint16_t gb18030_code_blocks[gb18030_code_block_count][256];
+
+	// Code points of the four-byte codes in the BMP by page of 128 linear indices, laid out the
+	// same way.
+	extern const std::uint8_t gb18030_linear_pages[gb18030_linear_page_count];
+	extern const char16_t gb18030_linear_bases[gb18030_linear_page_count];
+	extern const std::uint16_t gb18030_linear_blocks[gb18030_linear_block_count][128];
+
+	// The single-byte code pages, in the order of simple_codecvt::encoding from Latin-1 on.
+	constexpr std::size_t single_byte_table_count = 26;
+	extern const single_byte_table single_byte_tables[single_byte_table_count];
+	inline constexpr const single_byte_table *latin1_table = single_byte_tables;
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	inline std::uint16_t gb18030_code(char32_t cp) noexcept
+	{
+		return gb18030_code_blocks[gb18030_code_pages[cp >> 8]][cp & 0xFF];
+	}
+
+	// Code point of a linear index below gb18030_bmp_linear_count.
+	inline char32_t gb18030_code_point(std::uint32_t linear) noexcept
+	{
+		return gb18030_linear_bases[linear >> 7] + gb18030_linear_blocks[gb18030_linear_pages[linear >> 7]][linear & 0x7F];
+	}
+
+	// GB18030-2022, or with `Gbk` its GBK subset as Windows code page 936 has it: the one- and
+	// two-byte codes, plus 0x80 for the euro sign.
+	template <bool Gbk>
+	struct gb18030_codec
+	{
+		using char_type = char8_t;
+
+		static transcode_status decode(const char8_t *&src, const char8_t *last, char32_t &cp) noexcept
+		{
+			const std::uint32_t c0 = src[0];
+			if (c0 < 0x80)
+			{
+				cp = c0;
+				src += 1;
+				return transcode_status::ok;
+			}
+			if (Gbk && c0 == 0x80)
+			{
+				cp = 0x20AC;
+				src += 1;
+				return transcode_status::ok;
+			}
+			if (c0 == 0x80 || c0 == 0xFF)
+			{
+				return transcode_status::invalid;
+			}
+
+			const auto avail = static_cast<std::size_t>(last - src);
+			if (avail < 2)
+			{
+				return transcode_status::incomplete;
+			}
+			const std::uint32_t c1 = src[1];
+			if (c1 >= 0x40 && c1 != 0x7F && c1 != 0xFF)
+			{
+				cp = gb18030_two_byte[(c0 - 0x81) * 190 + c1 - (c1 < 0x7F ? 0x40 : 0x41)];
+				src += 2;
+				return transcode_status::ok;
+			}
+			if (Gbk || c1 < 0x30 || c1 > 0x39)
+			{
+				return transcode_status::invalid;
+			}
+			if (avail < 3)
+			{
+				return transcode_status::incomplete;
+			}
+			const std::uint32_t c2 = src[2];
+			if (c2 < 0x81 || c2 > 0xFE)
+			{
+				return transcode_status::invalid;
+			}
+			if (avail < 4)
+			{
+				return transcode_status::incomplete;
+			}
+			const std::uint32_t c3 = src[3];
+			if (c3 < 0x30 || c3 > 0x39)
+			{
+				return transcode_status::invalid;
+			}
+			const auto linear = (((c0 - 0x81) * 10 + c1 - 0x30) * 126 + c2 - 0x81) * 10 + c3 - 0x30;
+			if (linear < gb18030_bmp_linear_count)
+			{
+				cp = gb18030_code_point(linear);
+			}
+			else if (linear - gb18030_supplementary_linear < 0x100000)
+			{
+				cp = linear - gb18030_supplementary_linear + 0x10000;
+			}
+			else
+			{
+				return transcode_status::invalid;
+			}
+			src += 4;
+			return transcode_status::ok;
+		}
+
+		// A well-formed four-byte code without a character is skipped whole, as is a truncated
+		// one at the end; otherwise only the lead byte is, the next byte may start a character.
+		static std::size_t invalid_length(const char8_t *src, const char8_t *last) noexcept
+		{
+			const auto avail = static_cast<std::size_t>(last - src);
+			std::size_t n = 1;
+			if (!Gbk && avail >= 2 && src[1] >= 0x30 && src[1] <= 0x39)
+			{
+				n = 2;
+				if (avail >= 3 && src[2] >= 0x81 && src[2] <= 0xFE)
+				{
+					n = 3;
+					if (avail >= 4 && src[3] >= 0x30 && src[3] <= 0x39)
+					{
+						n = 4;
+					}
+				}
+			}
+			return n == 4 || n == avail ? n : 1;
+		}
+
+		static std::size_t length(char32_t cp) noexcept
+		{
+			if (cp < 0x80 || (Gbk && cp == 0x20AC))
+			{
+				return 1;
+			}
+			if (cp < 0x10000 && gb18030_code(cp) >= gb18030_min_two_byte_code)
+			{
+				return 2;
+			}
+			return Gbk ? 0 : 4;
+		}
+
+		static char8_t *encode(char32_t cp, char8_t *dst) noexcept
+		{
+			if (cp < 0x80)
+			{
+				*dst++ = static_cast<char8_t>(cp);
+				return dst;
+			}
+			if (Gbk && cp == 0x20AC)
+			{
+				*dst++ = 0x80;
+				return dst;
+			}
+			auto linear = cp - 0x10000 + gb18030_supplementary_linear;
+			if (cp < 0x10000)
+			{
+				const auto code = gb18030_code(cp);
+				if (code >= gb18030_min_two_byte_code)
+				{
+					*dst++ = static_cast<char8_t>(code >> 8);
+					*dst++ = static_cast<char8_t>(code);
+					return dst;
+				}
+				linear = gb18030_code_bases[cp >> 8] + code;
+			}
+			dst[3] = static_cast<char8_t>(0x30 + linear % 10);
+			linear /= 10;
+			dst[2] = static_cast<char8_t>(0x81 + linear % 126);
+			linear /= 126;
+			dst[1] = static_cast<char8_t>(0x30 + linear % 10);
+			dst[0] = static_cast<char8_t>(0x81 + linear / 10);
+			return dst + 4;
+		}
+	};
+
+	using gb18030 = gb18030_codec<false>;
+	using gbk = gb18030_codec<true>;
+
+	// A double-byte character set as its generated `Table` describes it. single[b - 0x80] is the
+	// code point of the byte b, or 0 if b is not a character by itself. A lead byte b starts a
+	// row rows[lead_rows[b - 0x80] - 1] of the code points of its trail bytes trail_first to
+	// trail_last, 0 where a pair has none; lead_rows is 0 for the bytes that are not lead bytes.
+	// With a prefix, prefix_rows likewise gives the rows of the lead bytes after it. In the other
+	// direction blocks[pages[cp >> 8]][cp & 0xFF] is the code of cp: a byte below 0x100, a
+	// prefixed code with the high bits of its lead and trail bytes cleared below 0x8000, a lead
+	// and trail byte otherwise, and 0 if cp has none.
+	template <typename Table>
+	struct dbcs_codec
+	{
+		using char_type = char8_t;
+
+		static transcode_status decode(const char8_t *&src, const char8_t *last, char32_t &cp) noexcept
+		{
+			const std::uint32_t c0 = src[0];
+			if (c0 < 0x80)
+			{
+				cp = c0;
+				src += 1;
+				return transcode_status::ok;
+			}
+			if (Table::single[c0 - 0x80] != 0)
+			{
+				cp = Table::single[c0 - 0x80];
+				src += 1;
+				return transcode_status::ok;
+			}
+
+			const auto prefixed = Table::prefix != 0 && c0 == Table::prefix;
+			std::size_t row = 0;
+			if (prefixed)
+			{
+				if (last - src < 2)
+				{
+					return transcode_status::incomplete;
+				}
+				row = src[1] < 0x80 ? 0 : Table::prefix_rows[src[1] - 0x80];
+			}
+			else
+			{
+				row = Table::lead_rows[c0 - 0x80];
+			}
+			if (row == 0)
+			{
+				return transcode_status::invalid;
+			}
+			const std::size_t size = prefixed ? 3 : 2;
+			if (static_cast<std::size_t>(last - src) < size)
+			{
+				return transcode_status::incomplete;
+			}
+			const std::uint32_t trail = src[size - 1];
+			if (trail < Table::trail_first || trail > Table::trail_last || Table::rows[row - 1][trail - Table::trail_first] == 0)
+			{
+				return transcode_status::invalid;
+			}
+			cp = Table::rows[row - 1][trail - Table::trail_first];
+			src += size;
+			return transcode_status::ok;
+		}
+
+		// A lead and trail byte without a character are skipped together unless the trail byte
+		// is ASCII, as is a truncated code at the end; otherwise only the first byte is.
+		static std::size_t invalid_length(const char8_t *src, const char8_t *last) noexcept
+		{
+			const auto avail = static_cast<std::size_t>(last - src);
+			const auto prefixed = Table::prefix != 0 && src[0] == Table::prefix;
+			const std::size_t size = prefixed ? 3 : 2;
+			std::size_t n = 1;
+			if (prefixed ? avail >= 2 && src[1] >= 0x80 && Table::prefix_rows[src[1] - 0x80] != 0 : src[0] >= 0x80 && Table::lead_rows[src[0] - 0x80] != 0)
+			{
+				n = std::min(avail, size);
+				if (n == size && (src[n - 1] < 0x80 || src[n - 1] < Table::trail_first || src[n - 1] > Table::trail_last))
+				{
+					return 1;
+				}
+			}
+			return n == size || n == avail ? n : 1;
+		}
+
+		static std::uint16_t code(char32_t cp) noexcept
+		{
+			return cp < 0x10000 ? Table::blocks[Table::pages[cp >> 8]][cp & 0xFF] : 0;
+		}
+
+		static std::size_t length(char32_t cp) noexcept
+		{
+			if (cp < 0x80)
+			{
+				return 1;
+			}
+			const auto value = code(cp);
+			return value == 0 ? 0 : value < 0x100 ? 1 : value < 0x8000 ? 3 : 2;
+		}
+
+		static char8_t *encode(char32_t cp, char8_t *dst) noexcept
+		{
+			if (cp < 0x80)
+			{
+				*dst++ = static_cast<char8_t>(cp);
+				return dst;
+			}
+			const std::uint32_t value = code(cp);
+			if (value < 0x100)
+			{
+				*dst++ = static_cast<char8_t>(value);
+				return dst;
+			}
+			if (value < 0x8000)
+			{
+				*dst++ = Table::prefix;
+				*dst++ = static_cast<char8_t>((value >> 8) | 0x80);
+				*dst++ = static_cast<char8_t>(value | 0x80);
+				return dst;
+			}
+			*dst++ = static_cast<char8_t>(value >> 8);
+			*dst++ = static_cast<char8_t>(value);
+			return dst;
+		}
+	};
+
+	using shift_jis = dbcs_codec<shift_jis_table>;
+	using euc_jp = dbcs_codec<euc_jp_table>;
+	using big5 = dbcs_codec<big5_table>;
+	using euc_kr = dbcs_codec<euc_kr_table>;
+
+	// Whether a codec is a table codec, which the kernel table does not hold.
+	template <typename Codec>
+	inline constexpr bool is_table_codec = false;
+
+	template <bool Gbk>
+	inline constexpr bool is_table_codec<gb18030_codec<Gbk>> = true;
+
+	template <typename Table>
+	inline constexpr bool is_table_codec<dbcs_codec<Table>> = true;
+
+	// The UTF codec that reads and writes the ASCII runs of a codec.
+	template <typename Codec>
+	using ascii_codec_t = std::conditional_t<is_table_codec<Codec>, utf8, Codec>;
+
+	// What replaces invalid input in `To`: the substitute, or '?' if `To` cannot encode it.
+	template <typename To>
+	char32_t substitute_for(const recovery &errors) noexcept
+	{
+		return To::length(errors.substitute) != 0 ? errors.substitute : U'?';
+	}
+
+	// convert() for pairs with a table codec on either side. Runs of ASCII are copied by the UTF
+	// kernels and only the text between them is looked up a character at a time. A code point
+	// that `To` cannot encode is invalid input.
+	template <typename From, typename To>
+	transcode_result table_convert(const typename From::char_type *first, const typename From::char_type *last, typename To::char_type *dest, typename To::char_type *dest_last, const recovery *errors = nullptr) noexcept
+	{
+		using ascii_from = ascii_codec_t<From>;
+		using ascii_to = ascii_codec_t<To>;
+
+		auto src = first;
+		auto dst = dest;
+		while (src != last)
+		{
+			const auto ascii_last = ascii_prefix<ascii_from>(src, last);
+			const auto count = std::min(static_cast<std::size_t>(ascii_last - src), static_cast<std::size_t>(dest_last - dst));
+			dst = copy_ascii<ascii_from, ascii_to>(src, src + count, dst);
+			src += count;
+			if (src != ascii_last)
+			{
+				return { transcode_status::output_full, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+			}
+			for (const auto segment_last = find_ascii_block<ascii_from>(src, last); src < segment_last;)
+			{
+				auto next = src;
+				char32_t cp;
+				const auto status = From::decode(next, last, cp);
+				auto size = status == transcode_status::ok ? To::length(cp) : 0;
+				if (size == 0)
+				{
+					if (errors == nullptr)
+					{
+						return { status == transcode_status::ok ? transcode_status::invalid : status, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+					}
+					if (status != transcode_status::ok)
+					{
+						next = src + From::invalid_length(src, last);
+					}
+					if (errors->skip)
+					{
+						src = next;
+						continue;
+					}
+					cp = substitute_for<To>(*errors);
+					size = To::length(cp);
+				}
+				if (static_cast<std::size_t>(dest_last - dst) < size)
+				{
+					return { transcode_status::output_full, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+				}
+				dst = To::encode(cp, dst);
+				src = next;
+			}
+		}
+		return { transcode_status::ok, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+	}
+
+	// Number of units table_convert() writes with `errors`; without, the length of the text
+	// before the first invalid input.
+	template <typename From, typename To>
+	std::size_t table_length(const typename From::char_type *first, const typename From::char_type *last, const recovery *errors) noexcept
+	{
+		using ascii_from = ascii_codec_t<From>;
+
+		std::size_t count = 0;
+		for (auto src = first; src != last;)
+		{
+			const auto ascii_last = ascii_prefix<ascii_from>(src, last);
+			count += static_cast<std::size_t>(ascii_last - src);
+			src = ascii_last;
+			for (const auto segment_last = find_ascii_block<ascii_from>(src, last); src < segment_last;)
+			{
+				auto next = src;
+				char32_t cp;
+				const auto status = From::decode(next, last, cp);
+				auto size = status == transcode_status::ok ? To::length(cp) : 0;
+				if (size == 0)
+				{
+					if (errors == nullptr)
+					{
+						return count;
+					}
+					if (status != transcode_status::ok)
+					{
+						next = src + From::invalid_length(src, last);
+					}
+					size = errors->skip ? 0 : To::length(substitute_for<To>(*errors));
+				}
+				count += size;
+				src = next;
+			}
+		}
+		return count;
+	}
+
+	template <typename Codec>
+	std::size_t table_validate(const typename Codec::char_type *first, const typename Codec::char_type *last) noexcept
+	{
+		for (auto src = first; src != last;)
+		{
+			src = ascii_prefix<utf8>(src, last);
+			for (const auto segment_last = find_ascii_block<utf8>(src, last); src < segment_last;)
+			{
+				char32_t cp;
+				if (Codec::decode(src, last, cp) != transcode_status::ok)
+				{
+					return static_cast<std::size_t>(src - first);
+				}
+			}
+		}
+		return static_cast<std::size_t>(last - first);
+	}
+}
+
+#endif // __SIMPLE_CODECVT_TABLE_CODECS_H__
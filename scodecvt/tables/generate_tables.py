@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+"""Generates the code page tables of scodecvt from the mapping files in this directory.
+
+Run it from anywhere after changing a mapping file:
+
+    python3 scodecvt/tables/generate_tables.py
+
+It rewrites scodecvt/gb18030_tables.cpp, scodecvt/dbcs_tables.h, scodecvt/dbcs_tables.cpp and
+scodecvt/single_byte_tables.cpp. The output depends only on the mapping files, so running it
+again without changes leaves those files as they are.
+
+A mapping file has one code per line: the code as hex bytes, a tab and the Unicode code point
+it decodes to. A third column of |3 marks a code that only decodes, because its code point
+encodes to another code. Lines starting with # are comments, and bytes 0x00-0x7F are ASCII
+and not listed. GB18030-ranges.txt lists runs of four-byte codes instead, with the first code,
+its code point and the length of the run.
+"""
+
+import os
+import random
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.dirname(HERE)
+
+
+def read_mapping(name):
+    """Returns the (code, code point, round trip) entries of a mapping file, code as hex."""
+    entries = []
+    with open(os.path.join(HERE, name), encoding='utf-8') as f:
+        for line in f:
+            if line.startswith('#') or not line.strip():
+                continue
+            fields = line.split()
+            assert fields[0].startswith('0x') and len(fields) in (2, 3), line
+            assert len(fields) == 2 or fields[2] == '|3', line
+            entries.append((fields[0][2:].upper(), int(fields[1], 16), len(fields) == 2))
+    return entries
+
+
+def rows(values, fmt, per, indent):
+    return '\n'.join(indent + ', '.join(fmt(x) for x in values[i:i + per]) + ',' for i in range(0, len(values), per))
+
+
+def hex4(x):
+    return '0x%04X' % x
+
+
+def write(name, header, lines):
+    with open(os.path.join(SOURCE, name), 'w', encoding='utf-8-sig', newline='\n') as f:
+        f.write('\n'.join(header + lines) + '\n')
+
+
+def note(*lines):
+    return ['// ' + line for line in lines] + ['// Do not edit by hand: change the mapping files and run python3 scodecvt/tables/generate_tables.py.']
+
+
+# GB18030
+
+# GB18030-2022 keeps these six two-byte codes in the Private Use Area; glibc decodes them to
+# their CJK Extension B code points, which already have four-byte codes.
+GB18030_2022_TWO_BYTE = {0xFE51: 0xE816, 0xFE52: 0xE817, 0xFE53: 0xE818, 0xFE6C: 0xE831, 0xFE76: 0xE83B, 0xFE91: 0xE855}
+
+# GB18030-2005 decoded these two-byte codes to the Private Use Area. GB18030-2022 moved their
+# characters to them from four-byte codes, which glibc leaves unassigned, and those four-byte
+# codes take the Private Use code points instead.
+GB18030_2005_PUA = {0xA6D9: 0xE78D, 0xA6DA: 0xE78E, 0xA6DB: 0xE78F, 0xA6DC: 0xE790, 0xA6DD: 0xE791, 0xA6DE: 0xE792,
+                    0xA6DF: 0xE793, 0xA6EC: 0xE794, 0xA6ED: 0xE795, 0xA6F3: 0xE796, 0xFE59: 0xE81E, 0xFE61: 0xE826,
+                    0xFE66: 0xE82B, 0xFE67: 0xE82C, 0xFE6D: 0xE832, 0xFE7E: 0xE843, 0xFE90: 0xE854, 0xFEA0: 0xE864}
+# The four-byte linear indices of the moved characters, and the code points they moved to.
+GB18030_2022_MOVED = [(39076 + i, 0xFE10 + i) for i in range(10)] + [(19057 + i, 0x9FB4 + i) for i in range(8)]
+
+# Four-byte codes below this linear index cover the Basic Multilingual Plane.
+GB18030_BMP_LINEAR = 39420
+
+
+def gb18030_linear(code):
+    b = bytes.fromhex(code)
+    return (((b[0] - 0x81) * 10 + b[1] - 0x30) * 126 + b[2] - 0x81) * 10 + b[3] - 0x30
+
+
+def generate_gb18030():
+    two = {int(code, 16): cp for code, cp, _ in read_mapping('GB18030.txt')}
+    for code, cp in GB18030_2022_TWO_BYTE.items():
+        assert two[code] >= 0x20000
+        two[code] = cp
+    four = {}
+    with open(os.path.join(HERE, 'GB18030-ranges.txt'), encoding='utf-8') as f:
+        for line in f:
+            if line.startswith('#') or not line.strip():
+                continue
+            code, cp, count = line.split()
+            first = gb18030_linear(code[2:])
+            for i in range(int(count)):
+                four[first + i] = int(cp, 16) + i
+    by_cp = {v: c for c, v in two.items()}
+    for linear, cp in GB18030_2022_MOVED:
+        assert linear not in four
+        four[linear] = GB18030_2005_PUA[by_cp[cp]]
+    assert sorted(four) == list(range(GB18030_BMP_LINEAR))
+    # Every code point of the BMP beyond ASCII has exactly one code.
+    assert sorted(list(two.values()) + list(four.values())) == [c for c in range(0x80, 0x10000) if not 0xD800 <= c < 0xE000]
+
+    table = [0] * (126 * 190)
+    for c, v in two.items():
+        lead, trail = c >> 8, c & 0xFF
+        table[(lead - 0x81) * 190 + trail - (0x40 if trail < 0x7F else 0x41)] = v
+    # Code point to code: every page holds a block of two-byte codes, which are all at least
+    # 0x8140, and of four-byte linear indices stored as offsets from the base of the page.
+    # Block 0 holds 0, 1, 2... and serves every page without two-byte codes whose linear
+    # indices run in step with its code points.
+    lin_of = {v: k for k, v in four.items()}
+    code_bases = [0] * 256
+    code_pages = [0] * 256
+    code_blocks = [list(range(256))]
+    for p in range(256):
+        cps = range(p << 8, (p + 1) << 8)
+        lins = [lin_of[c] - (c & 0xFF) for c in cps if c in lin_of]
+        if lins and all(x == lins[0] for x in lins) and not any(c in by_cp for c in cps):
+            code_bases[p] = lins[0]
+            continue
+        if not lins and not any(c in by_cp for c in cps):
+            continue
+        base = min(lin_of[c] for c in cps if c in lin_of) if lins else 0
+        block = [by_cp[c] if c in by_cp else lin_of[c] - base if c in lin_of else 0 for c in cps]
+        assert all(lin_of[c] - base < 0x8140 for c in cps if c in lin_of)
+        code_bases[p] = base
+        code_pages[p] = len(code_blocks)
+        code_blocks.append(block)
+    # Linear index to code point, in pages of 128 indices laid out the same way.
+    lin_bases = []
+    lin_pages = []
+    lin_blocks = [list(range(128))]
+    for p in range(0, GB18030_BMP_LINEAR, 128):
+        cps = [four[i] for i in range(p, min(p + 128, GB18030_BMP_LINEAR))]
+        if all(cps[i] == cps[0] + i for i in range(len(cps))):
+            lin_bases.append(cps[0])
+            lin_pages.append(0)
+            continue
+        base = min(cps)
+        lin_bases.append(base)
+        lin_pages.append(len(lin_blocks))
+        lin_blocks.append([c - base for c in cps] + [0] * (128 - len(cps)))
+
+    o = ['#include "table_codecs.h"', '', 'namespace simple_codecvt::detail', '{',
+         '\tconst char16_t gb18030_two_byte[gb18030_two_byte_count] =', '\t{', rows(table, hex4, 16, '\t\t'), '\t};', '',
+         '\tconst std::uint8_t gb18030_code_pages[256] =', '\t{', rows(code_pages, str, 32, '\t\t'), '\t};', '',
+         '\tconst std::uint16_t gb18030_code_bases[256] =', '\t{', rows(code_bases, str, 16, '\t\t'), '\t};', '',
+         '\tconst std::uint16_t gb18030_code_blocks[gb18030_code_block_count][256] =', '\t{']
+    for b in code_blocks:
+        o += ['\t\t{', rows(b, hex4, 16, '\t\t\t'), '\t\t},']
+    o += ['\t};', '',
+          '\tconst std::uint8_t gb18030_linear_pages[gb18030_linear_page_count] =', '\t{', rows(lin_pages, str, 32, '\t\t'), '\t};', '',
+          '\tconst char16_t gb18030_linear_bases[gb18030_linear_page_count] =', '\t{', rows(lin_bases, hex4, 16, '\t\t'), '\t};', '',
+          '\tconst std::uint16_t gb18030_linear_blocks[gb18030_linear_block_count][128] =', '\t{']
+    for b in lin_blocks:
+        o += ['\t\t{', rows(b, hex4, 16, '\t\t\t'), '\t\t},']
+    o += ['\t};', '}']
+    write('gb18030_tables.cpp', note('Generated by scodecvt/tables/generate_tables.py from GB18030.txt and GB18030-ranges.txt,',
+                                     'which hold the GB18030 converter of glibc 2.36, corrected by the script to GB18030-2022.'), o)
+
+# Double-byte character sets
+
+DBCS = [
+    ('shift_jis', 'CP932.txt', 'Shift_JIS as Windows code page 932.'),
+    ('euc_jp', 'EUC-JP.txt', 'EUC-JP with JIS X 0208 and, after the prefix 0x8F, JIS X 0212.'),
+    ('big5', 'CP950.txt', 'Big5 as Windows code page 950.'),
+    ('euc_kr', 'CP949.txt', 'EUC-KR extended to all of Hangul as Windows code page 949.'),
+]
+
+
+def generate_dbcs():
+    h = []
+    c = []
+    for name, source, doc in DBCS:
+        entries = read_mapping(source)
+        single = {int(code, 16): cp for code, cp, _ in entries if len(code) == 2}
+        two = {int(code, 16): cp for code, cp, _ in entries if len(code) == 4}
+        three = {int(code, 16) & 0xFFFF: cp for code, cp, _ in entries if len(code) == 6}
+        prefix = 0x8F if three else 0
+        assert all(code[:2] == '8F' for code, _, _ in entries if len(code) == 6)
+        assert not prefix or prefix not in single and all(k >> 8 != prefix for k in two)
+        assert all(k >> 8 not in single for k in two)
+        trails = sorted({k & 0xFF for k in list(two) + list(three)})
+        tf, tl = trails[0], trails[-1]
+        leads = sorted({k >> 8 for k in two})
+        pleads = sorted({k >> 8 for k in three})
+        lead_rows = [0] * 128
+        prefix_rows = [0] * 128
+        table = []
+        for lead in leads:
+            table.append([two.get(lead << 8 | t, 0) for t in range(tf, tl + 1)])
+            lead_rows[lead - 0x80] = len(table)
+        for lead in pleads:
+            table.append([three.get(lead << 8 | t, 0) for t in range(tf, tl + 1)])
+            prefix_rows[lead - 0x80] = len(table)
+        assert len(table) < 256 and all(v < 0x10000 for r in table for v in r)
+        # Code point to code, from the codes that decode back.
+        rev = {}
+        for code, cp, round_trip in entries:
+            if round_trip and cp >= 0x80:
+                assert cp not in rev, code
+                rev[cp] = int(code, 16) & 0x7F7F if len(code) == 6 else int(code, 16)
+        assert set(rev) == {cp for _, cp, _ in entries if cp >= 0x80}
+        pages = [0] * 256
+        blocks = [[0] * 256]
+        for p in range(256):
+            block = [rev.get(p << 8 | i, 0) for i in range(256)]
+            if any(block):
+                blocks.append(block)
+                pages[p] = len(blocks) - 1
+        assert len(blocks) < 256
+        t = name + '_table'
+        h += ['\t// ' + doc,
+              '\tstruct ' + t, '\t{',
+              '\t\tstatic constexpr std::uint8_t prefix = 0x%02X;' % prefix,
+              '\t\tstatic constexpr std::uint8_t trail_first = 0x%02X;' % tf,
+              '\t\tstatic constexpr std::uint8_t trail_last = 0x%02X;' % tl,
+              '\t\tstatic constexpr std::size_t row_count = %d;' % len(table),
+              '\t\tstatic constexpr std::size_t block_count = %d;' % len(blocks),
+              '\t\tstatic const char16_t single[128];',
+              '\t\tstatic const std::uint8_t lead_rows[128];',
+              '\t\tstatic const std::uint8_t prefix_rows[128];',
+              '\t\tstatic const char16_t rows[row_count][trail_last - trail_first + 1];',
+              '\t\tstatic const std::uint8_t pages[256];',
+              '\t\tstatic const std::uint16_t blocks[block_count][256];',
+              '\t};', '']
+        c += ['\tconst char16_t %s::single[128] =' % t, '\t{', rows([single.get(i, 0) for i in range(128, 256)], hex4, 16, '\t\t'), '\t};', '',
+              '\tconst std::uint8_t %s::lead_rows[128] =' % t, '\t{', rows(lead_rows, str, 32, '\t\t'), '\t};', '',
+              '\tconst std::uint8_t %s::prefix_rows[128] =' % t, '\t{', rows(prefix_rows, str, 32, '\t\t'), '\t};', '',
+              '\tconst char16_t %s::rows[row_count][trail_last - trail_first + 1] =' % t, '\t{']
+        for r in table:
+            c += ['\t\t{', rows(r, hex4, 16, '\t\t\t'), '\t\t},']
+        c += ['\t};', '', '\tconst std::uint8_t %s::pages[256] =' % t, '\t{', rows(pages, str, 32, '\t\t'), '\t};', '',
+              '\tconst std::uint16_t %s::blocks[block_count][256] =' % t, '\t{']
+        for b in blocks:
+            c += ['\t\t{', rows(b, hex4, 16, '\t\t\t'), '\t\t},']
+        c += ['\t};', '']
+
+    header = note('Generated by scodecvt/tables/generate_tables.py from CP932.txt, EUC-JP.txt, CP950.txt and',
+                  'CP949.txt, which hold the converters of glibc 2.36.')
+    write('dbcs_tables.h', header, ['#ifndef __SIMPLE_CODECVT_DBCS_TABLES_H__', '#define __SIMPLE_CODECVT_DBCS_TABLES_H__', '',
+                                    '#include <cstddef>', '#include <cstdint>', '',
+                                    '// The tables of the double-byte character sets, laid out as dbcs_codec in table_codecs.h reads them.',
+                                    'namespace simple_codecvt::detail', '{'] + h[:-1] + ['}', '', '#endif // __SIMPLE_CODECVT_DBCS_TABLES_H__'])
+    write('dbcs_tables.cpp', header, ['#include "dbcs_tables.h"', '', 'namespace simple_codecvt::detail', '{'] + c[:-1] + ['}'])
+
+
+# Single-byte code pages by mapping file and name in simple_codecvt::encoding, in the order of
+# the encoding values from encoding::latin1.
+SINGLE_BYTE = [('ISO-8859-1', 'latin1')] + [('ISO-8859-%d' % i, 'iso8859_%d' % i) for i in (2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 14, 15, 16)] + \
+              [('CP%d' % i, 'windows_%d' % i) for i in range(1250, 1259)] + [('KOI8-R', 'koi8_r'), ('KOI8-U', 'koi8_u')]
+
+# single_byte_table::encode is a hash table of 1 << SINGLE_BYTE_HASH_BITS slots.
+SINGLE_BYTE_HASH_BITS = 9
+
+
+def perfect_hash(keys, multiplier):
+    """Returns the slots of `keys` under (key * multiplier) >> (32 - bits), or None on a collision."""
+    slots = {}
+    for k in keys:
+        h = ((k * multiplier) & 0xFFFFFFFF) >> (32 - SINGLE_BYTE_HASH_BITS)
+        if h in slots:
+            return None
+        slots[h] = k
+    return slots
+
+
+def generate_single_byte():
+    o = ['\tconst single_byte_table single_byte_tables[single_byte_table_count] =', '\t{']
+    for source, name in SINGLE_BYTE:
+        dec = {int(code, 16): cp for code, cp, _ in read_mapping(source + '.txt')}
+        keys = {v: b for b, v in dec.items()}
+        assert len(keys) == len(dec) and all(b >= 0x80 and 0x80 <= v < 0x10000 for b, v in dec.items())
+        # Multiplicative hashing by the golden ratio first, then by random odd multipliers until
+        # no two code points of the page share a slot. The seed keeps the search reproducible.
+        multiplier = 0x9E3779B1
+        rng = random.Random(name)
+        while True:
+            slots = perfect_hash(keys, multiplier)
+            if slots:
+                break
+            multiplier = rng.getrandbits(32) | 1
+        cps = [b if b < 0x80 else dec.get(b, 0) for b in range(256)]
+        o += ['\t\t// ' + source, '\t\t{', '\t\t\t{', rows(cps, hex4, 16, '\t\t\t\t'), '\t\t\t},', '\t\t\t0x%08X,' % multiplier, '\t\t\t{']
+        entries = [(slots[i], keys[slots[i]]) if i in slots else (0, 0) for i in range(1 << SINGLE_BYTE_HASH_BITS)]
+        for i in range(0, len(entries), 8):
+            o.append('\t\t\t\t' + ' '.join('{ 0x%04X, 0x%02X },' % e for e in entries[i:i + 8]))
+        o += ['\t\t\t},', '\t\t},']
+    o += ['\t};', '}']
+    write('single_byte_tables.cpp', note('Generated by scodecvt/tables/generate_tables.py from the ISO-8859, CP125x and KOI8 mapping',
+                                         'files, which hold the single-byte converters of glibc 2.36.'),
+          ['#include "table_codecs.h"', '', 'namespace simple_codecvt::detail', '{'] + o)
+
+
+def main():
+    generate_gb18030()
+    generate_dbcs()
+    generate_single_byte()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,1982 @@
+﻿#ifndef __SIMPLE_CODECVT_UTF_KERNELS_H__
+#define __SIMPLE_CODECVT_UTF_KERNELS_H__
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// The instruction set follows the compiler's target unless a translation unit pins it by defining
+// SIMPLE_CODECVT_TARGET_SCALAR, _SSE2, _SSSE3 or _AVX2 first. Each instruction set gets its own
+// inline namespace, so the builds of several translation units never clash at link time.
+#if defined SIMPLE_CODECVT_TARGET_AVX2
+#define SIMPLE_CODECVT_SSE2
+#define SIMPLE_CODECVT_SSSE3
+#define SIMPLE_CODECVT_AVX2
+#define SIMPLE_CODECVT_TARGET_ISA "avx2"
+#elif defined SIMPLE_CODECVT_TARGET_SSSE3
+#define SIMPLE_CODECVT_SSE2
+#define SIMPLE_CODECVT_SSSE3
+#define SIMPLE_CODECVT_TARGET_ISA "ssse3"
+#elif defined SIMPLE_CODECVT_TARGET_SSE2
+#define SIMPLE_CODECVT_SSE2
+#define SIMPLE_CODECVT_TARGET_ISA "sse2"
+#elif !defined SIMPLE_CODECVT_TARGET_SCALAR
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define SIMPLE_CODECVT_SSE2
+#endif
+#if defined __SSSE3__ || defined __AVX2__
+#define SIMPLE_CODECVT_SSSE3
+#endif
+#ifdef __AVX2__
+#define SIMPLE_CODECVT_AVX2
+#endif
+#endif
+
+#if defined SIMPLE_CODECVT_AVX2
+#define SIMPLE_CODECVT_TIER tier_avx2
+#elif defined SIMPLE_CODECVT_SSSE3
+#define SIMPLE_CODECVT_TIER tier_ssse3
+#elif defined SIMPLE_CODECVT_SSE2
+#define SIMPLE_CODECVT_TIER tier_sse2
+#else
+#define SIMPLE_CODECVT_TIER tier_scalar
+#endif
+
+// MSVC accepts any intrinsic anywhere; GCC and Clang have to be told the pinned target. The
+// standard headers are included above, so none of their code is built for it.
+#define SIMPLE_CODECVT_PRAGMA(...) _Pragma(#__VA_ARGS__)
+#define SIMPLE_CODECVT_EXPANDED_PRAGMA(...) SIMPLE_CODECVT_PRAGMA(__VA_ARGS__)
+#if defined SIMPLE_CODECVT_TARGET_ISA && defined __clang__
+SIMPLE_CODECVT_EXPANDED_PRAGMA(clang attribute push(__attribute__((target(SIMPLE_CODECVT_TARGET_ISA))), apply_to = function))
+#elif defined SIMPLE_CODECVT_TARGET_ISA && defined __GNUC__
+#pragma GCC push_options
+SIMPLE_CODECVT_EXPANDED_PRAGMA(GCC target(SIMPLE_CODECVT_TARGET_ISA))
+#endif
+
+#ifdef SIMPLE_CODECVT_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef SIMPLE_CODECVT_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#ifdef SIMPLE_CODECVT_AVX2
+#include <immintrin.h>
+#endif
+
+// For loads that may run past the end of a null-terminated string but stay within its aligned block.
+#if defined __SANITIZE_ADDRESS__ || defined __clang__
+#define SIMPLE_CODECVT_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined _MSC_VER
+#define SIMPLE_CODECVT_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#else
+#define SIMPLE_CODECVT_NO_SANITIZE_ADDRESS
+#endif
+
+// Internal transcoding kernels. Every kernel validates and converts in a single pass over
+// [first, last) into [dest, dest_last) and never reads or writes outside those ranges.
+// A `Swap` template argument means the corresponding side is not in host byte order.
+namespace simple_codecvt::detail
+{
+	enum class transcode_status
+	{
+		ok,
+		invalid,
+		incomplete,
+		output_full,
+	};
+
+	// On failure `read` is the offset of the offending sequence and `written` covers
+	// everything converted before it.
+	struct transcode_result
+	{
+		transcode_status status;
+		std::size_t read;
+		std::size_t written;
+	};
+
+	// What convert() does with invalid input instead of stopping there: write `substitute`, a
+	// Unicode scalar value, in place of each invalid sequence, or drop it if `skip` is set.
+	struct recovery
+	{
+		char32_t substitute;
+		bool skip;
+	};
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	constexpr char16_t byteswap(char16_t ch) noexcept
+	{
+#ifdef __GNUC__
+		return __builtin_bswap16(ch);
+#else // __GNUC__
+		return static_cast<char16_t>((ch << 8) | (ch >> 8));
+#endif // __GNUC__
+	}
+
+	constexpr char32_t byteswap(char32_t ch) noexcept
+	{
+#ifdef __GNUC__
+		return __builtin_bswap32(ch);
+#else // __GNUC__
+		return ((ch & 0x000000FF) << 24) | ((ch & 0x0000FF00) << 8) | ((ch & 0x00FF0000) >> 8) | ((ch & 0xFF000000) >> 24);
+#endif // __GNUC__
+	}
+
+	template <bool Swap, typename CharType>
+	constexpr CharType to_host(CharType ch) noexcept
+	{
+		if constexpr (Swap)
+		{
+			return byteswap(ch);
+		}
+		else
+		{
+			return ch;
+		}
+	}
+
+	// Codec traits. decode() reads one code point and advances `src` only on success,
+	// invalid_length() is the number of units to skip where it failed (the maximal subpart of a
+	// sequence, as the Unicode standard recommends), length() is the number of code units
+	// encode() writes for `cp`, starts_sequence() tells whether a code point may begin at `src`.
+	struct utf8
+	{
+		using char_type = char8_t;
+
+		static transcode_status decode(const char8_t *&src, const char8_t *last, char32_t &cp) noexcept
+		{
+			const std::uint32_t c0 = src[0];
+			if (c0 < 0x80)
+			{
+				cp = c0;
+				src += 1;
+				return transcode_status::ok;
+			}
+
+			const auto avail = static_cast<std::size_t>(last - src);
+			if (c0 < 0xC2)
+			{
+				return transcode_status::invalid;
+			}
+			if (c0 < 0xE0)
+			{
+				if (avail < 2)
+				{
+					return transcode_status::incomplete;
+				}
+				const std::uint32_t c1 = src[1];
+				if ((c1 & 0xC0) != 0x80)
+				{
+					return transcode_status::invalid;
+				}
+				cp = ((c0 & 0x1F) << 6) | (c1 & 0x3F);
+				src += 2;
+				return transcode_status::ok;
+			}
+			if (c0 < 0xF0)
+			{
+				const std::uint32_t lower = c0 == 0xE0 ? 0xA0 : 0x80;
+				const std::uint32_t upper = c0 == 0xED ? 0x9F : 0xBF;
+				if (avail < 2)
+				{
+					return transcode_status::incomplete;
+				}
+				const std::uint32_t c1 = src[1];
+				if (c1 < lower || c1 > upper)
+				{
+					return transcode_status::invalid;
+				}
+				if (avail < 3)
+				{
+					return transcode_status::incomplete;
+				}
+				const std::uint32_t c2 = src[2];
+				if ((c2 & 0xC0) != 0x80)
+				{
+					return transcode_status::invalid;
+				}
+				cp = ((c0 & 0x0F) << 12) | ((c1 & 0x3F) << 6) | (c2 & 0x3F);
+				src += 3;
+				return transcode_status::ok;
+			}
+			if (c0 < 0xF5)
+			{
+				const std::uint32_t lower = c0 == 0xF0 ? 0x90 : 0x80;
+				const std::uint32_t upper = c0 == 0xF4 ? 0x8F : 0xBF;
+				if (avail < 2)
+				{
+					return transcode_status::incomplete;
+				}
+				const std::uint32_t c1 = src[1];
+				if (c1 < lower || c1 > upper)
+				{
+					return transcode_status::invalid;
+				}
+				if (avail < 3)
+				{
+					return transcode_status::incomplete;
+				}
+				const std::uint32_t c2 = src[2];
+				if ((c2 & 0xC0) != 0x80)
+				{
+					return transcode_status::invalid;
+				}
+				if (avail < 4)
+				{
+					return transcode_status::incomplete;
+				}
+				const std::uint32_t c3 = src[3];
+				if ((c3 & 0xC0) != 0x80)
+				{
+					return transcode_status::invalid;
+				}
+				cp = ((c0 & 0x07) << 18) | ((c1 & 0x3F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
+				src += 4;
+				return transcode_status::ok;
+			}
+			return transcode_status::invalid;
+		}
+
+		static std::size_t invalid_length(const char8_t *src, const char8_t *last) noexcept
+		{
+			const std::uint32_t c0 = src[0];
+			std::size_t trail = 0;
+			std::uint32_t lower = 0x80;
+			std::uint32_t upper = 0xBF;
+			if (c0 >= 0xC2 && c0 < 0xE0)
+			{
+				trail = 1;
+			}
+			else if (c0 >= 0xE0 && c0 < 0xF0)
+			{
+				trail = 2;
+				lower = c0 == 0xE0 ? 0xA0 : 0x80;
+				upper = c0 == 0xED ? 0x9F : 0xBF;
+			}
+			else if (c0 >= 0xF0 && c0 < 0xF5)
+			{
+				trail = 3;
+				lower = c0 == 0xF0 ? 0x90 : 0x80;
+				upper = c0 == 0xF4 ? 0x8F : 0xBF;
+			}
+			std::size_t n = 1;
+			for (; n <= trail && src + n != last && src[n] >= lower && src[n] <= upper; ++n)
+			{
+				lower = 0x80;
+				upper = 0xBF;
+			}
+			return n;
+		}
+
+		static constexpr bool starts_sequence(const char8_t *src) noexcept
+		{
+			return (*src & 0xC0) != 0x80;
+		}
+
+		static constexpr std::size_t length(char32_t cp) noexcept
+		{
+			return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+		}
+
+		static char8_t *encode(char32_t cp, char8_t *dst) noexcept
+		{
+			if (cp < 0x80)
+			{
+				*dst++ = static_cast<char8_t>(cp);
+			}
+			else if (cp < 0x800)
+			{
+				*dst++ = static_cast<char8_t>(0xC0 | (cp >> 6));
+				*dst++ = static_cast<char8_t>(0x80 | (cp & 0x3F));
+			}
+			else if (cp < 0x10000)
+			{
+				*dst++ = static_cast<char8_t>(0xE0 | (cp >> 12));
+				*dst++ = static_cast<char8_t>(0x80 | ((cp >> 6) & 0x3F));
+				*dst++ = static_cast<char8_t>(0x80 | (cp & 0x3F));
+			}
+			else
+			{
+				*dst++ = static_cast<char8_t>(0xF0 | (cp >> 18));
+				*dst++ = static_cast<char8_t>(0x80 | ((cp >> 12) & 0x3F));
+				*dst++ = static_cast<char8_t>(0x80 | ((cp >> 6) & 0x3F));
+				*dst++ = static_cast<char8_t>(0x80 | (cp & 0x3F));
+			}
+			return dst;
+		}
+	};
+
+	template <bool Swap>
+	struct utf16
+	{
+		using char_type = char16_t;
+
+		static transcode_status decode(const char16_t *&src, const char16_t *last, char32_t &cp) noexcept
+		{
+			const char32_t c0 = to_host<Swap>(src[0]);
+			if ((c0 & 0xF800) != 0xD800)
+			{
+				cp = c0;
+				src += 1;
+				return transcode_status::ok;
+			}
+			if (c0 >= 0xDC00)
+			{
+				return transcode_status::invalid;
+			}
+			if (last - src < 2)
+			{
+				return transcode_status::incomplete;
+			}
+			const char32_t c1 = to_host<Swap>(src[1]);
+			if ((c1 & 0xFC00) != 0xDC00)
+			{
+				return transcode_status::invalid;
+			}
+			cp = (c0 << 10) + c1 - 0x35FDC00;
+			src += 2;
+			return transcode_status::ok;
+		}
+
+		static constexpr std::size_t invalid_length(const char16_t *, const char16_t *) noexcept
+		{
+			return 1;
+		}
+
+		static constexpr bool starts_sequence(const char16_t *src) noexcept
+		{
+			return (to_host<Swap>(*src) & 0xFC00) != 0xDC00;
+		}
+
+		static constexpr std::size_t length(char32_t cp) noexcept
+		{
+			return cp < 0x10000 ? 1 : 2;
+		}
+
+		static char16_t *encode(char32_t cp, char16_t *dst) noexcept
+		{
+			if (cp < 0x10000)
+			{
+				*dst++ = to_host<Swap>(static_cast<char16_t>(cp));
+			}
+			else
+			{
+				*dst++ = to_host<Swap>(static_cast<char16_t>((cp >> 10) + 0xD7C0));
+				*dst++ = to_host<Swap>(static_cast<char16_t>((cp & 0x3FF) + 0xDC00));
+			}
+			return dst;
+		}
+	};
+
+	template <bool Swap>
+	struct utf32
+	{
+		using char_type = char32_t;
+
+		static transcode_status decode(const char32_t *&src, const char32_t *, char32_t &cp) noexcept
+		{
+			const char32_t c = to_host<Swap>(src[0]);
+			if (c > 0x10FFFF || (c & 0xFFFFF800) == 0xD800)
+			{
+				return transcode_status::invalid;
+			}
+			cp = c;
+			src += 1;
+			return transcode_status::ok;
+		}
+
+		static constexpr std::size_t invalid_length(const char32_t *, const char32_t *) noexcept
+		{
+			return 1;
+		}
+
+		static constexpr bool starts_sequence(const char32_t *) noexcept
+		{
+			return true;
+		}
+
+		static constexpr std::size_t length(char32_t) noexcept
+		{
+			return 1;
+		}
+
+		static char32_t *encode(char32_t cp, char32_t *dst) noexcept
+		{
+			*dst++ = to_host<Swap>(cp);
+			return dst;
+		}
+	};
+
+	// The same codec with the opposite byte order.
+	template <typename Codec>
+	struct swapped
+	{
+		using type = Codec;
+	};
+
+	template <bool Swap>
+	struct swapped<utf16<Swap>>
+	{
+		using type = utf16<!Swap>;
+	};
+
+	template <bool Swap>
+	struct swapped<utf32<Swap>>
+	{
+		using type = utf32<!Swap>;
+	};
+
+	template <typename Codec>
+	using swapped_t = typename swapped<Codec>::type;
+
+	// The codec for a fixed byte order, resolved against the host's at compile time.
+	inline constexpr bool native_big_endian = std::endian::native == std::endian::big;
+
+	template <bool BigEndian>
+	using utf16_order = utf16<BigEndian != native_big_endian>;
+
+	template <bool BigEndian>
+	using utf32_order = utf32<BigEndian != native_big_endian>;
+
+	// Vector kernels for a (From, To) pair. convert() either converts one whole block,
+	// advancing `src` and `dst`, or touches nothing and returns false. After a miss the
+	// driver decodes the next `window` input units in scalar code before trying again.
+	template <typename From, typename To>
+	struct block_converter
+	{
+		static constexpr std::size_t window = 0;
+
+		static bool convert(const typename From::char_type *&, const typename From::char_type *, typename To::char_type *&, typename To::char_type *) noexcept
+		{
+			return false;
+		}
+	};
+
+	template <typename From, typename To>
+	transcode_result convert(const typename From::char_type *first, const typename From::char_type *last, typename To::char_type *dest, typename To::char_type *dest_last, const recovery *errors = nullptr) noexcept
+	{
+		using blocks = block_converter<From, To>;
+
+		auto src = first;
+		auto dst = dest;
+		for (auto scalar_last = src; src != last;)
+		{
+			if constexpr (blocks::window != 0)
+			{
+				if (src >= scalar_last)
+				{
+					if (blocks::convert(src, last, dst, dest_last))
+					{
+						continue;
+					}
+					scalar_last = static_cast<std::size_t>(last - src) > blocks::window ? src + blocks::window : last;
+				}
+			}
+			auto next = src;
+			char32_t cp;
+			const auto status = From::decode(next, last, cp);
+			if (status != transcode_status::ok)
+			{
+				if (errors == nullptr)
+				{
+					return { status, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+				}
+				next = src + From::invalid_length(src, last);
+				if (errors->skip)
+				{
+					src = next;
+					continue;
+				}
+				cp = errors->substitute;
+			}
+			if (static_cast<std::size_t>(dest_last - dst) < To::length(cp))
+			{
+				return { transcode_status::output_full, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+			}
+			dst = To::encode(cp, dst);
+			src = next;
+		}
+		return { transcode_status::ok, static_cast<std::size_t>(src - first), static_cast<std::size_t>(dst - dest) };
+	}
+
+	// Output length counters. length() returns exactly the number of units convert<From, To>()
+	// writes for valid input; for invalid input it is only an estimate, convert() still reports
+	// the error and stays inside the destination range.
+	template <typename From, typename To>
+	struct length_counter
+	{
+		static std::size_t count(const typename From::char_type *first, const typename From::char_type *last) noexcept
+		{
+			static_assert(std::is_same_v<typename From::char_type, typename To::char_type>, "No length counter for this pair.");
+			return static_cast<std::size_t>(last - first);
+		}
+	};
+
+	template <typename From, typename To>
+	std::size_t length(const typename From::char_type *first, const typename From::char_type *last) noexcept
+	{
+		return length_counter<From, To>::count(first, last);
+	}
+}
+
+
+// x86 is little endian, so a swapped UTF-16 or UTF-32 side is big endian here.
+#ifdef SIMPLE_CODECVT_SSE2
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER::simd
+{
+	inline __m128i byteswap16(__m128i v) noexcept
+	{
+		return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	}
+
+	inline __m128i byteswap32(__m128i v) noexcept
+	{
+		const __m128i halves = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+		return byteswap16(halves);
+	}
+
+	template <bool Swap>
+	inline __m128i load16(const char16_t *src) noexcept
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		if constexpr (Swap)
+		{
+			return byteswap16(v);
+		}
+		else
+		{
+			return v;
+		}
+	}
+
+	template <bool Swap>
+	inline __m128i load32(const char32_t *src) noexcept
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		if constexpr (Swap)
+		{
+			return byteswap32(v);
+		}
+		else
+		{
+			return v;
+		}
+	}
+
+	template <bool Swap>
+	inline void store16(char16_t *dst, __m128i v) noexcept
+	{
+		if constexpr (Swap)
+		{
+			v = byteswap16(v);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+	}
+
+	// Stores eight 16-bit lanes as eight UTF-32 units.
+	template <bool Swap>
+	inline void store16_as32(char32_t *dst, __m128i v) noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+		if constexpr (Swap)
+		{
+			v = byteswap16(v);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(zero, v));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4), _mm_unpackhi_epi16(zero, v));
+		}
+		else
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(v, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4), _mm_unpackhi_epi16(v, zero));
+		}
+	}
+
+	// Packs eight UTF-32 lanes known to be below 0x10000 into 16-bit lanes.
+	inline __m128i pack32to16(__m128i a, __m128i b) noexcept
+	{
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		return _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+	}
+
+	inline bool all_zero16(__m128i v, std::uint16_t mask) noexcept
+	{
+		const __m128i masked = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(mask)));
+		return _mm_movemask_epi8(_mm_cmpeq_epi16(masked, _mm_setzero_si128())) == 0xFFFF;
+	}
+
+	inline bool all_zero32(__m128i v, std::uint32_t mask) noexcept
+	{
+		const __m128i masked = _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(mask)));
+		return _mm_movemask_epi8(_mm_cmpeq_epi32(masked, _mm_setzero_si128())) == 0xFFFF;
+	}
+
+	inline bool any_surrogate16(__m128i v) noexcept
+	{
+		const __m128i top = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800)));
+		return _mm_movemask_epi8(_mm_cmpeq_epi16(top, _mm_set1_epi16(static_cast<short>(0xD800)))) != 0;
+	}
+
+	// 16 bytes of ASCII, returned as 16-bit lanes.
+	inline bool load_ascii(const char8_t *src, __m128i &lo, __m128i &hi) noexcept
+	{
+		const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		if (_mm_movemask_epi8(in) != 0)
+		{
+			return false;
+		}
+		lo = _mm_unpacklo_epi8(in, _mm_setzero_si128());
+		hi = _mm_unpackhi_epi8(in, _mm_setzero_si128());
+		return true;
+	}
+
+	// 8 two-byte sequences (16 bytes), returned as eight 16-bit code points.
+	inline bool decode_2byte(const char8_t *src, __m128i &code) noexcept
+	{
+		const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		const __m128i pattern = _mm_and_si128(in, _mm_set1_epi16(static_cast<short>(0xC0E0)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(pattern, _mm_set1_epi16(static_cast<short>(0x80C0)))) != 0xFFFF)
+		{
+			return false;
+		}
+		// C0 and C1 lead bytes would be overlong.
+		const __m128i lead = _mm_and_si128(in, _mm_set1_epi16(0x001E));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(lead, _mm_setzero_si128())) != 0)
+		{
+			return false;
+		}
+		const __m128i high = _mm_slli_epi16(_mm_and_si128(in, _mm_set1_epi16(0x001F)), 6);
+		const __m128i low = _mm_and_si128(_mm_srli_epi16(in, 8), _mm_set1_epi16(0x003F));
+		code = _mm_or_si128(high, low);
+		return true;
+	}
+
+	// 16 code points below 0x80 -> 16 bytes.
+	inline bool encode_ascii(__m128i a, __m128i b, char8_t *dst) noexcept
+	{
+		if (!all_zero16(_mm_or_si128(a, b), 0xFF80))
+		{
+			return false;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(a, b));
+		return true;
+	}
+
+	// 8 code points in [0x80, 0x800) -> 16 bytes.
+	inline bool encode_2byte(__m128i v, char8_t *dst) noexcept
+	{
+		if (!all_zero16(v, 0xF800))
+		{
+			return false;
+		}
+		const __m128i masked = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(masked, _mm_setzero_si128())) != 0)
+		{
+			return false;
+		}
+		const __m128i lead = _mm_or_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(0x00C0));
+		const __m128i trail = _mm_slli_epi16(_mm_or_si128(_mm_and_si128(v, _mm_set1_epi16(0x003F)), _mm_set1_epi16(0x0080)), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_or_si128(lead, trail));
+		return true;
+	}
+
+#ifdef SIMPLE_CODECVT_SSSE3
+	// 4 three-byte sequences (12 bytes, 16 readable), returned as four 32-bit code points.
+	inline bool decode_3byte(const char8_t *src, __m128i &code) noexcept
+	{
+		const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		const __m128i lanes = _mm_shuffle_epi8(in, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+		const __m128i pattern = _mm_and_si128(lanes, _mm_set1_epi32(0x00C0C0F0));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(pattern, _mm_set1_epi32(0x008080E0))) != 0xFFFF)
+		{
+			return false;
+		}
+		const __m128i c0 = _mm_slli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x0F)), 12);
+		const __m128i c1 = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(lanes, 8), _mm_set1_epi32(0x3F)), 6);
+		const __m128i c2 = _mm_and_si128(_mm_srli_epi32(lanes, 16), _mm_set1_epi32(0x3F));
+		const __m128i value = _mm_or_si128(_mm_or_si128(c0, c1), c2);
+		const __m128i overlong = _mm_cmplt_epi32(value, _mm_set1_epi32(0x800));
+		const __m128i surrogate = _mm_cmpeq_epi32(_mm_and_si128(value, _mm_set1_epi32(0xF800)), _mm_set1_epi32(0xD800));
+		if (_mm_movemask_epi8(_mm_or_si128(overlong, surrogate)) != 0)
+		{
+			return false;
+		}
+		code = value;
+		return true;
+	}
+
+	// 8 non-surrogate code points in [0x800, 0x10000) -> 24 bytes (28 writable).
+	inline bool encode_3byte(__m128i v, char8_t *dst) noexcept
+	{
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800))), _mm_setzero_si128())) != 0 || any_surrogate16(v))
+		{
+			return false;
+		}
+		const __m128i b0 = _mm_or_si128(_mm_srli_epi16(v, 12), _mm_set1_epi16(0x00E0));
+		const __m128i b1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(0x003F)), _mm_set1_epi16(0x0080));
+		const __m128i b2 = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi16(0x003F)), _mm_set1_epi16(0x0080));
+		const __m128i b01 = _mm_or_si128(b0, _mm_slli_epi16(b1, 8));
+		const __m128i compact = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(_mm_unpacklo_epi16(b01, b2), compact));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 12), _mm_shuffle_epi8(_mm_unpackhi_epi16(b01, b2), compact));
+		return true;
+	}
+#endif // SIMPLE_CODECVT_SSSE3
+
+#ifdef SIMPLE_CODECVT_AVX2
+	// 32 bytes of ASCII -> 32 UTF-16 units.
+	template <bool Swap>
+	inline bool ascii_to_utf16_avx2(const char8_t *src, char16_t *dst) noexcept
+	{
+		const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		if (_mm256_movemask_epi8(in) != 0)
+		{
+			return false;
+		}
+		__m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(in));
+		__m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(in, 1));
+		if constexpr (Swap)
+		{
+			lo = _mm256_slli_epi16(lo, 8);
+			hi = _mm256_slli_epi16(hi, 8);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), lo);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 16), hi);
+		return true;
+	}
+
+	// 32 UTF-16 units below 0x80 -> 32 bytes.
+	template <bool Swap>
+	inline bool utf16_to_ascii_avx2(const char16_t *src, char8_t *dst) noexcept
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 16));
+		if constexpr (Swap)
+		{
+			a = _mm256_or_si256(_mm256_slli_epi16(a, 8), _mm256_srli_epi16(a, 8));
+			b = _mm256_or_si256(_mm256_slli_epi16(b, 8), _mm256_srli_epi16(b, 8));
+		}
+		if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_set1_epi16(static_cast<short>(0xFF80))))
+		{
+			return false;
+		}
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), packed);
+		return true;
+	}
+#endif // SIMPLE_CODECVT_AVX2
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	template <bool SwapOutput>
+	struct block_converter<utf8, utf16<SwapOutput>>
+	{
+		static constexpr std::size_t window = 16;
+
+		static bool convert(const char8_t *&src, const char8_t *last, char16_t *&dst, char16_t *dest_last) noexcept
+		{
+#ifdef SIMPLE_CODECVT_AVX2
+			if (last - src >= 32 && dest_last - dst >= 32 && simd::ascii_to_utf16_avx2<SwapOutput>(src, dst))
+			{
+				src += 32;
+				dst += 32;
+				return true;
+			}
+#endif // SIMPLE_CODECVT_AVX2
+			if (last - src < 16 || dest_last - dst < 16)
+			{
+				return false;
+			}
+			__m128i lo, hi;
+			if (simd::load_ascii(src, lo, hi))
+			{
+				simd::store16<SwapOutput>(dst, lo);
+				simd::store16<SwapOutput>(dst + 8, hi);
+				src += 16;
+				dst += 16;
+				return true;
+			}
+			if (simd::decode_2byte(src, lo))
+			{
+				simd::store16<SwapOutput>(dst, lo);
+				src += 16;
+				dst += 8;
+				return true;
+			}
+#ifdef SIMPLE_CODECVT_SSSE3
+			if (simd::decode_3byte(src, lo))
+			{
+				const __m128i packed = simd::pack32to16(lo, lo);
+				if constexpr (SwapOutput)
+				{
+					_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), simd::byteswap16(packed));
+				}
+				else
+				{
+					_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), packed);
+				}
+				src += 12;
+				dst += 4;
+				return true;
+			}
+#endif // SIMPLE_CODECVT_SSSE3
+			return false;
+		}
+	};
+
+	template <bool SwapOutput>
+	struct block_converter<utf8, utf32<SwapOutput>>
+	{
+		static constexpr std::size_t window = 16;
+
+		static bool convert(const char8_t *&src, const char8_t *last, char32_t *&dst, char32_t *dest_last) noexcept
+		{
+			if (last - src < 16 || dest_last - dst < 16)
+			{
+				return false;
+			}
+			__m128i lo, hi;
+			if (simd::load_ascii(src, lo, hi))
+			{
+				simd::store16_as32<SwapOutput>(dst, lo);
+				simd::store16_as32<SwapOutput>(dst + 8, hi);
+				src += 16;
+				dst += 16;
+				return true;
+			}
+			if (simd::decode_2byte(src, lo))
+			{
+				simd::store16_as32<SwapOutput>(dst, lo);
+				src += 16;
+				dst += 8;
+				return true;
+			}
+#ifdef SIMPLE_CODECVT_SSSE3
+			if (simd::decode_3byte(src, lo))
+			{
+				if constexpr (SwapOutput)
+				{
+					lo = simd::byteswap32(lo);
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), lo);
+				src += 12;
+				dst += 4;
+				return true;
+			}
+#endif // SIMPLE_CODECVT_SSSE3
+			return false;
+		}
+	};
+
+	template <bool SwapInput>
+	struct block_converter<utf16<SwapInput>, utf8>
+	{
+		static constexpr std::size_t window = 8;
+
+		static bool convert(const char16_t *&src, const char16_t *last, char8_t *&dst, char8_t *dest_last) noexcept
+		{
+#ifdef SIMPLE_CODECVT_AVX2
+			if (last - src >= 32 && dest_last - dst >= 32 && simd::utf16_to_ascii_avx2<SwapInput>(src, dst))
+			{
+				src += 32;
+				dst += 32;
+				return true;
+			}
+#endif // SIMPLE_CODECVT_AVX2
+			if (last - src >= 16 && dest_last - dst >= 16 && simd::encode_ascii(simd::load16<SwapInput>(src), simd::load16<SwapInput>(src + 8), dst))
+			{
+				src += 16;
+				dst += 16;
+				return true;
+			}
+			if (last - src < 8 || dest_last - dst < 28)
+			{
+				return false;
+			}
+			const __m128i v = simd::load16<SwapInput>(src);
+			if (simd::encode_2byte(v, dst))
+			{
+				src += 8;
+				dst += 16;
+				return true;
+			}
+#ifdef SIMPLE_CODECVT_SSSE3
+			if (simd::encode_3byte(v, dst))
+			{
+				src += 8;
+				dst += 24;
+				return true;
+			}
+#endif // SIMPLE_CODECVT_SSSE3
+			return false;
+		}
+	};
+
+	template <bool SwapInput>
+	struct block_converter<utf32<SwapInput>, utf8>
+	{
+		static constexpr std::size_t window = 8;
+
+		static bool convert(const char32_t *&src, const char32_t *last, char8_t *&dst, char8_t *dest_last) noexcept
+		{
+			if (last - src < 8 || dest_last - dst < 28)
+			{
+				return false;
+			}
+			const __m128i a = simd::load32<SwapInput>(src);
+			const __m128i b = simd::load32<SwapInput>(src + 4);
+			if (!simd::all_zero32(_mm_or_si128(a, b), 0xFFFF0000))
+			{
+				return false;
+			}
+			const __m128i v = simd::pack32to16(a, b);
+			if (simd::all_zero16(v, 0xFF80))
+			{
+				_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(v, v));
+				src += 8;
+				dst += 8;
+				return true;
+			}
+			if (simd::encode_2byte(v, dst))
+			{
+				src += 8;
+				dst += 16;
+				return true;
+			}
+#ifdef SIMPLE_CODECVT_SSSE3
+			if (simd::encode_3byte(v, dst))
+			{
+				src += 8;
+				dst += 24;
+				return true;
+			}
+#endif // SIMPLE_CODECVT_SSSE3
+			return false;
+		}
+	};
+
+	template <bool SwapInput, bool SwapOutput>
+	struct block_converter<utf16<SwapInput>, utf32<SwapOutput>>
+	{
+		static constexpr std::size_t window = 8;
+
+		static bool convert(const char16_t *&src, const char16_t *last, char32_t *&dst, char32_t *dest_last) noexcept
+		{
+			if (last - src < 8 || dest_last - dst < 8)
+			{
+				return false;
+			}
+			const __m128i v = simd::load16<SwapInput>(src);
+			if (simd::any_surrogate16(v))
+			{
+				return false;
+			}
+			simd::store16_as32<SwapOutput>(dst, v);
+			src += 8;
+			dst += 8;
+			return true;
+		}
+	};
+
+	template <bool SwapInput, bool SwapOutput>
+	struct block_converter<utf32<SwapInput>, utf16<SwapOutput>>
+	{
+		static constexpr std::size_t window = 8;
+
+		static bool convert(const char32_t *&src, const char32_t *last, char16_t *&dst, char16_t *dest_last) noexcept
+		{
+			if (last - src < 8 || dest_last - dst < 8)
+			{
+				return false;
+			}
+			const __m128i a = simd::load32<SwapInput>(src);
+			const __m128i b = simd::load32<SwapInput>(src + 4);
+			if (!simd::all_zero32(_mm_or_si128(a, b), 0xFFFF0000))
+			{
+				return false;
+			}
+			const __m128i v = simd::pack32to16(a, b);
+			if (simd::any_surrogate16(v))
+			{
+				return false;
+			}
+			simd::store16<SwapOutput>(dst, v);
+			src += 8;
+			dst += 8;
+			return true;
+		}
+	};
+}
+#endif // SIMPLE_CODECVT_SSE2
+
+#ifdef SIMPLE_CODECVT_SSE2
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER::simd
+{
+	// Horizontal sums of per-lane counters.
+	inline std::size_t sum_u8(__m128i acc) noexcept
+	{
+		const __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+		return static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) + static_cast<std::size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+	}
+
+	inline std::size_t sum_u32(__m128i acc) noexcept
+	{
+		alignas(16) std::uint32_t lanes[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+		return static_cast<std::size_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	inline std::size_t sum_u16(__m128i acc) noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+		return sum_u32(_mm_unpacklo_epi16(acc, zero)) + sum_u32(_mm_unpackhi_epi16(acc, zero));
+	}
+}
+#endif // SIMPLE_CODECVT_SSE2
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	// UTF-8 -> UTF-16/UTF-32: one unit per non-continuation byte, plus one per four-byte lead for UTF-16.
+	template <bool CountFourByteLeads>
+	std::size_t utf8_output_length(const char8_t *first, const char8_t *last) noexcept
+	{
+		std::size_t count = 0;
+		auto src = first;
+#ifdef SIMPLE_CODECVT_SSE2
+		while (last - src >= 16)
+		{
+			// Byte counters overflow after 255 rounds.
+			const auto rounds = std::min<std::size_t>(static_cast<std::size_t>(last - src) / 16, 255);
+			__m128i leads = _mm_setzero_si128();
+			for (std::size_t i = 0; i < rounds; ++i, src += 16)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+				leads = _mm_sub_epi8(leads, _mm_cmpgt_epi8(v, _mm_set1_epi8(-65)));
+				if constexpr (CountFourByteLeads)
+				{
+					leads = _mm_sub_epi8(leads, _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(static_cast<char>(0xF0))), v));
+				}
+			}
+			count += simd::sum_u8(leads);
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		for (; src != last; ++src)
+		{
+			count += (*src & 0xC0) != 0x80;
+			if constexpr (CountFourByteLeads)
+			{
+				count += *src >= 0xF0;
+			}
+		}
+		return count;
+	}
+
+	// UTF-16 -> UTF-8: 1 + (u >= 0x80) + (u >= 0x800) bytes per unit, minus one per surrogate
+	// because a surrogate pair becomes four bytes.
+	template <bool Swap>
+	std::size_t utf16_to_utf8_length(const char16_t *first, const char16_t *last) noexcept
+	{
+		std::size_t count = static_cast<std::size_t>(last - first);
+		auto src = first;
+#ifdef SIMPLE_CODECVT_SSE2
+		while (last - src >= 8)
+		{
+			// Each lane gains at most 2 per round.
+			const auto rounds = std::min<std::size_t>(static_cast<std::size_t>(last - src) / 8, 0x7FFF);
+			__m128i extra = _mm_setzero_si128();
+			for (std::size_t i = 0; i < rounds; ++i, src += 8)
+			{
+				const __m128i v = simd::load16<Swap>(src);
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+				const __m128i two = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800))), zero);
+				const __m128i surrogate = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800))), _mm_set1_epi16(static_cast<short>(0xD800)));
+				// 2 for three-byte units, 1 for two-byte units and surrogates, 0 for ASCII.
+				extra = _mm_add_epi16(extra, _mm_add_epi16(_mm_set1_epi16(2), _mm_add_epi16(_mm_add_epi16(ascii, two), surrogate)));
+			}
+			count += simd::sum_u16(extra);
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		for (; src != last; ++src)
+		{
+			const char16_t u = to_host<Swap>(*src);
+			count += (u >= 0x80) + (u >= 0x800) - ((u & 0xF800) == 0xD800);
+		}
+		return count;
+	}
+
+	// UTF-16 -> UTF-32: one unit per UTF-16 unit that is not a low surrogate.
+	template <bool Swap>
+	std::size_t utf16_to_utf32_length(const char16_t *first, const char16_t *last) noexcept
+	{
+		std::size_t count = static_cast<std::size_t>(last - first);
+		auto src = first;
+#ifdef SIMPLE_CODECVT_SSE2
+		while (last - src >= 8)
+		{
+			const auto rounds = std::min<std::size_t>(static_cast<std::size_t>(last - src) / 8, 0xFFFF);
+			__m128i low = _mm_setzero_si128();
+			for (std::size_t i = 0; i < rounds; ++i, src += 8)
+			{
+				const __m128i v = simd::load16<Swap>(src);
+				const __m128i top = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFC00)));
+				low = _mm_sub_epi16(low, _mm_cmpeq_epi16(top, _mm_set1_epi16(static_cast<short>(0xDC00))));
+			}
+			count -= simd::sum_u16(low);
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		for (; src != last; ++src)
+		{
+			count -= (to_host<Swap>(*src) & 0xFC00) == 0xDC00;
+		}
+		return count;
+	}
+
+	// UTF-32 -> UTF-8/UTF-16: 1 + (c >= 0x80) + (c >= 0x800) + (c >= 0x10000) bytes,
+	// or 1 + (c >= 0x10000) units.
+	template <bool Swap, bool Utf8>
+	std::size_t utf32_output_length(const char32_t *first, const char32_t *last) noexcept
+	{
+		std::size_t count = static_cast<std::size_t>(last - first);
+		auto src = first;
+#ifdef SIMPLE_CODECVT_SSE2
+		while (last - src >= 4)
+		{
+			const auto rounds = std::min<std::size_t>(static_cast<std::size_t>(last - src) / 4, 0x10000000);
+			__m128i extra = _mm_setzero_si128();
+			for (std::size_t i = 0; i < rounds; ++i, src += 4)
+			{
+				const __m128i v = simd::load32<Swap>(src);
+				const __m128i zero = _mm_setzero_si128();
+				extra = _mm_sub_epi32(extra, _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xFFFF0000))), zero), _mm_set1_epi32(-1)));
+				if constexpr (Utf8)
+				{
+					extra = _mm_sub_epi32(extra, _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xFFFFFF80))), zero), _mm_set1_epi32(-1)));
+					extra = _mm_sub_epi32(extra, _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xFFFFF800))), zero), _mm_set1_epi32(-1)));
+				}
+			}
+			count += simd::sum_u32(extra);
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		for (; src != last; ++src)
+		{
+			const char32_t c = to_host<Swap>(*src);
+			count += c >= 0x10000;
+			if constexpr (Utf8)
+			{
+				count += (c >= 0x80) + (c >= 0x800);
+			}
+		}
+		return count;
+	}
+
+	template <bool Swap>
+	struct length_counter<utf8, utf16<Swap>>
+	{
+		static std::size_t count(const char8_t *first, const char8_t *last) noexcept
+		{
+			return utf8_output_length<true>(first, last);
+		}
+	};
+
+	template <bool Swap>
+	struct length_counter<utf8, utf32<Swap>>
+	{
+		static std::size_t count(const char8_t *first, const char8_t *last) noexcept
+		{
+			return utf8_output_length<false>(first, last);
+		}
+	};
+
+	template <bool Swap>
+	struct length_counter<utf16<Swap>, utf8>
+	{
+		static std::size_t count(const char16_t *first, const char16_t *last) noexcept
+		{
+			return utf16_to_utf8_length<Swap>(first, last);
+		}
+	};
+
+	template <bool SwapInput, bool SwapOutput>
+	struct length_counter<utf16<SwapInput>, utf32<SwapOutput>>
+	{
+		static std::size_t count(const char16_t *first, const char16_t *last) noexcept
+		{
+			return utf16_to_utf32_length<SwapInput>(first, last);
+		}
+	};
+
+	template <bool Swap>
+	struct length_counter<utf32<Swap>, utf8>
+	{
+		static std::size_t count(const char32_t *first, const char32_t *last) noexcept
+		{
+			return utf32_output_length<Swap, true>(first, last);
+		}
+	};
+
+	template <bool SwapInput, bool SwapOutput>
+	struct length_counter<utf32<SwapInput>, utf16<SwapOutput>>
+	{
+		static std::size_t count(const char32_t *first, const char32_t *last) noexcept
+		{
+			return utf32_output_length<SwapInput, false>(first, last);
+		}
+	};
+}
+
+#ifdef SIMPLE_CODECVT_SSSE3
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER::simd
+{
+	// UTF-8 validation after Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction
+	// Per Byte". Three nibble lookups classify every pair of adjacent bytes; a non-zero lane
+	// in the result marks an error in that byte or in the sequence the previous block ended in.
+	namespace utf8_check
+	{
+		constexpr std::uint8_t too_short = 1 << 0;
+		constexpr std::uint8_t too_long = 1 << 1;
+		constexpr std::uint8_t overlong_3 = 1 << 2;
+		constexpr std::uint8_t too_large = 1 << 3;
+		constexpr std::uint8_t surrogate = 1 << 4;
+		constexpr std::uint8_t overlong_2 = 1 << 5;
+		constexpr std::uint8_t too_large_1000 = 1 << 6;
+		constexpr std::uint8_t overlong_4 = 1 << 6;
+		constexpr std::uint8_t two_conts = 1 << 7;
+		constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+		// Indexed by the high nibble of the first byte of a pair.
+		alignas(16) constexpr std::uint8_t byte_1_high[16] =
+		{
+			too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+			two_conts, two_conts, two_conts, two_conts,
+			too_short | overlong_2,
+			too_short,
+			too_short | overlong_3 | surrogate,
+			too_short | too_large | too_large_1000 | overlong_4,
+		};
+
+		// Indexed by the low nibble of the first byte.
+		alignas(16) constexpr std::uint8_t byte_1_low[16] =
+		{
+			carry | overlong_3 | overlong_2 | overlong_4,
+			carry | overlong_2,
+			carry,
+			carry,
+			carry | too_large,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000 | surrogate,
+			carry | too_large | too_large_1000,
+			carry | too_large | too_large_1000,
+		};
+
+		// Indexed by the high nibble of the second byte.
+		alignas(16) constexpr std::uint8_t byte_2_high[16] =
+		{
+			too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+			too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+			too_long | overlong_2 | two_conts | overlong_3 | too_large,
+			too_long | overlong_2 | two_conts | surrogate | too_large,
+			too_long | overlong_2 | two_conts | surrogate | too_large,
+			too_short, too_short, too_short, too_short,
+		};
+
+		inline __m128i table(const std::uint8_t (&entries)[16]) noexcept
+		{
+			return _mm_load_si128(reinterpret_cast<const __m128i *>(entries));
+		}
+	}
+
+	inline __m128i utf8_errors(__m128i input, __m128i previous) noexcept
+	{
+		const __m128i nibble = _mm_set1_epi8(0x0F);
+		const __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+		const __m128i special = _mm_and_si128(_mm_and_si128(
+			_mm_shuffle_epi8(utf8_check::table(utf8_check::byte_1_high), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+			_mm_shuffle_epi8(utf8_check::table(utf8_check::byte_1_low), _mm_and_si128(prev1, nibble))),
+			_mm_shuffle_epi8(utf8_check::table(utf8_check::byte_2_high), _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+		// Third and fourth bytes of a sequence must be continuation bytes and nothing else may be one.
+		const __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		const __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		const __m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+		return _mm_xor_si128(must_continue, special);
+	}
+
+	// Non-zero if `input` ends in the middle of a sequence.
+	inline __m128i utf8_incomplete(__m128i input) noexcept
+	{
+		const __m128i max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+		return _mm_subs_epu8(input, max);
+	}
+
+#ifdef SIMPLE_CODECVT_AVX2
+	inline __m256i utf8_errors_avx2(__m256i input, __m256i previous) noexcept
+	{
+		const __m256i nibble = _mm256_set1_epi8(0x0F);
+		const __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+		const __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+		const __m256i special = _mm256_and_si256(_mm256_and_si256(
+			_mm256_shuffle_epi8(_mm256_broadcastsi128_si256(utf8_check::table(utf8_check::byte_1_high)), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+			_mm256_shuffle_epi8(_mm256_broadcastsi128_si256(utf8_check::table(utf8_check::byte_1_low)), _mm256_and_si256(prev1, nibble))),
+			_mm256_shuffle_epi8(_mm256_broadcastsi128_si256(utf8_check::table(utf8_check::byte_2_high)), _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+		const __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 14), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		const __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 13), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		const __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+		return _mm256_xor_si256(must_continue, special);
+	}
+
+	inline __m256i utf8_incomplete_avx2(__m256i input) noexcept
+	{
+		const __m256i max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+		return _mm256_subs_epu8(input, max);
+	}
+#endif // SIMPLE_CODECVT_AVX2
+}
+#endif // SIMPLE_CODECVT_SSSE3
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	// Validators return the offset of the first invalid or incomplete sequence in [first, last),
+	// or last - first if there is none. The vector loops stop at the first block with an error
+	// and leave it to the scalar decoder, which also reports the offset.
+	template <typename Codec>
+	std::size_t validate_scalar(const typename Codec::char_type *first, const typename Codec::char_type *src, const typename Codec::char_type *last) noexcept
+	{
+		char32_t cp;
+		while (src != last)
+		{
+			if (Codec::decode(src, last, cp) != transcode_status::ok)
+			{
+				return static_cast<std::size_t>(src - first);
+			}
+		}
+		return static_cast<std::size_t>(last - first);
+	}
+
+	inline std::size_t validate_utf8(const char8_t *first, const char8_t *last) noexcept
+	{
+		auto src = first;
+#if defined SIMPLE_CODECVT_AVX2
+		__m256i previous = _mm256_setzero_si256();
+		while (last - src >= 32)
+		{
+			const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+			const __m256i errors = _mm256_movemask_epi8(input) == 0 ? simd::utf8_incomplete_avx2(previous) : simd::utf8_errors_avx2(input, previous);
+			if (!_mm256_testz_si256(errors, errors))
+			{
+				break;
+			}
+			previous = input;
+			src += 32;
+		}
+#elif defined SIMPLE_CODECVT_SSSE3
+		__m128i previous = _mm_setzero_si128();
+		while (last - src >= 16)
+		{
+			const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+			const __m128i errors = _mm_movemask_epi8(input) == 0 ? simd::utf8_incomplete(previous) : simd::utf8_errors(input, previous);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) != 0xFFFF)
+			{
+				break;
+			}
+			previous = input;
+			src += 16;
+		}
+#elif defined SIMPLE_CODECVT_SSE2
+		while (last - src >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))) == 0)
+		{
+			src += 16;
+		}
+#endif // SIMPLE_CODECVT_AVX2
+		// Resume at the start of the sequence the last checked byte belongs to.
+		for (int i = 0; i < 3 && src != first && (src[-1] & 0xC0) == 0x80; ++i)
+		{
+			--src;
+		}
+		if (src != first && src[-1] >= 0xC0)
+		{
+			--src;
+		}
+		return validate_scalar<utf8>(first, src, last);
+	}
+
+	template <bool Swap>
+	std::size_t validate_utf16(const char16_t *first, const char16_t *last) noexcept
+	{
+		auto src = first;
+#ifdef SIMPLE_CODECVT_SSE2
+		// Every low surrogate must follow a high one and every high one must precede a low one;
+		// `pending` is set while the unit before `src` is a high surrogate.
+		unsigned int pending = 0;
+#ifdef SIMPLE_CODECVT_AVX2
+		while (last - src >= 16)
+		{
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+			if constexpr (Swap)
+			{
+				v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+			}
+			const __m256i top = _mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xFC00)));
+			const auto high = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(top, _mm256_set1_epi16(static_cast<short>(0xD800)))));
+			const auto low = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(top, _mm256_set1_epi16(static_cast<short>(0xDC00)))));
+			if (low != ((high << 2) | (pending * 3)))
+			{
+				break;
+			}
+			pending = high >> 31;
+			src += 16;
+		}
+#endif // SIMPLE_CODECVT_AVX2
+		while (last - src >= 8)
+		{
+			const __m128i top = _mm_and_si128(simd::load16<Swap>(src), _mm_set1_epi16(static_cast<short>(0xFC00)));
+			const __m128i high = _mm_cmpeq_epi16(top, _mm_set1_epi16(static_cast<short>(0xD800)));
+			const __m128i low = _mm_cmpeq_epi16(top, _mm_set1_epi16(static_cast<short>(0xDC00)));
+			const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(high, low)));
+			const auto highs = mask & 0xFF;
+			if ((mask >> 8) != (((highs << 1) | pending) & 0xFF))
+			{
+				break;
+			}
+			pending = highs >> 7;
+			src += 8;
+		}
+		src -= pending;
+#endif // SIMPLE_CODECVT_SSE2
+		return validate_scalar<utf16<Swap>>(first, src, last);
+	}
+
+	template <bool Swap>
+	std::size_t validate_utf32(const char32_t *first, const char32_t *last) noexcept
+	{
+		auto src = first;
+#ifdef SIMPLE_CODECVT_SSE2
+		// Flipping the sign bit turns the signed comparison into an unsigned one.
+		const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000));
+		const __m128i max = _mm_set1_epi32(static_cast<int>(0x10FFFF ^ 0x80000000));
+#ifdef SIMPLE_CODECVT_AVX2
+		while (last - src >= 8)
+		{
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+			if constexpr (Swap)
+			{
+				const __m256i order = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+					3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+				v = _mm256_shuffle_epi8(v, order);
+			}
+			const __m256i too_large = _mm256_cmpgt_epi32(_mm256_xor_si256(v, _mm256_broadcastsi128_si256(sign)), _mm256_broadcastsi128_si256(max));
+			const __m256i surrogate = _mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32(static_cast<int>(0xFFFFF800))), _mm256_set1_epi32(0xD800));
+			const __m256i errors = _mm256_or_si256(too_large, surrogate);
+			if (!_mm256_testz_si256(errors, errors))
+			{
+				break;
+			}
+			src += 8;
+		}
+#endif // SIMPLE_CODECVT_AVX2
+		while (last - src >= 4)
+		{
+			const __m128i v = simd::load32<Swap>(src);
+			const __m128i too_large = _mm_cmpgt_epi32(_mm_xor_si128(v, sign), max);
+			const __m128i surrogate = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xFFFFF800))), _mm_set1_epi32(0xD800));
+			if (_mm_movemask_epi8(_mm_or_si128(too_large, surrogate)) != 0)
+			{
+				break;
+			}
+			src += 4;
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		return validate_scalar<utf32<Swap>>(first, src, last);
+	}
+
+	template <typename Codec>
+	std::size_t validate(const typename Codec::char_type *first, const typename Codec::char_type *last) noexcept
+	{
+		if constexpr (std::is_same_v<Codec, utf8>)
+		{
+			return validate_utf8(first, last);
+		}
+		else if constexpr (std::is_same_v<Codec, utf16<false>> || std::is_same_v<Codec, utf16<true>>)
+		{
+			return validate_utf16<std::is_same_v<Codec, utf16<true>>>(first, last);
+		}
+		else
+		{
+			return validate_utf32<std::is_same_v<Codec, utf32<true>>>(first, last);
+		}
+	}
+
+	// Exact number of units convert<From, To>() writes with `errors` in effect. The valid
+	// stretches between invalid sequences are found by the validators and measured by the
+	// length counters.
+	template <typename From, typename To>
+	std::size_t length(const typename From::char_type *first, const typename From::char_type *last, const recovery &errors) noexcept
+	{
+		std::size_t count = 0;
+		for (auto src = first;;)
+		{
+			const auto valid_last = src + validate<From>(src, last);
+			count += length<From, To>(src, valid_last);
+			if (valid_last == last)
+			{
+				return count;
+			}
+			if (!errors.skip)
+			{
+				count += To::length(errors.substitute);
+			}
+			src = valid_last + From::invalid_length(valid_last, last);
+		}
+	}
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	// ASCII runs. A unit below 0x80 is the same character in every encoding the library handles,
+	// narrow ones included, so runs of them are copied or widened without a decoder. Narrow text
+	// is described by utf8 here.
+	constexpr std::size_t ascii_block = 16;
+
+	// Bits that are clear in every ASCII unit, in the byte order the codec reads.
+	template <typename Codec>
+	struct ascii_mask;
+
+	template <>
+	struct ascii_mask<utf8>
+	{
+		static constexpr char8_t value = 0x80;
+	};
+
+	template <bool Swap>
+	struct ascii_mask<utf16<Swap>>
+	{
+		static constexpr char16_t value = Swap ? 0x80FF : 0xFF80;
+	};
+
+	template <bool Swap>
+	struct ascii_mask<utf32<Swap>>
+	{
+		static constexpr char32_t value = Swap ? 0x80FFFFFF : 0xFFFFFF80;
+	};
+
+	// Whether the ascii_block units at `src` are all ASCII, i.e. 16, 32 or 64 bytes at a time.
+	template <typename Codec>
+	bool is_ascii_block(const typename Codec::char_type *src) noexcept
+	{
+		using char_type = typename Codec::char_type;
+		constexpr auto mask = ascii_mask<Codec>::value;
+#ifdef SIMPLE_CODECVT_SSE2
+		auto bytes = reinterpret_cast<const __m128i *>(src);
+		__m128i v = _mm_loadu_si128(bytes);
+		for (std::size_t i = 1; i < sizeof(char_type) * ascii_block / 16; ++i)
+		{
+			v = _mm_or_si128(v, _mm_loadu_si128(bytes + i));
+		}
+		if constexpr (sizeof(char_type) == 1)
+		{
+			return _mm_movemask_epi8(v) == 0;
+		}
+		else if constexpr (sizeof(char_type) == 2)
+		{
+			return simd::all_zero16(v, mask);
+		}
+		else
+		{
+			return simd::all_zero32(v, mask);
+		}
+#else // SIMPLE_CODECVT_SSE2
+		char_type bits = 0;
+		for (std::size_t i = 0; i < ascii_block; ++i)
+		{
+			bits |= src[i];
+		}
+		return (bits & mask) == 0;
+#endif // SIMPLE_CODECVT_SSE2
+	}
+
+	// End of the ASCII run [first, result).
+	template <typename Codec>
+	const typename Codec::char_type *ascii_prefix(const typename Codec::char_type *first, const typename Codec::char_type *last) noexcept
+	{
+		auto src = first;
+		while (static_cast<std::size_t>(last - src) >= ascii_block && is_ascii_block<Codec>(src))
+		{
+			src += ascii_block;
+		}
+		while (src != last && (*src & ascii_mask<Codec>::value) == 0)
+		{
+			++src;
+		}
+		return src;
+	}
+
+	// Start of the next all-ASCII block, stepping a block at a time from `first`, or `last`.
+	// Every run of at least 2 * ascii_block - 1 units is found.
+	template <typename Codec>
+	const typename Codec::char_type *find_ascii_block(const typename Codec::char_type *first, const typename Codec::char_type *last) noexcept
+	{
+		for (auto src = first; static_cast<std::size_t>(last - src) >= ascii_block; src += ascii_block)
+		{
+			if (is_ascii_block<Codec>(src))
+			{
+				return src;
+			}
+		}
+		return last;
+	}
+
+	// Writes the ASCII run [first, last) to `dest`, one unit per unit, and returns the end.
+	template <typename From, typename To>
+	typename To::char_type *copy_ascii(const typename From::char_type *first, const typename From::char_type *last, typename To::char_type *dest) noexcept
+	{
+		const auto count = static_cast<std::size_t>(last - first);
+		if constexpr (std::is_same_v<From, To>)
+		{
+			std::memcpy(dest, first, count * sizeof(typename From::char_type));
+			return dest + count;
+		}
+		else
+		{
+			return dest + convert<From, To>(first, last, dest, dest + count).written;
+		}
+	}
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	// Byte order reversal of whole strings, 16 bytes at a time, or 32 with AVX2.
+#ifdef SIMPLE_CODECVT_SSE2
+	template <typename CharType>
+	inline __m128i byteswap_block(__m128i v) noexcept
+	{
+#ifdef SIMPLE_CODECVT_SSSE3
+		if constexpr (sizeof(CharType) == 2)
+		{
+			return _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+		}
+		else
+		{
+			return _mm_shuffle_epi8(v, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+		}
+#else // SIMPLE_CODECVT_SSSE3
+		if constexpr (sizeof(CharType) == 2)
+		{
+			return simd::byteswap16(v);
+		}
+		else
+		{
+			return simd::byteswap32(v);
+		}
+#endif // SIMPLE_CODECVT_SSSE3
+	}
+
+	// Whether the block holds a null unit.
+	template <typename CharType>
+	inline bool has_null(__m128i v) noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+		if constexpr (sizeof(CharType) == 2)
+		{
+			return _mm_movemask_epi8(_mm_cmpeq_epi16(v, zero)) != 0;
+		}
+		else
+		{
+			return _mm_movemask_epi8(_mm_cmpeq_epi32(v, zero)) != 0;
+		}
+	}
+#endif // SIMPLE_CODECVT_SSE2
+
+	// Writes [first, last) with every unit byte-swapped to `dest`, which may be `first` itself.
+	template <typename CharType>
+	void byteswap_copy(const CharType *first, const CharType *last, CharType *dest) noexcept
+	{
+#ifdef SIMPLE_CODECVT_SSE2
+		constexpr std::size_t block = 16 / sizeof(CharType);
+#ifdef SIMPLE_CODECVT_AVX2
+		const __m256i order = sizeof(CharType) == 2
+			? _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+			: _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+		for (; static_cast<std::size_t>(last - first) >= 2 * block; first += 2 * block, dest += 2 * block)
+		{
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), _mm256_shuffle_epi8(v, order));
+		}
+#endif // SIMPLE_CODECVT_AVX2
+		for (; static_cast<std::size_t>(last - first) >= block; first += block, dest += block)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), byteswap_block<CharType>(v));
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		for (; first != last; ++first, ++dest)
+		{
+			*dest = byteswap(*first);
+		}
+	}
+
+	// Byte-swaps the units before the null terminator in place, scanning and swapping in one
+	// pass, and returns how many there were. Blocks are aligned, so a load that reads past the
+	// terminator never leaves the page it is on.
+	template <typename CharType>
+	SIMPLE_CODECVT_NO_SANITIZE_ADDRESS std::size_t byteswap_until_null(CharType *text) noexcept
+	{
+		auto p = text;
+#ifdef SIMPLE_CODECVT_SSE2
+		for (; reinterpret_cast<std::uintptr_t>(p) % 16 != 0; ++p)
+		{
+			if (*p == 0)
+			{
+				return static_cast<std::size_t>(p - text);
+			}
+			*p = byteswap(*p);
+		}
+		for (;; p += 16 / sizeof(CharType))
+		{
+			const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+			if (has_null<CharType>(v))
+			{
+				break;
+			}
+			_mm_store_si128(reinterpret_cast<__m128i *>(p), byteswap_block<CharType>(v));
+		}
+#endif // SIMPLE_CODECVT_SSE2
+		for (; *p != 0; ++p)
+		{
+			*p = byteswap(*p);
+		}
+		return static_cast<std::size_t>(p - text);
+	}
+}
+
+// Single-byte code pages. A table holds the code points of the 256 bytes, 0 for a byte above
+// 0x7F without one, and a perfect hash of the code points above 0x7F to their bytes: the slot of
+// cp is (cp * multiplier) mod 2^32 >> (32 - single_byte_hash_bits), and holds cp if cp has a byte.
+namespace simple_codecvt::detail
+{
+	constexpr unsigned int single_byte_hash_bits = 9;
+
+	struct single_byte_slot
+	{
+		char16_t code_point;
+		std::uint8_t byte;
+	};
+
+	struct single_byte_table
+	{
+		char16_t code_points[256];
+		std::uint32_t multiplier;
+		single_byte_slot slots[std::size_t{ 1 } << single_byte_hash_bits];
+	};
+}
+
+namespace simple_codecvt::detail::inline SIMPLE_CODECVT_TIER
+{
+	// Latin-1 is the first 256 code points, so it decodes by widening each byte.
+	inline void decode_latin1(const char8_t *first, const char8_t *last, char16_t *dest) noexcept
+	{
+		auto src = first;
+		auto dst = dest;
+#if defined SIMPLE_CODECVT_AVX2
+		for (; last - src >= 32; src += 32, dst += 32)
+		{
+			const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(in)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(in, 1)));
+		}
+#elif defined SIMPLE_CODECVT_SSE2
+		for (; last - src >= 16; src += 16, dst += 16)
+		{
+			const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi8(in, _mm_setzero_si128()));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8), _mm_unpackhi_epi8(in, _mm_setzero_si128()));
+		}
+#endif
+		for (; src != last; ++src, ++dst)
+		{
+			*dst = *src;
+		}
+	}
+
+	// Narrows UTF-16 units up to the first one above 0xFF; returns the number of units encoded.
+	inline std::size_t encode_latin1(const char16_t *first, const char16_t *last, char8_t *dest) noexcept
+	{
+		auto src = first;
+		auto dst = dest;
+#if defined SIMPLE_CODECVT_AVX2
+		for (; last - src >= 32; src += 32, dst += 32)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 16));
+			if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_set1_epi16(static_cast<short>(0xFF00))))
+			{
+				break;
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+		}
+#elif defined SIMPLE_CODECVT_SSE2
+		for (; last - src >= 16; src += 16, dst += 16)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 8));
+			if (!simd::all_zero16(_mm_or_si128(a, b), 0xFF00))
+			{
+				break;
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(a, b));
+		}
+#endif
+		for (; src != last && *src < 0x100; ++src, ++dst)
+		{
+			*dst = static_cast<char8_t>(*src);
+		}
+		return static_cast<std::size_t>(src - first);
+	}
+
+	// Decodes bytes up to the first one without a code point; returns the number of bytes decoded.
+	inline std::size_t decode_single_byte(const char8_t *first, const char8_t *last, const single_byte_table &table, char16_t *dest) noexcept
+	{
+		auto src = first;
+		auto dst = dest;
+#if defined SIMPLE_CODECVT_AVX2
+		// Gathers the 32 bits at the code point of each byte; the upper half, the next code point
+		// or after the last one the multiplier, is masked off.
+		const auto code_points = reinterpret_cast<const int *>(table.code_points);
+		for (; last - src >= 16; src += 16, dst += 16)
+		{
+			const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+			const __m256i bytes = _mm256_cvtepu8_epi16(in);
+			if (_mm_movemask_epi8(in) == 0)
+			{
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), bytes);
+				continue;
+			}
+			const __m256i mask = _mm256_set1_epi32(0xFFFF);
+			const __m256i lo = _mm256_and_si256(_mm256_i32gather_epi32(code_points, _mm256_cvtepu8_epi32(in), 2), mask);
+			const __m256i hi = _mm256_and_si256(_mm256_i32gather_epi32(code_points, _mm256_cvtepu8_epi32(_mm_srli_si128(in, 8)), 2), mask);
+			const __m256i units = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+			// Only the byte 0 has the code point 0.
+			const __m256i zero = _mm256_setzero_si256();
+			if (!_mm256_testc_si256(_mm256_cmpeq_epi16(bytes, zero), _mm256_cmpeq_epi16(units, zero)))
+			{
+				break;
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), units);
+		}
+#elif defined SIMPLE_CODECVT_SSSE3
+		// The upper half of the table as eight shuffles of 16 code points, in planes of their low
+		// and high bytes. A byte shuffles with the plane of its row after a saturating add pushes
+		// every other row out of range.
+		__m128i low[8];
+		__m128i high[8];
+		for (int row = 0; row < 8; ++row)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.code_points + 128 + 16 * row));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.code_points + 136 + 16 * row));
+			const __m128i mask = _mm_set1_epi16(0x00FF);
+			low[row] = _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+			high[row] = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+		}
+		for (; last - src >= 16; src += 16, dst += 16)
+		{
+			const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i upper = _mm_cmplt_epi8(in, zero);
+			__m128i lo = _mm_andnot_si128(upper, in);
+			__m128i hi = zero;
+			if (_mm_movemask_epi8(upper) != 0)
+			{
+				__m128i offset = _mm_add_epi8(in, _mm_set1_epi8(static_cast<char>(0x80)));
+				for (int row = 0; row < 8; ++row)
+				{
+					const __m128i index = _mm_adds_epu8(offset, _mm_set1_epi8(0x70));
+					lo = _mm_or_si128(lo, _mm_shuffle_epi8(low[row], index));
+					hi = _mm_or_si128(hi, _mm_shuffle_epi8(high[row], index));
+					offset = _mm_sub_epi8(offset, _mm_set1_epi8(16));
+				}
+				if (_mm_movemask_epi8(_mm_and_si128(upper, _mm_cmpeq_epi8(_mm_or_si128(lo, hi), zero))) != 0)
+				{
+					break;
+				}
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi8(lo, hi));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8), _mm_unpackhi_epi8(lo, hi));
+		}
+#elif defined SIMPLE_CODECVT_SSE2
+		__m128i lo;
+		__m128i hi;
+		for (; last - src >= 16 && simd::load_ascii(src, lo, hi); src += 16, dst += 16)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), lo);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8), hi);
+		}
+#endif
+		for (; src != last; ++src, ++dst)
+		{
+			const auto cp = table.code_points[*src];
+			if (cp == 0 && *src != 0)
+			{
+				break;
+			}
+			*dst = cp;
+		}
+		return static_cast<std::size_t>(src - first);
+	}
+
+	// Encodes UTF-16 units up to the first one without a byte; returns the number of units
+	// encoded.
+	inline std::size_t encode_single_byte(const char16_t *first, const char16_t *last, const single_byte_table &table, char8_t *dest) noexcept
+	{
+		auto src = first;
+		auto dst = dest;
+		while (src != last)
+		{
+			const std::uint32_t c = *src;
+			if (c < 0x80)
+			{
+#ifdef SIMPLE_CODECVT_SSE2
+				if (last - src >= 16 && simd::encode_ascii(simd::load16<false>(src), simd::load16<false>(src + 8), dst))
+				{
+					src += 16;
+					dst += 16;
+					continue;
+				}
+#endif
+				*dst++ = static_cast<char8_t>(c);
+				++src;
+				continue;
+			}
+			const auto &slot = table.slots[(c * table.multiplier) >> (32 - single_byte_hash_bits)];
+			if (slot.code_point != c)
+			{
+				break;
+			}
+			*dst++ = slot.byte;
+			++src;
+		}
+		return static_cast<std::size_t>(src - first);
+	}
+}
+
+#if defined SIMPLE_CODECVT_TARGET_ISA && defined __clang__
+#pragma clang attribute pop
+#elif defined SIMPLE_CODECVT_TARGET_ISA && defined __GNUC__
+#pragma GCC pop_options
+#endif
+
+#endif // __SIMPLE_CODECVT_UTF_KERNELS_H__